@@ -1,6 +1,14 @@
+#define _GNU_SOURCE //mremap
 #include "BIBLIO_PROJET_OS.h"
 #include <string.h>
-int fd;
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
 /*************************************HELPERS********************************/
 
 
@@ -10,915 +18,7371 @@ int fd;
  * Les fonctions suivantes permettent d'effectuer les opérations : formattage d'une partition, la création, la lecture / écriture, la recherche d’informations dans un fichier ainsi que sa destruction.. ainsi que d'autres fonctions secondaires telles que : allocation de blocs, recherche de l'offset d'un bloc de données dans la partition, effectuer une recherche dichotomique dans le tableau d'index, insertion triée ...etc
  */
 
+/*********************************************************************
+ |       		INSTRUMENTATION		|
+ ********************************************************************/
+
+static unsigned long generationsMontage = 0; //le dernier identifiant de montage attribué (voir chargerPartition)
+static __thread statsThread* statsCourantes = NULL; //les compteurs du thread pour le montage generationCourante
+static __thread unsigned long generationCourante = 0;
+static __thread statsThread statsPerdues; //reçoit les comptes quand les compteurs du thread n'ont pu être alloués
+static __thread statsES statsAvantOperation; //les compteurs du thread au début de l'opération sur un descripteur
+static __thread long sautsAvantChrono; //les sauts de chaîne du thread au début de l'opération chronométrée
+
+static const char* nomsOperationsTracees[NB_OPERATIONS_TRACEES] = {"myOpen", "myRead", "myWrite", "mySeek"};
+
 /**
- * @brief Alloue un bloc de données.
+ * @brief Renvoie les compteurs et histogrammes du thread appelant pour une partition (créés à sa première opération).
  *
- * Cette fonction initialise un buffer de données et le retourne en sortie.
- * Le champ suiv est initialisé à -1 pour indiquer qu'il n'y a pas de bloc suivant.
- * Le champ nbChars est initialisé à 0.
- * Le tableau de données est initialisé avec des caractères nuls.
+ * Le thread mémorise les derniers compteurs utilisés : le cas courant ne coûte qu'une comparaison,
+ * sans verrou.
  *
- * @return Le bloc de données initialisé.
+ * @param p La partition montée.
+ * @return Les compteurs du thread.
  */
-blocData alloc_bloc() {
-    struct blocData buf;
-    buf.suiv = -1;
-    buf.nbChars = 0;
-
-    for (int i = 0; i < max_chars_par_bloc; i++) {
-        buf.donnee[i] = '\0';
+static statsThread* compteursDuThread(partition* p) {
+    if (generationCourante == p->generation)
+        return statsCourantes;
+
+    pthread_mutex_lock(&p->verrouStats);
+    statsThread* t = p->statsThreads;
+    while (t != NULL && t->proprietaire != &generationCourante)
+        t = t->suivant;
+    if (t == NULL && (t = calloc(1, sizeof(statsThread))) != NULL) {
+        t->proprietaire = &generationCourante;
+        t->suivant = p->statsThreads;
+        p->statsThreads = t;
     }
-
-    return buf;
+    pthread_mutex_unlock(&p->verrouStats);
+    if (t == NULL)
+        return &statsPerdues;
+    statsCourantes = t;
+    generationCourante = p->generation;
+    return t;
 }
 
 
-
 /**
- * @brief Initialise une structure blocIndex.
- * @return La structure blocIndex initialisée.
+ * @brief Renvoie les compteurs du thread appelant pour une partition (voir compteursDuThread).
  */
-blocIndex init_blocIndex() {
-    blocIndex bi;
-
-    bi.nbFichiers=0;
+static statsES* statsDuThread(partition* p) {
+    return &compteursDuThread(p)->compteurs;
 }
 
 
- /**
- * @brief Vérifie si une structure blocData est pleine.
- *
- * Cette fonction vérifie si tous les éléments de la structure blocData sont remplis.
+/**
+ * @brief Ajoute n à un compteur du thread appelant.
  *
- * @param blocData La structure blocData à vérifier.
- * @return 1 si la structure est pleine, 0 sinon.
+ * Seul le thread propriétaire modifie le compteur ; l'écriture est atomique pour que myStats puisse
+ * le lire depuis un autre thread.
  */
-int estPleinBlocData(blocData* bloc){
-    return bloc->nbChars == max_chars_par_bloc;
+static void compter(long* compteur, long n) {
+    __atomic_store_n(compteur, *compteur + n, __ATOMIC_RELAXED);
 }
 
 
 /**
- * @brief Trouve le bloc de données à partir d'une position dans le fichier.
- *
- * Cette fonction calcule le bloc de données (utile pour écrire/lire) en utilisant la position actuelle et le nombre maximum de caractères par bloc.
- *
- * @param positionActuelle La position actuelle dans le fichier.
- * @param nbCharMaxParBloc Le nombre maximum de caractères par bloc.
- * @return Le bloc de données concerné par la position "positionActuelle".
+ * @brief Mémorise les compteurs du thread au début d'une opération sur un descripteur.
  */
-int trouverBlocData(int positionActuelle, int nbCharMaxParBloc){
-    return (positionActuelle / nbCharMaxParBloc) + 1;
+static void debuterInstrumentation(file* f) {
+    statsAvantOperation = *statsDuThread(f->part);
 }
 
 
 /**
- * @brief Trouve la position relative dans le tableau de données à partir de la position actuelle dans le fichier.
- *
- * Cette fonction calcule la position relative dans le tableau de données en utilisant
- * la position actuelle et le nombre maximum de caractères par bloc.
- *
- * @param positionActuelle La position actuelle dans le bloc de caractères.
- * @param nbCharMaxParBloc Le nombre maximum de caractères par bloc.
- * @return La position d'insertion dans le bloc de caractères.
+ * @brief Ajoute aux compteurs d'un descripteur ce que le thread a compté depuis debuterInstrumentation.
  */
-int trouverPosition(int positionActuelle, int nbCharMaxParBloc){
-    return positionActuelle % nbCharMaxParBloc;  
+static void terminerInstrumentation(file* f) {
+    long* apres = (long*)statsDuThread(f->part);
+    long* avant = (long*)&statsAvantOperation;
+    long* cumul = (long*)&f->stats;
+    for (size_t k = 0; k < sizeof(statsES) / sizeof(long); k++)
+        cumul[k] += apres[k] - avant[k];
 }
 
+
+static long horlogeNs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long)t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+
 /**
- * @brief Trouve l'offset dans la partition du bloc numero blocNumber d'un fichier f.
- *
- * Cette fonction renvoie l'offset dans la partition du bloc
- * numero blocNumber d'un fichier f donné.
+ * @brief Renvoie la case d'un histogramme log-linéaire correspondant à une latence.
  *
- * @param f Pointeur vers le fichier.
- * @param blocNumber numéro du bloc du fichier.
- * @return L'offset du bloc dans la partition.
+ * Les latences inférieures à 2^PRECISION_HISTOGRAMME ns ont chacune leur case ; au-delà, chaque
+ * puissance de 2 est découpée en 2^PRECISION_HISTOGRAMME cases selon les bits qui suivent le bit de poids fort.
  */
-off_t trouveOffsetBlocFile(file* f, int blocNumber){
-    off_t offsetBloc = f->numEntete;
-    blocEntete be;
-    blocData bd;
+static int caseHistogramme(long duree) {
+    if (duree < (1L << PRECISION_HISTOGRAMME))
+        return duree < 0 ? 0 : (int)duree;
+    int exposant = 63 - __builtin_clzl(duree);
+    int i = (exposant - PRECISION_HISTOGRAMME + 1) * (1 << PRECISION_HISTOGRAMME)
+          + (int)((duree >> (exposant - PRECISION_HISTOGRAMME)) & ((1 << PRECISION_HISTOGRAMME) - 1));
+    return i < NB_CASES_HISTOGRAMME ? i : NB_CASES_HISTOGRAMME - 1;
+}
 
 
-    //lecture de l'entete
-    if (lseek(f->fd, offsetBloc, SEEK_SET)==-1) return ERROR_LSEEK;
-    if (read(f->fd, &be, sizeof(struct blocEntete))==-1) return ERROR_READ;
-    //lecture du nombre de blocs du fichier "f"
-    int nbBlocs = be.nbBlocs;
+/**
+ * @brief Renvoie la plus grande latence (ns) d'une case d'histogramme (voir caseHistogramme).
+ */
+static long borneCase(int i) {
+    if (i < (1 << PRECISION_HISTOGRAMME))
+        return i;
+    int exposant = i / (1 << PRECISION_HISTOGRAMME) + PRECISION_HISTOGRAMME - 1;
+    long sousCase = (1 << PRECISION_HISTOGRAMME) + i % (1 << PRECISION_HISTOGRAMME);
+    return ((sousCase + 1) << (exposant - PRECISION_HISTOGRAMME)) - 1;
+}
 
 
-    //cas ou le numero du bloc depasse le nombre de blocs actuel du fichier
-    if (nbBlocs<blocNumber) {
-        //calculer le nombre de blocs supplementaires
-        blocNumber=blocNumber-nbBlocs;
-        //se deplacer de blocNumber blocDATAs depuis la fin de la partition
-        offsetBloc=lseek(f->fd, (blocNumber-1)*sizeof(struct blocData), SEEK_END);
-        if (offsetBloc==-1) return ERROR_LSEEK;
-        //renvoyer l'offset
-        return offsetBloc;
-    }
+/**
+ * @brief Débute le chronométrage d'une opération publique si la trace de la partition est active.
+ *
+ * @param p La partition (NULL : pas de chronométrage).
+ * @return L'instant du début (ns), 0 si l'opération n'est pas chronométrée.
+ */
+static long debuterChrono(partition* p) {
+    if (p == NULL || !__atomic_load_n(&p->trace.actif, __ATOMIC_RELAXED))
+        return 0;
+    sautsAvantChrono = statsDuThread(p)->sautsChaine;
+    return horlogeNs();
+}
 
-    //SINON il existe un bloc tq numBloc = blocNumber => parcours sequentiel jusqu'à l'arrivée au bloc
-    //1- lecture de la tete de laliste (premier bloc data)
-    offsetBloc=be.numTete;
-    if (lseek(f->fd, offsetBloc, SEEK_SET)==-1) return ERROR_LSEEK;
-    if (read(f->fd, &bd, sizeof(struct blocData))==-1) return ERROR_READ;
-    //on a lu 1 bloc (le 1er) => decrementer le nombre de bocs restants à parcourrir:
-    blocNumber--;
-    int i=1;
-    //parcours sequentiel de la liste chainée
-    while (blocNumber>0) {
-    i++;
-        blocNumber--;
-        //lire le bloc suivant
-        offsetBloc=lseek(f->fd, bd.suiv, SEEK_SET);
-        if (offsetBloc==-1) return ERROR_LSEEK;
-        read(f->fd, &bd, sizeof(struct blocData));
-    }
-
-    //renvoyer l'offset
-    return offsetBloc;
 
+/**
+ * @brief Ajoute une opération au tas des opérations les plus lentes (elle remplace la plus rapide si le tas est plein).
+ */
+static void ajouterLente(partition* p, evenementTrace* e) {
+    traceLatences* t = &p->trace;
+    pthread_mutex_lock(&t->verrou);
+    int i = -1;
+    if (t->nbLentes < t->capacite) {
+        //remontée depuis la dernière feuille
+        i = t->nbLentes++;
+        while (i > 0 && t->lentes[(i - 1) / 2].duree > e->duree) {
+            t->lentes[i] = t->lentes[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+    } else if (t->capacite > 0 && e->duree > t->lentes[0].duree) {
+        //descente depuis la racine, qui est remplacée
+        i = 0;
+        while (2 * i + 1 < t->nbLentes) {
+            int fils = 2 * i + 1;
+            if (fils + 1 < t->nbLentes && t->lentes[fils + 1].duree < t->lentes[fils].duree) fils++;
+            if (t->lentes[fils].duree >= e->duree) break;
+            t->lentes[i] = t->lentes[fils];
+            i = fils;
+        }
+    }
+    if (i >= 0) t->lentes[i] = *e;
+    if (t->capacite > 0 && t->nbLentes == t->capacite)
+        __atomic_store_n(&t->seuil, t->lentes[0].duree, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&t->verrou);
 }
 
 
 /**
- * @brief Renvoie la position du dernier caractère dans le fichier.
+ * @brief Termine le chronométrage d'une opération publique (voir debuterChrono).
  *
- * Cette fonction parcourt le fichier à partir de l'entête jusqu'au dernier bloc de données.
- * Elle renvoie la position du dernier caractère non vide (différent de '\0') dans le fichier.
+ * La latence est ajoutée à l'histogramme du thread ; une opération plus lente que les opérations
+ * conservées est ajoutée au tas des plus lentes, avec les sauts de chaîne qu'elle a faits.
  *
- * @param f Le pointeur vers la structure de fichier.
- * @return La position du dernier caractère dans le fichier.
- *         Si une erreur se produit lors de la lecture ou du déplacement dans le fichier, la fonction renvoie une valeur d'erreur.
+ * @param p La partition.
+ * @param operation L'opération (TRACE_OPEN, TRACE_READ, TRACE_WRITE ou TRACE_SEEK).
+ * @param debut La valeur renvoyée par debuterChrono.
+ * @param resultat Le résultat de l'opération.
  */
-int getPosLastCharFile(file* f){
-    off_t offsetBloc = f->numEntete;
-    blocEntete be;
-    blocData bd;
-
+static void terminerChrono(partition* p, int operation, long debut, long resultat) {
+    if (debut == 0)
+        return;
+    long duree = horlogeNs() - debut;
+    statsThread* t = compteursDuThread(p);
+    histogrammeLatences* h = &t->histogrammes[operation];
+    compter(&h->nb, 1);
+    compter(&h->total, duree);
+    compter(&h->cases[caseHistogramme(duree)], 1);
+    if (duree > h->max) __atomic_store_n(&h->max, duree, __ATOMIC_RELAXED);
+
+    if (duree > __atomic_load_n(&p->trace.seuil, __ATOMIC_RELAXED)) {
+        evenementTrace e = {operation, debut - p->trace.origine, duree, t->compteurs.sautsChaine - sautsAvantChrono,
+                            resultat, syscall(SYS_gettid)};
+        ajouterLente(p, &e);
+    }
+}
 
-    //lecture de l'entete
-    lseek(f->fd, offsetBloc, SEEK_SET);
-    if (read(f->fd, &be, sizeof(struct blocEntete))==-1) return ERROR_READ;
-    //lecture du nombre de blocs du fichier "f"
-    int nbBlocs = be.nbBlocs;
-    //cas fichier vide : seek_end = debut fichier
-    if (nbBlocs==0) return 0;
-    // sinon :
-
-    //parcours jusqu'au dernier bloc :
-    ///// pour les blocs intermediaires : cumuler max_char_par_bloc avec "pos" precedant
-    ///// pour le dernier bloc : parcourir (avec var i) jusqu'à avoir trouver bd.nbChar caractères differents du '\0' ---- renvoyer pos+i+1
-
-    //aller vers premier bloc
-    //1- lecture de la tete de laliste (premier bloc data)
-    offsetBloc=be.numTete;
-    if (lseek(f->fd, offsetBloc, SEEK_SET)==-1) return ERROR_LSEEK;
-    if (read(f->fd, &bd, sizeof(struct blocData))==-1) return ERROR_READ;
-    int pos=0; //variable contenant le cumul
-    //parcours
-    while (bd.suiv!=-1) {
-        pos = pos + max_chars_par_bloc;
-        //lire bloc suivant
-        lseek(f->fd,bd.suiv,SEEK_SET);
-        if (read(f->fd,&bd,sizeof(blocData))==-1) return ERROR_READ;
-    }
-    //en sortie on est sur le dernier bloc === parcourrir
-    int count = 0;
-    int i=0; //pour parcourir le tableau "donnee"
-    while (count<bd.nbChars){
-        if (bd.donnee[i]!='\0') count++;
-        i++; //aller vers caractère suivant (case suivante de donnee)
-    }
-    pos = pos + i;
-    return pos;
-}
-/******************blocIndex helpers*****************/
+/*********************************************************************
+ |       		ENTREES / SORTIES SUR LA PARTITION		|
+ ********************************************************************/
 
 /**
- * @brief Effectue une recherche dichotomique dans un tableau trié d'éléments de type elemTabIndex.
+ * @brief Agrandit la projection en mémoire d'une partition (mode BACKEND_MMAP).
  *
- * @param tableau Le tableau dans lequel effectuer la recherche.
- * @param taille La taille du tableau.
- * @param nomFichier Le nom du fichier à rechercher.
- * @return L'indice de l'élément correspondant au fichier recherché s'il est trouvé, -1 sinon.
+ * La partition est agrandie (ftruncate) puis la projection étendue (mremap) par pas de
+ * PAS_PROJECTION octets, afin que les écritures en fin de partition ne remappent que rarement.
+ * Rien n'est fait si un autre thread l'a déjà agrandie assez.
+ *
+ * @param p La partition montée.
+ * @param taille La taille minimale que doit couvrir la projection.
+ * @return 0 en cas de succès, ERROR_WRITE sinon.
  */
-int rechercheDichotomique(elemTabIndex tableau[NB_FILES_MAX], int taille, char* nomFichier) {
-    int debut = 0;
-    int fin = taille - 1;
-
-    while (debut <= fin) {
-        int milieu = (debut + fin) / 2;
-        int cmp = strcmp(tableau[milieu].nomFichier, nomFichier);
+static int agrandirProjection(partition* p, off_t taille) {
+    off_t nouvelleTaille = (taille + PAS_PROJECTION - 1) / PAS_PROJECTION * PAS_PROJECTION;
 
-        if (cmp < 0)
-            debut = milieu + 1;
-        else if (cmp > 0)
-            fin = milieu - 1;
-        else
-            return milieu; // Le fichier a été trouvé
+    //la projection peut être déplacée : aucun accès ne doit être en cours dans l'ancienne
+    pthread_rwlock_wrlock(&p->verrouProjection);
+    if (taille <= p->tailleProjection) {
+        pthread_rwlock_unlock(&p->verrouProjection);
+        return 0;
     }
-
-    return -1; // Le fichier n'a pas été trouvé
+    compter(&statsDuThread(p)->autresAppels, 2);
+    if (ftruncate(p->fd, nouvelleTaille) == -1) {
+        pthread_rwlock_unlock(&p->verrouProjection);
+        return ERROR_WRITE;
+    }
+    char* projection = mremap(p->projection, p->tailleProjection, nouvelleTaille, MREMAP_MAYMOVE);
+    if (projection != MAP_FAILED) {
+        p->projection = projection;
+        p->tailleProjection = nouvelleTaille;
+    }
+    pthread_rwlock_unlock(&p->verrouProjection);
+    return projection == MAP_FAILED ? ERROR_WRITE : 0;
 }
 
 
 /**
- * @brief Insère un élément dans un tableau trié en fonction du nom de fichier.
+ * @brief Prend le verrou de la projection en lecture, après l'avoir agrandie au besoin pour qu'elle couvre taille octets.
  *
- * @param tableau Le tableau trié.
- * @param taille La taille actuelle du tableau.
- * @param element L'élément à insérer.
- * @return La position d'insertion de l'élément dans le tableau.
+ * @param p La partition montée (BACKEND_MMAP).
+ * @param taille La taille que doit couvrir la projection.
+ * @return 0 en cas de succès (le verrou est pris), ERROR_WRITE sinon.
  */
-int insertionTableauTrie(elemTabIndex* tableau, int taille, elemTabIndex element) {
-    int i = taille - 1;
-
-    while (i >= 0 && strcmp(tableau[i].nomFichier, element.nomFichier) > 0) {
-        tableau[i + 1] = tableau[i];
-        i--;
+static int couvrirProjection(partition* p, off_t taille) {
+    pthread_rwlock_rdlock(&p->verrouProjection);
+    while (taille > p->tailleProjection) {
+        pthread_rwlock_unlock(&p->verrouProjection);
+        if (agrandirProjection(p, taille) < 0) return ERROR_WRITE;
+        pthread_rwlock_rdlock(&p->verrouProjection);
     }
+    return 0;
+}
 
-    tableau[i + 1] = element;
 
-    return i+1; //pos insertion
+/**
+ * @brief Synchronise la projection avec le support (msync) ; sans effet pour une partition non projetée.
+ *
+ * @return 0 en cas de succès, -1 sinon.
+ */
+static int synchroniserProjection(partition* p) {
+    if (p->projection == NULL)
+        return 0;
+    pthread_rwlock_rdlock(&p->verrouProjection);
+    int ret = msync(p->projection, p->tailleProjection, MS_SYNC);
+    pthread_rwlock_unlock(&p->verrouProjection);
+    return ret;
 }
 
-/*********************************************************************
- |       		FONCTIONS DE MANIPULATION D'ENTETE		|
- ********************************************************************/
-
- /****************************PRECONDITION: Partition formatée (appel effectué à myFormat)*****************************************/
- /*****************************************GETTERS********************************************/
 
 /**
- * \brief Récupère le nombre de blocs d'un fichier.
+ * @brief Renvoie l'adresse en mémoire d'une zone de la partition (mode BACKEND_MMAP).
  *
- * Cette fonction retourne le nombre de blocs d'un fichier spécifié par le pointeur \p f.
+ * Permet de déréférencer directement les structures de la partition sans appel système.
+ * L'adresse n'est valable que sous le verrou de la projection (pris en lecture).
  *
- * \param f Le pointeur vers la structure de fichier.
- * \return Le nombre de blocs du fichier.
- *         En cas d'erreur, la fonction retourne ERROR_OTHER si \p f est NULL,
- *         ERROR_LSEEK si une erreur s'est produite lors du déplacement vers le début du fichier,
- *         ou ERROR_READ si une erreur s'est produite lors de la lecture du bloc d'entête.
+ * @param p La partition montée.
+ * @param offset L'offset de la zone dans la partition.
+ * @param taille La taille de la zone.
+ * @return L'adresse de la zone, NULL si la partition n'est pas projetée ou si la zone dépasse la projection.
  */
-int getNbBlocsFile(file* f) { //fd: descripteur de fichier
-
-    if (f == NULL)
-        return ERROR_OTHER;
+void* adressePartition(partition* p, off_t offset, size_t taille) {
+    if (p->backend != BACKEND_MMAP || offset < 0 || offset + (off_t)taille > p->tailleProjection)
+        return NULL;
+    return p->projection + offset;
+}
 
-    blocEntete buff;
 
-    off_t numEntete = f->numEntete; //recuperer l'offset vers l'entete du fichier depuis le debut de la partition
+/**
+ * @brief Lit une zone du support de la partition, sans passer par le cache de blocs.
+ *
+ * En mode BACKEND_RW la lecture est un pread (répété en cas de lecture partielle, la partie
+ * au-delà de la fin du fichier est lue comme des zéros) ; en mode BACKEND_MMAP c'est une copie
+ * depuis la projection (la partie au-delà de la projection est lue comme des zéros).
+ *
+ * @param p La partition montée.
+ * @param buffer Le tampon recevant les données.
+ * @param taille Le nombre d'octets à lire.
+ * @param offset L'offset de la zone dans la partition.
+ * @return Le nombre d'octets lus, -1 en cas d'erreur.
+ */
+ssize_t lireStockage(partition* p, void* buffer, size_t taille, off_t offset) {
+    if (p->backend == BACKEND_RW) {
+        size_t lus = 0;
+        while (lus < taille) {
+            ssize_t n = pread(p->fd, (char*)buffer + lus, taille - lus, offset + lus);
+            compter(&statsDuThread(p)->lectures, 1);
+            if (n == -1) return -1;
+            if (n == 0) break;
+            lus += n;
+        }
+        compter(&statsDuThread(p)->octetsLus, lus);
+        memset((char*)buffer + lus, 0, taille - lus);
+        return taille;
+    }
 
+    pthread_rwlock_rdlock(&p->verrouProjection);
+    size_t disponible = offset >= p->tailleProjection ? 0 : p->tailleProjection - offset;
+    size_t n = taille < disponible ? taille : disponible;
+    memcpy(buffer, p->projection + offset, n);
+    pthread_rwlock_unlock(&p->verrouProjection);
+    compter(&statsDuThread(p)->octetsLus, n);
+    memset((char*)buffer + n, 0, taille - n);
+    return taille;
+}
 
-    //se deplacer vers le debut du fichier
-    if (lseek(f->fd, numEntete, SEEK_SET) == -1)
-        return ERROR_LSEEK;
 
-    // Lire le bloc d'entete du fichier
-    if (read(f->fd, &buff, sizeof(struct blocEntete)) == -1)
-        return ERROR_READ;
+/**
+ * @brief Écrit une zone du support de la partition, sans passer par le cache de blocs.
+ *
+ * En mode BACKEND_RW l'écriture est un pwrite ; en mode BACKEND_MMAP c'est une copie vers
+ * la projection, agrandie au besoin (voir agrandirProjection).
+ *
+ * @param p La partition montée.
+ * @param buffer Les données à écrire.
+ * @param taille Le nombre d'octets à écrire.
+ * @param offset L'offset de la zone dans la partition.
+ * @return Le nombre d'octets écrits, -1 en cas d'erreur.
+ */
+ssize_t ecrireStockage(partition* p, const void* buffer, size_t taille, off_t offset) {
+    statsES* s = statsDuThread(p);
+    if (p->backend == BACKEND_RW) {
+        ssize_t n = pwrite(p->fd, buffer, taille, offset);
+        compter(&s->ecritures, 1);
+        if (n > 0) compter(&s->octetsEcrits, n);
+        return n;
+    }
 
-	//à la sortie, f pointe vers le bloc suivant
-    return buff.nbBlocs; //nombre de blocs du fichier
+    if (couvrirProjection(p, offset + taille) < 0)
+        return -1;
+    memcpy(p->projection + offset, buffer, taille);
+    pthread_rwlock_unlock(&p->verrouProjection);
+    compter(&s->octetsEcrits, taille);
+    return taille;
 }
 
 
 /**
- * \brief Récupère l'offset vers le premier bloc de données du fichier.
+ * @brief Copie une zone du support de la partition vers une autre, sans passer par le cache de blocs.
  *
- * Cette fonction retourne le nombre de blocs d'un fichier spécifié par le pointeur \p f.
+ * En mode BACKEND_RW la copie est faite par le noyau (copy_file_range sur le descripteur de la
+ * partition), sans transiter par la mémoire du processus ; si le système de fichiers ne le permet
+ * pas, elle se replie sur des pread / pwrite par morceaux. En mode BACKEND_MMAP c'est une copie
+ * mémoire dans la projection, agrandie au besoin. Les deux zones ne doivent pas se chevaucher.
  *
- * \param f Le pointeur vers la structure de fichier.
- * \return L'offset vers le premier bloc de données.
- *         En cas d'erreur, la fonction retourne ERROR_OTHER si \p f est NULL,
- *         ERROR_LSEEK si une erreur s'est produite lors du déplacement evrs bloc d'entete,
- *         ou ERROR_READ si une erreur s'est produite lors de la lecture du bloc d'entête.
+ * @param p La partition montée.
+ * @param source L'offset de la zone à copier.
+ * @param destination L'offset de la zone recevant la copie.
+ * @param taille Le nombre d'octets à copier.
+ * @return Le nombre d'octets copiés, -1 en cas d'erreur.
  */
-off_t getNumTeteFile(file* f) { //fd descripteur de fichier
+ssize_t copierStockage(partition* p, off_t source, off_t destination, size_t taille) {
+    if (p->backend == BACKEND_MMAP) {
+        if (couvrirProjection(p, destination + taille) < 0)
+            return -1;
+        //la source peut se trouver au-delà de la fin de la projection (lue comme des zéros)
+        size_t disponible = source >= p->tailleProjection ? 0 : p->tailleProjection - source;
+        size_t n = taille < disponible ? taille : disponible;
+        memcpy(p->projection + destination, p->projection + source, n);
+        memset(p->projection + destination + n, 0, taille - n);
+        pthread_rwlock_unlock(&p->verrouProjection);
+        compter(&statsDuThread(p)->octetsCopies, taille);
+        return taille;
+    }
 
+    size_t copies = 0;
+    errno = 0;
+    while (copies < taille) {
+        off_t de = source + copies;
+        off_t vers = destination + copies;
+        ssize_t n = copy_file_range(p->fd, &de, p->fd, &vers, taille - copies, 0);
+        compter(&statsDuThread(p)->copies, 1);
+        if (n <= 0) break;
+        copies += n;
+    }
+    compter(&statsDuThread(p)->octetsCopies, copies);
+    if (copies == taille)
+        return taille;
+    if (errno != 0 && errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP)
+        return -1;
+
+    //repli (ou fin de partition atteinte) : copie par un tampon intermédiaire
+    size_t tailleTampon = taille - copies < ((size_t)1 << 20) ? taille - copies : ((size_t)1 << 20);
+    char* tampon = malloc(tailleTampon);
+    if (tampon == NULL) return -1;
+    while (copies < taille) {
+        size_t n = taille - copies < tailleTampon ? taille - copies : tailleTampon;
+        if (lireStockage(p, tampon, n, source + copies) == -1 ||
+            ecrireStockage(p, tampon, n, destination + copies) != (ssize_t)n) {
+            free(tampon);
+            return -1;
+        }
+        copies += n;
+    }
+    free(tampon);
+    return taille;
+}
 
-    if (f == NULL)
-        return ERROR_OTHER;
+/******************cache de blocs helpers*****************/
+
+/**
+ * @brief Renvoie le segment du cache de blocs qui contient (ou contiendrait) une unité.
+ */
+static segmentCache* segmentDe(cacheBlocs* c, off_t unite) {
+    return &c->segments[unite & (c->nbSegments - 1)];
+}
 
 
-    blocEntete buff;
+/**
+ * @brief Renvoie l'indice de l'emplacement d'un segment contenant une unité, -1 si elle n'y est pas.
+ * Le verrou du segment doit être pris.
+ */
+static int chercherEmplacement(partition* p, segmentCache* s, off_t unite) {
+    int i = s->tableHachage[(unite / p->cache.nbSegments) & s->masqueHachage];
+    while (i != -1 && s->emplacements[i].unite != unite)
+        i = s->emplacements[i].suivant;
+    return i;
+}
 
 
-    off_t numEntete = f->numEntete; //recuperer l'offset vers l'entete du fichier depuis le debut de la partition
+/**
+ * @brief Retire un emplacement de la table de hachage de son segment et le marque libre.
+ */
+static void retirerEmplacement(partition* p, segmentCache* s, int i) {
+    int* lien = &s->tableHachage[(s->emplacements[i].unite / p->cache.nbSegments) & s->masqueHachage];
+    while (*lien != i)
+        lien = &s->emplacements[*lien].suivant;
+    *lien = s->emplacements[i].suivant;
+    s->emplacements[i].unite = -1;
+    s->emplacements[i].modifie = false;
+    s->emplacements[i].etat = EMPLACEMENT_PRET;
+}
 
 
-    //se deplacer vers le debut du fichier
-    if (lseek(f->fd, numEntete, SEEK_SET) == -1)
-        return ERROR_LSEEK;
+/**
+ * @brief Réserve un emplacement d'un segment pour une unité absente du cache.
+ *
+ * Un emplacement est choisi par l'algorithme de l'horloge (CLOCK) : l'aiguille passe les
+ * emplacements récemment utilisés en effaçant leur bit de référence et s'arrête sur le premier
+ * emplacement non référencé (et sans entrée / sortie en cours). S'il a été modifié, son contenu est
+ * réécrit hors du verrou, puis la réservation est à recommencer : l'unité a pu être placée
+ * entre-temps par un autre thread. Le verrou du segment doit être pris ; il l'est au retour.
+ *
+ * @param p La partition montée.
+ * @param s Le segment de l'unité.
+ * @param unite L'unité à placer.
+ * @param attendre Vrai pour attendre la fin d'une entrée / sortie si tous les emplacements sont occupés.
+ * @param indice L'emplacement réservé (EMPLACEMENT_PRET, non modifié, à remplir par l'appelant).
+ * @return 0 si l'emplacement est réservé, 1 si la réservation est à recommencer (ou, sans attente, si
+ * aucun emplacement n'est disponible), ERROR_WRITE en cas d'erreur.
+ */
+static int reserverEmplacement(partition* p, segmentCache* s, off_t unite, bool attendre, int* indice) {
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    //choix de la victime (deux tours : le premier peut n'avoir fait qu'effacer les bits de référence)
+    int i = -1;
+    for (int k = 0; k < 2 * s->nbEmplacements && i == -1; k++) {
+        emplacementCache* e = &s->emplacements[s->aiguille];
+        if (e->etat == EMPLACEMENT_PRET && (e->unite == -1 || !e->reference))
+            i = s->aiguille;
+        else if (e->etat == EMPLACEMENT_PRET)
+            e->reference = false;
+        s->aiguille = (s->aiguille + 1) % s->nbEmplacements;
+    }
+    if (i == -1) {
+        if (attendre)
+            pthread_cond_wait(&s->disponible, &s->verrou);
+        return 1;
+    }
 
-    // Lire le bloc d'entete du fichier
-    if (read(f->fd, &buff, sizeof(struct blocEntete)) == -1)
-        return ERROR_READ;
+    emplacementCache* e = &s->emplacements[i];
+    if (e->unite != -1 && e->modifie) {
+        //réécriture hors du verrou : l'unité reste lisible, ses écrivains attendent
+        e->etat = EMPLACEMENT_ECRITURE;
+        pthread_mutex_unlock(&s->verrou);
+        ssize_t ret = ecrireStockage(p, s->donnees + (off_t)i * tailleBloc, tailleBloc, e->unite * tailleBloc);
+        pthread_mutex_lock(&s->verrou);
+        e->etat = EMPLACEMENT_PRET;
+        if (ret != -1) {
+            e->modifie = false;
+            s->ecritures++;
+        }
+        pthread_cond_broadcast(&s->disponible);
+        return ret == -1 ? ERROR_WRITE : 1;
+    }
+    if (e->unite != -1) {
+        retirerEmplacement(p, s, i);
+        s->evictions++;
+    }
 
-        //à la sortie, l'offset du fichier est sur le 1er bloc data
-    return buff.numTete; //nombre de blocs du fichier
+    e->unite = unite;
+    e->reference = true;
+    e->modifie = false;
+    e->perime = false;
+    e->etat = EMPLACEMENT_PRET;
+    e->suivant = s->tableHachage[(unite / p->cache.nbSegments) & s->masqueHachage];
+    s->tableHachage[(unite / p->cache.nbSegments) & s->masqueHachage] = i;
+    *indice = i;
+    return 0;
 }
 
 
+/**
+ * @brief Renvoie l'emplacement d'une unité, placée dans le cache si elle en est absente.
+ *
+ * Une unité absente est lue sur le support hors du verrou (si charger est vrai). Un emplacement en
+ * cours de lecture est attendu, de même qu'un emplacement en cours de réécriture si l'appelant veut
+ * le modifier. Le verrou du segment doit être pris ; il l'est au retour.
+ *
+ * @param p La partition montée.
+ * @param s Le segment de l'unité.
+ * @param unite L'unité.
+ * @param charger Vrai si le contenu d'une unité absente doit être lu sur le support.
+ * @param modifier Vrai si l'appelant va modifier l'emplacement.
+ * @return L'indice de l'emplacement, une valeur d'erreur sinon.
+ */
+static int obtenirEmplacement(partition* p, segmentCache* s, off_t unite, bool charger, bool modifier) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    bool absente = false;
+
+    while (true) {
+        int i = chercherEmplacement(p, s, unite);
+        if (i != -1) {
+            emplacementCache* e = &s->emplacements[i];
+            if (e->etat == EMPLACEMENT_PRET || (e->etat == EMPLACEMENT_ECRITURE && !modifier)) {
+                if (!absente) {
+                    s->succes++;
+                    compter(&statsDuThread(p)->succesCache, 1);
+                }
+                return i;
+            }
+            pthread_cond_wait(&s->disponible, &s->verrou);
+            continue;
+        }
+        if (!absente) {
+            absente = true;
+            s->echecs++;
+            compter(&statsDuThread(p)->echecsCache, 1);
+        }
+
+        int ret = reserverEmplacement(p, s, unite, true, &i);
+        if (ret < 0) return ret;
+        if (ret == 1) continue;
+        if (!charger)
+            return i;
+
+        emplacementCache* e = &s->emplacements[i];
+        e->etat = EMPLACEMENT_CHARGEMENT;
+        pthread_mutex_unlock(&s->verrou);
+        ssize_t lus = lireStockage(p, s->donnees + (off_t)i * tailleBloc, tailleBloc, unite * tailleBloc);
+        pthread_mutex_lock(&s->verrou);
+        //une écriture directe de l'unité pendant la lecture : elle est relue
+        if (lus == -1 || e->perime)
+            retirerEmplacement(p, s, i);
+        else
+            e->etat = EMPLACEMENT_PRET;
+        pthread_cond_broadcast(&s->disponible);
+        if (lus == -1) return ERROR_READ;
+    }
+}
 
-/****************************PRECONDITION: Partition formatée (appel effectué à myFormat)*****************************************/
-/*******************************************SETTERS*************************************************/
 
 /**
- * @brief Modifie le nombre de blocs d'un fichier.
+ * @brief Configure le cache de blocs d'une partition.
  *
- * Cette fonction permet de modifier le nombre de blocs d'un fichier spécifié.
+ * Le cache est partagé par tous les fichiers de la partition : entêtes, blocs de données, blocs
+ * d'extents, noeuds du répertoire et table des unités libres y passent (le super bloc est toujours
+ * écrit directement). Les unités de tailleBloc octets y sont remplacées selon l'algorithme de
+ * l'horloge et les écritures sont différées (write-back) jusqu'à l'éviction ou viderCache.
+ * Le cache est découpé en au plus NB_SEGMENTS_CACHE segments d'au moins 8 emplacements, chacun
+ * sous son propre verrou (voir segmentCache).
+ * Le cache actuel est vidé puis remplacé. Une partition projetée en mémoire (BACKEND_MMAP)
+ * n'utilise pas de cache.
  *
- * @param f Le pointeur vers la structure de fichier.
- * @param val La nouvelle valeur du nombre de blocs.
+ * @param p La partition montée.
+ * @param budget La mémoire (en octets) allouée aux données du cache, 0 pour désactiver le cache.
  * @return 0 en cas de succès, une valeur d'erreur sinon.
  */
-int setNbBlocsFile(file* f, int val) {
+int configurerCache(partition* p, size_t budget) {
+    cacheBlocs* c = &p->cache;
+    off_t tailleBloc = p->sb.tailleBloc;
 
-    if (f == NULL)
-        return ERROR_OTHER;
+    if (viderCache(p) < 0)
+        return ERROR_WRITE;
+    for (int k = 0; k < c->nbSegments; k++) {
+        segmentCache* s = &c->segments[k];
+        free(s->emplacements);
+        free(s->donnees);
+        free(s->tableHachage);
+        pthread_cond_destroy(&s->disponible);
+        pthread_mutex_destroy(&s->verrou);
+    }
+    free(c->segments);
+    memset(c, 0, sizeof(cacheBlocs));
 
-    blocEntete buff;
+    int nb = (p->backend == BACKEND_MMAP || budget == 0) ? 0 : budget / tailleBloc;
+    if (nb == 0)
+        return 0;
 
-    //se deplacer vers le debut du fichier
-    lseek(f->fd, f->numEntete, SEEK_SET);
+    int nbSegments = NB_SEGMENTS_CACHE;
+    while (nbSegments > 1 && nb / nbSegments < 8) nbSegments /= 2;
+    c->segments = calloc(nbSegments, sizeof(segmentCache));
+    if (c->segments == NULL)
+        return ERROR_OTHER;
+    c->nbSegments = nbSegments;
+    int ret = 0;
+    for (int k = 0; k < nbSegments; k++) {
+        segmentCache* s = &c->segments[k];
+        int nbParSegment = nb / nbSegments + (k < nb % nbSegments);
+        int tailleHachage = 1;
+        while (tailleHachage < 2 * nbParSegment) tailleHachage *= 2;
+        pthread_mutex_init(&s->verrou, NULL);
+        pthread_cond_init(&s->disponible, NULL);
+        s->emplacements = malloc(nbParSegment * sizeof(emplacementCache));
+        s->tableHachage = malloc(tailleHachage * sizeof(int));
+        if (s->emplacements == NULL || s->tableHachage == NULL
+            || posix_memalign((void**)&s->donnees, 4096, (size_t)nbParSegment * tailleBloc) != 0) {
+            ret = ERROR_OTHER;
+            continue;
+        }
+        for (int i = 0; i < nbParSegment; i++) {
+            s->emplacements[i].unite = -1;
+            s->emplacements[i].modifie = false;
+            s->emplacements[i].reference = false;
+            s->emplacements[i].perime = false;
+            s->emplacements[i].etat = EMPLACEMENT_PRET;
+        }
+        for (int i = 0; i < tailleHachage; i++)
+            s->tableHachage[i] = -1;
+        s->masqueHachage = tailleHachage - 1;
+        s->nbEmplacements = nbParSegment;
+    }
+    c->nbEmplacements = nb;
+    if (ret < 0)
+        configurerCache(p, 0);
+    return ret;
+}
 
-    // Lire le bloc d'entete du fichier
-    if (read(f->fd, &buff, sizeof(struct blocEntete)) == -1)
-        return ERROR_READ;
 
-    //modifier le nombre de blocs du fichier
-    buff.nbBlocs = val;
-    //Aller au bloc d'entete pour l'actualiser
-    lseek(f->fd, f->numEntete, SEEK_SET);
-    //actualiser le bloc d'entete
-    if (write(f->fd, &buff, sizeof(struct blocEntete)) == -1)
-        return ERROR_WRITE;
+/**
+ * @brief Emplacement modifié du cache, repéré par son unité (tri de viderCache).
+ */
+typedef struct emplacementModifie{
+    off_t unite;
+    segmentCache* segment;
+    int indice;
+}emplacementModifie;
 
-    return 0; //renvoyer 0 si succés
+
+/**
+ * @brief Compare deux emplacements modifiés selon leur unité (tri de viderCache).
+ */
+static int comparerEmplacements(const void* a, const void* b) {
+    off_t ua = ((const emplacementModifie*)a)->unite, ub = ((const emplacementModifie*)b)->unite;
+    return ua < ub ? -1 : ua > ub;
 }
 
 
 /**
- * @brief Modifie l'offset vers la tête (premier bloc de données) du fichier.
+ * @brief Réécrit sur le support tous les blocs modifiés du cache, dans l'ordre des offsets.
  *
- * Cette fonction modifie l'offset vers la tête du fichier (premier bloc de données) spécifié par le pointeur `f`.
- * L'offset spécifié est donné par le paramètre `val`.
+ * Les unités consécutives sont écrites en un seul appel (pwritev). Les emplacements sont marqués
+ * EMPLACEMENT_ECRITURE le temps de l'écriture, faite hors des verrous des segments : ils restent
+ * lisibles, leurs écrivains attendent. Les réécritures d'éviction en cours sont attendues.
  *
- * @param f Le pointeur vers la structure de fichier.
- * @param val La nouvelle valeur de l'offset vers la tête du fichier.
+ * Les blocs restent dans le cache.
+ *
+ * @param p La partition montée.
  * @return 0 en cas de succès, une valeur d'erreur sinon.
  */
-int setNumTeteFile(file* f, off_t val) {
+int viderCache(partition* p) {
+    cacheBlocs* c = &p->cache;
+    off_t tailleBloc = p->sb.tailleBloc;
 
+    if (c->nbEmplacements == 0)
+        return 0;
+    emplacementModifie* ordre = malloc(c->nbEmplacements * sizeof(emplacementModifie));
+    if (ordre == NULL)
+        return ERROR_OTHER;
+
+    //emplacements à réécrire ; ceux déjà en réécriture (éviction) sont attendus à la fin
+    int n = 0, nbAttendus = 0;
+    emplacementModifie* attendus = ordre + c->nbEmplacements;
+    for (int k = 0; k < c->nbSegments; k++) {
+        segmentCache* s = &c->segments[k];
+        pthread_mutex_lock(&s->verrou);
+        for (int i = 0; i < s->nbEmplacements; i++) {
+            emplacementCache* e = &s->emplacements[i];
+            if (e->etat == EMPLACEMENT_ECRITURE) {
+                attendus--;
+                nbAttendus++;
+                attendus->unite = e->unite;
+                attendus->segment = s;
+                attendus->indice = i;
+            } else if (e->etat == EMPLACEMENT_PRET && e->modifie) {
+                e->etat = EMPLACEMENT_ECRITURE;
+                ordre[n].unite = e->unite;
+                ordre[n].segment = s;
+                ordre[n].indice = i;
+                n++;
+            }
+        }
+        pthread_mutex_unlock(&s->verrou);
+    }
+    qsort(ordre, n, sizeof(emplacementModifie), comparerEmplacements);
+
+    //les unités consécutives sont écrites ensemble (pwritev, au plus IOV_MAX unités)
+    struct iovec iov[IOV_MAX];
+    int ret = 0;
+    int i = 0;
+    while (i < n) {
+        int nb = 1;
+        while (i + nb < n && nb < IOV_MAX && ordre[i + nb].unite == ordre[i].unite + nb) nb++;
+        for (int k = 0; k < nb; k++) {
+            iov[k].iov_base = ordre[i + k].segment->donnees + (off_t)ordre[i + k].indice * tailleBloc;
+            iov[k].iov_len = tailleBloc;
+        }
+        ssize_t ecrits = nb > 1 && ret == 0 ? pwritev(p->fd, iov, nb, ordre[i].unite * tailleBloc) : 0;
+        if (nb > 1 && ret == 0) {
+            compter(&statsDuThread(p)->ecritures, 1);
+            if (ecrits > 0) compter(&statsDuThread(p)->octetsEcrits, ecrits);
+        }
+        for (int k = 0; k < nb; k++) {
+            //écriture partielle ou unité isolée : unité par unité
+            bool ecrite = ecrits >= (off_t)(k + 1) * tailleBloc
+                          || (ret == 0 && ecrireStockage(p, iov[k].iov_base, tailleBloc, ordre[i + k].unite * tailleBloc) != -1);
+            if (!ecrite) ret = ERROR_WRITE;
+            segmentCache* s = ordre[i + k].segment;
+            emplacementCache* e = &s->emplacements[ordre[i + k].indice];
+            pthread_mutex_lock(&s->verrou);
+            e->etat = EMPLACEMENT_PRET;
+            if (ecrite) {
+                e->modifie = false;
+                s->ecritures++;
+            }
+            pthread_cond_broadcast(&s->disponible);
+            pthread_mutex_unlock(&s->verrou);
+        }
+        i += nb;
+    }
+
+    for (int k = 0; k < nbAttendus; k++) {
+        segmentCache* s = attendus[k].segment;
+        emplacementCache* e = &s->emplacements[attendus[k].indice];
+        pthread_mutex_lock(&s->verrou);
+        while (e->etat == EMPLACEMENT_ECRITURE && e->unite == attendus[k].unite)
+            pthread_cond_wait(&s->disponible, &s->verrou);
+        if (e->unite == attendus[k].unite && e->modifie && ret == 0) ret = ERROR_WRITE;
+        pthread_mutex_unlock(&s->verrou);
+    }
+    free(ordre);
+    return ret;
+}
+
+
+/**
+ * @brief Retire du cache, sans les réécrire, les unités d'une zone libérée.
+ *
+ * Une unité en cours de lecture sera relue ; une unité en cours de réécriture est attendue.
+ */
+static void oublierCache(partition* p, off_t debut, off_t nbUnites) {
+    cacheBlocs* c = &p->cache;
+
+    for (off_t u = debut; u < debut + nbUnites && c->nbEmplacements > 0; u++) {
+        segmentCache* s = segmentDe(c, u);
+        pthread_mutex_lock(&s->verrou);
+        int i = chercherEmplacement(p, s, u);
+        while (i != -1 && s->emplacements[i].etat == EMPLACEMENT_ECRITURE) {
+            pthread_cond_wait(&s->disponible, &s->verrou);
+            i = chercherEmplacement(p, s, u);
+        }
+        if (i != -1 && s->emplacements[i].etat == EMPLACEMENT_CHARGEMENT)
+            s->emplacements[i].perime = true;
+        else if (i != -1)
+            retirerEmplacement(p, s, i);
+        pthread_mutex_unlock(&s->verrou);
+    }
+}
+
+
+/**
+ * @brief Indique si une unité est présente dans le cache de blocs.
+ */
+static bool estEnCache(partition* p, off_t unite) {
+    if (p->cache.nbEmplacements == 0)
+        return false;
+    segmentCache* s = segmentDe(&p->cache, unite);
+    pthread_mutex_lock(&s->verrou);
+    bool present = chercherEmplacement(p, s, unite) != -1;
+    pthread_mutex_unlock(&s->verrou);
+    return present;
+}
+
+
+/**
+ * @brief Renvoie les compteurs du cache de blocs d'une partition.
+ *
+ * @param p La partition montée.
+ * @return Les compteurs (succès, échecs, évictions, réécritures et unités préchargées) depuis le montage.
+ */
+statsCache getStatsCache(partition* p) {
+    statsCache st;
+    memset(&st, 0, sizeof(statsCache));
+    for (int k = 0; k < p->cache.nbSegments; k++) {
+        segmentCache* s = &p->cache.segments[k];
+        pthread_mutex_lock(&s->verrou);
+        st.succes += s->succes;
+        st.echecs += s->echecs;
+        st.evictions += s->evictions;
+        st.ecritures += s->ecritures;
+        st.prechargements += s->prechargements;
+        pthread_mutex_unlock(&s->verrou);
+    }
+    return st;
+}
+
+
+/**
+ * @brief Indique au système qu'une zone de la partition sera bientôt lue.
+ *
+ * Le conseil est un posix_fadvise(POSIX_FADV_WILLNEED) sur la partition, ou un
+ * madvise(MADV_WILLNEED) sur la projection en mode BACKEND_MMAP. Le chargement se fait
+ * en arrière-plan, sans attendre.
+ *
+ * @param p La partition montée.
+ * @param offset L'offset de la zone dans la partition.
+ * @param taille La taille de la zone, en octets.
+ */
+void conseillerPartition(partition* p, off_t offset, size_t taille) {
+    compter(&statsDuThread(p)->autresAppels, 1);
+    if (p->backend == BACKEND_RW) {
+        posix_fadvise(p->fd, offset, taille, POSIX_FADV_WILLNEED);
+        return;
+    }
+    pthread_rwlock_rdlock(&p->verrouProjection);
+    if (offset < p->tailleProjection) {
+        //madvise attend une adresse alignée sur une page
+        off_t page = sysconf(_SC_PAGESIZE);
+        off_t debut = offset / page * page;
+        off_t fin = offset + (off_t)taille < p->tailleProjection ? offset + (off_t)taille : p->tailleProjection;
+        madvise(p->projection + debut, fin - debut, MADV_WILLNEED);
+    }
+    pthread_rwlock_unlock(&p->verrouProjection);
+}
+
+
+/**
+ * @brief Charge dans le cache les unités absentes d'une zone (voir prechargerPartition).
+ */
+static int chargerEmplacements(partition* p, off_t offset, size_t taille) {
+    cacheBlocs* c = &p->cache;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    off_t unite = offset / tailleBloc;
+    off_t fin = (offset + (off_t)taille + tailleBloc - 1) / tailleBloc;
+    if (fin - unite > c->nbEmplacements / 4)
+        fin = unite + c->nbEmplacements / 4;
+
+    struct iovec iov[MAX_BLOCS_ANTICIPES];
+    segmentCache* segments[MAX_BLOCS_ANTICIPES];
+    int indices[MAX_BLOCS_ANTICIPES];
+    while (unite < fin) {
+        //zone d'unités absentes, réservées sans être lues (une unité présente, ou sans emplacement disponible, la termine)
+        off_t debut = unite;
+        int n = 0;
+        int ret = 0;
+        while (unite < fin && n < MAX_BLOCS_ANTICIPES) {
+            segmentCache* s = segmentDe(c, unite);
+            pthread_mutex_lock(&s->verrou);
+            int i = -1;
+            ret = chercherEmplacement(p, s, unite) != -1 ? 1 : reserverEmplacement(p, s, unite, false, &i);
+            if (ret != 0) {
+                pthread_mutex_unlock(&s->verrou);
+                break;
+            }
+            s->emplacements[i].etat = EMPLACEMENT_CHARGEMENT;
+            pthread_mutex_unlock(&s->verrou);
+            segments[n] = s;
+            indices[n] = i;
+            iov[n].iov_base = s->donnees + (off_t)i * tailleBloc;
+            iov[n].iov_len = tailleBloc;
+            n++;
+            unite++;
+        }
+        if (n == 0 && ret >= 0) {
+            unite++;
+            continue;
+        }
+
+        ssize_t lus = n == 0 ? -1 : preadv(p->fd, iov, n, debut * tailleBloc);
+        if (n > 0) compter(&statsDuThread(p)->lectures, 1);
+        if (lus > 0) compter(&statsDuThread(p)->octetsLus, lus);
+        //lecture partielle : le reste de chaque unité est lu séparément (zéros au-delà de la fin)
+        for (int k = 0; k < n && lus != -1; k++) {
+            off_t couverts = lus - (off_t)k * tailleBloc;
+            if (couverts < 0) couverts = 0;
+            if (couverts < tailleBloc
+                && lireStockage(p, (char*)iov[k].iov_base + couverts, tailleBloc - couverts, (debut + k) * tailleBloc + couverts) == -1)
+                lus = -1;
+        }
+        for (int k = 0; k < n; k++) {
+            segmentCache* s = segments[k];
+            emplacementCache* e = &s->emplacements[indices[k]];
+            pthread_mutex_lock(&s->verrou);
+            if (lus == -1 || e->perime) {
+                retirerEmplacement(p, s, indices[k]);
+            } else {
+                e->etat = EMPLACEMENT_PRET;
+                s->prechargements++;
+            }
+            pthread_cond_broadcast(&s->disponible);
+            pthread_mutex_unlock(&s->verrou);
+        }
+        if (ret < 0) return ret;
+        if (lus == -1) return ERROR_READ;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Charge à l'avance une zone de la partition dans le cache de blocs.
+ *
+ * Les unités absentes du cache et consécutives sont lues en un seul appel (preadv, au plus
+ * MAX_BLOCS_ANTICIPES unités), directement dans leurs emplacements, hors des verrous des segments.
+ * Une zone trop grande est limitée au quart du cache, afin que les unités chargées ne s'évincent pas
+ * entre elles. Sans cache, un conseil est seulement donné au système (voir conseillerPartition).
+ *
+ * @param p La partition montée.
+ * @param offset L'offset de la zone dans la partition.
+ * @param taille La taille de la zone, en octets.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int prechargerPartition(partition* p, off_t offset, size_t taille) {
+    //les écritures en vol sont attendues avant de prendre les verrous du cache (que leur achèvement prend)
+    if (__atomic_load_n(&p->moteur.nbEcrituresEnVol, __ATOMIC_RELAXED) > 0 && attendreEcritures(p, offset, taille) < 0) return ERROR_OTHER;
+    if (p->cache.nbEmplacements == 0) {
+        conseillerPartition(p, offset, taille);
+        return 0;
+    }
+    return chargerEmplacements(p, offset, taille);
+}
+
+
+/**
+ * @brief Lit une zone de la partition.
+ *
+ * La zone est découpée en unités de tailleBloc octets servies par le cache de blocs ; une unité
+ * absente est lue sur le support (hors du verrou de son segment) et placée dans le cache. Sans cache,
+ * la lecture est directe (voir lireStockage). Les écritures asynchrones en vol sur la zone sont d'abord attendues.
+ * Le verrou du journal est gardé jusqu'au recouvrement par la transaction en cours : une validation
+ * concurrente ne peut pas retirer du journal une unité que la lecture a trouvée périmée dans le cache.
+ *
+ * @param p La partition montée.
+ * @param buffer Le tampon recevant les données.
+ * @param taille Le nombre d'octets à lire.
+ * @param offset L'offset de la zone dans la partition.
+ * @return Le nombre d'octets lus, -1 en cas d'erreur.
+ */
+ssize_t lirePartition(partition* p, void* buffer, size_t taille, off_t offset) {
+    cacheBlocs* c = &p->cache;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    if (__atomic_load_n(&p->moteur.nbEcrituresEnVol, __ATOMIC_RELAXED) > 0 && attendreEcritures(p, offset, taille) < 0) return -1;
+    pthread_rwlock_rdlock(&p->verrouJournal);
+    if (c->nbEmplacements == 0) {
+        ssize_t ret = lireStockage(p, buffer, taille, offset);
+        if (ret != -1) recouvrirJournal(p, buffer, taille, offset);
+        pthread_rwlock_unlock(&p->verrouJournal);
+        return ret;
+    }
+
+    size_t lus = 0;
+    while (lus < taille) {
+        off_t unite = (offset + lus) / tailleBloc;
+        size_t debut = (offset + lus) % tailleBloc;
+        size_t n = tailleBloc - debut;
+        if (n > taille - lus) n = taille - lus;
+
+        segmentCache* s = segmentDe(c, unite);
+        pthread_mutex_lock(&s->verrou);
+        int i = obtenirEmplacement(p, s, unite, true, false);
+        if (i < 0) {
+            pthread_mutex_unlock(&s->verrou);
+            pthread_rwlock_unlock(&p->verrouJournal);
+            return -1;
+        }
+        s->emplacements[i].reference = true;
+        memcpy((char*)buffer + lus, s->donnees + (off_t)i * tailleBloc + debut, n);
+        pthread_mutex_unlock(&s->verrou);
+        lus += n;
+    }
+    recouvrirJournal(p, buffer, taille, offset);
+    pthread_rwlock_unlock(&p->verrouJournal);
+    return taille;
+}
+
+
+/**
+ * @brief Lit le bloc d'entête d'un fichier (voir lirePartition).
+ *
+ * @param p La partition montée.
+ * @param be L'entête lu.
+ * @param offset L'offset de l'entête dans la partition.
+ * @return Le nombre d'octets lus, -1 en cas d'erreur.
+ */
+static ssize_t lireEntete(partition* p, blocEntete* be, off_t offset) {
+    compter(&statsDuThread(p)->lecturesEntete, 1);
+    return lirePartition(p, be, sizeof(struct blocEntete), offset);
+}
+
+
+/**
+ * @brief Écrit une zone de la partition.
+ *
+ * La zone est découpée en unités de tailleBloc octets écrites dans le cache de blocs et marquées
+ * modifiées ; elles seront réécrites sur le support à leur éviction ou par viderCache. Une unité
+ * absente du cache et partiellement écrite est d'abord lue (hors du verrou de son segment). Sans
+ * cache, l'écriture est directe (voir ecrireStockage).
+ *
+ * @param p La partition montée.
+ * @param buffer Les données à écrire.
+ * @param taille Le nombre d'octets à écrire.
+ * @param offset L'offset de la zone dans la partition.
+ * @return Le nombre d'octets écrits, -1 en cas d'erreur.
+ */
+ssize_t ecrirePartition(partition* p, const void* buffer, size_t taille, off_t offset) {
+    cacheBlocs* c = &p->cache;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    if (c->nbEmplacements == 0)
+        return ecrireStockage(p, buffer, taille, offset);
+
+    size_t ecrits = 0;
+    while (ecrits < taille) {
+        off_t unite = (offset + ecrits) / tailleBloc;
+        size_t debut = (offset + ecrits) % tailleBloc;
+        size_t n = tailleBloc - debut;
+        if (n > taille - ecrits) n = taille - ecrits;
+
+        segmentCache* s = segmentDe(c, unite);
+        pthread_mutex_lock(&s->verrou);
+        int i = obtenirEmplacement(p, s, unite, n < (size_t)tailleBloc, true);
+        if (i < 0) {
+            pthread_mutex_unlock(&s->verrou);
+            return -1;
+        }
+        s->emplacements[i].reference = true;
+        s->emplacements[i].modifie = true;
+        memcpy(s->donnees + (off_t)i * tailleBloc + debut, (const char*)buffer + ecrits, n);
+        pthread_mutex_unlock(&s->verrou);
+        ecrits += n;
+    }
+    return taille;
+}
+
+
+/******************moteur d'entrées / sorties helpers*****************/
+
+/**
+ * @brief Crée un anneau io_uring et projette ses files (soumissions, achèvements, entrées).
+ *
+ * L'anneau est refusé si le noyau ne connaît pas les opérations IORING_OP_READ / IORING_OP_WRITE
+ * (repérées par IORING_FEAT_RW_CUR_POS, apparu avec elles).
+ *
+ * @param a L'anneau à initialiser.
+ * @return 0 en cas de succès, ERROR_OTHER si io_uring est indisponible.
+ */
+static int ouvrirAnneau(anneauES* a) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, PROFONDEUR_MOTEUR, &params);
+    if (fd < 0)
+        return ERROR_OTHER;
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        close(fd);
+        return ERROR_OTHER;
+    }
+
+    a->tailleSq = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    a->tailleCq = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool projectionUnique = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (projectionUnique) {
+        if (a->tailleCq > a->tailleSq) a->tailleSq = a->tailleCq;
+        a->tailleCq = a->tailleSq;
+    }
+    a->tailleSqes = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    a->sq = mmap(NULL, a->tailleSq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    a->cq = projectionUnique ? a->sq
+                             : mmap(NULL, a->tailleCq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    a->sqes = mmap(NULL, a->tailleSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (a->sq == MAP_FAILED || a->cq == MAP_FAILED || a->sqes == MAP_FAILED) {
+        if (a->sq != MAP_FAILED) munmap(a->sq, a->tailleSq);
+        if (!projectionUnique && a->cq != MAP_FAILED) munmap(a->cq, a->tailleCq);
+        if (a->sqes != MAP_FAILED) munmap(a->sqes, a->tailleSqes);
+        close(fd);
+        return ERROR_OTHER;
+    }
+
+    a->fd = fd;
+    a->nbEntrees = params.sq_entries;
+    a->sqTete = (unsigned*)(a->sq + params.sq_off.head);
+    a->sqQueue = (unsigned*)(a->sq + params.sq_off.tail);
+    a->sqMasque = *(unsigned*)(a->sq + params.sq_off.ring_mask);
+    a->sqTableau = (unsigned*)(a->sq + params.sq_off.array);
+    a->cqTete = (unsigned*)(a->cq + params.cq_off.head);
+    a->cqQueue = (unsigned*)(a->cq + params.cq_off.tail);
+    a->cqMasque = *(unsigned*)(a->cq + params.cq_off.ring_mask);
+    a->cqes = a->cq + params.cq_off.cqes;
+    a->aSoumettre = 0;
+    return 0;
+}
+
+
+/**
+ * @brief Libère les projections et le descripteur d'un anneau io_uring.
+ */
+static void fermerAnneau(anneauES* a) {
+    munmap(a->sqes, a->tailleSqes);
+    if (a->cq != a->sq) munmap(a->cq, a->tailleCq);
+    munmap(a->sq, a->tailleSq);
+    close(a->fd);
+}
+
+
+/**
+ * @brief Transmet au noyau les entrées préparées de l'anneau et attend éventuellement des achèvements.
+ *
+ * @param a L'anneau.
+ * @param minAcheves Le nombre d'achèvements à attendre (0 pour ne pas attendre).
+ * @return 0 en cas de succès, ERROR_OTHER sinon.
+ */
+static int entrerAnneau(partition* p, unsigned minAcheves) {
+    anneauES* a = &p->moteur.anneau;
+    while (a->aSoumettre > 0 || minAcheves > 0) {
+        int n = syscall(__NR_io_uring_enter, a->fd, a->aSoumettre, minAcheves,
+                        minAcheves > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        compter(&statsDuThread(p)->soumissions, 1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return ERROR_OTHER;
+        }
+        a->aSoumettre -= n;
+        minAcheves = 0;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Réserve une opération libre du moteur (le tableau des opérations est agrandi au besoin).
+ *
+ * Le verrou du moteur doit être pris.
+ *
+ * @return L'indice de l'opération, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+static int reserverOperation(moteurES* m) {
+    if (m->opLibre == -1) {
+        int capacite = m->capaciteOperations == 0 ? PROFONDEUR_MOTEUR : 2 * m->capaciteOperations;
+        operationES* operations = realloc(m->operations, capacite * sizeof(operationES));
+        if (operations == NULL)
+            return ERROR_OTHER;
+        for (int i = m->capaciteOperations; i < capacite; i++) {
+            operations[i].enVol = false;
+            operations[i].suivante = i + 1 < capacite ? i + 1 : -1;
+        }
+        m->opLibre = m->capaciteOperations;
+        m->operations = operations;
+        m->capaciteOperations = capacite;
+    }
+    int i = m->opLibre;
+    m->opLibre = m->operations[i].suivante;
+    return i;
+}
+
+
+/**
+ * @brief Termine une opération achevée : reprise d'un transfert partiel, cohérence du cache,
+ * mise à jour de sa requête et libération de l'opération.
+ *
+ * Une écriture achevée retire du cache les unités qui y auraient été rechargées entre-temps
+ * (par exemple par la lecture anticipée) sans être modifiées. Le verrou du moteur doit être pris
+ * (ceux des segments du cache sont pris ensuite).
+ *
+ * @param p La partition montée.
+ * @param i L'indice de l'opération.
+ * @param resultat Le nombre d'octets transférés, négatif en cas d'erreur.
+ */
+static void terminerOperation(partition* p, int i, ssize_t resultat) {
+    moteurES* m = &p->moteur;
+    operationES* op = &m->operations[i];
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    if (resultat > 0) compter(op->ecriture ? &statsDuThread(p)->octetsEcrits : &statsDuThread(p)->octetsLus, resultat);
+    //transfert partiel (fin de la partition atteinte en lecture) : le reste est traité directement
+    if (resultat >= 0 && (size_t)resultat < op->taille) {
+        ssize_t n = op->ecriture ? ecrireStockage(p, op->buffer + resultat, op->taille - resultat, op->offset + resultat)
+                                 : lireStockage(p, op->buffer + resultat, op->taille - resultat, op->offset + resultat);
+        if (n == -1) resultat = -1;
+    }
+    if (op->ecriture) {
+        for (off_t u = op->offset / tailleBloc; u < (op->offset + (off_t)op->taille + tailleBloc - 1) / tailleBloc
+                                                && p->cache.nbEmplacements > 0; u++) {
+            segmentCache* s = segmentDe(&p->cache, u);
+            pthread_mutex_lock(&s->verrou);
+            int e = chercherEmplacement(p, s, u);
+            //une lecture en cours de l'unité la relira
+            if (e != -1 && s->emplacements[e].etat == EMPLACEMENT_CHARGEMENT) s->emplacements[e].perime = true;
+            else if (e != -1 && s->emplacements[e].etat == EMPLACEMENT_PRET && !s->emplacements[e].modifie) retirerEmplacement(p, s, e);
+            pthread_mutex_unlock(&s->verrou);
+        }
+    }
+
+    requeteES* r = &m->requetes[op->jeton];
+    if (resultat < 0)
+        r->resultat = op->ecriture ? ERROR_WRITE : ERROR_READ;
+    if (--r->enCours == 0) {
+        free(r->tampon);
+        r->tampon = NULL;
+    }
+    if (op->ecriture) __atomic_fetch_sub(&m->nbEcrituresEnVol, 1, __ATOMIC_RELAXED);
+    op->enVol = false;
+    op->suivante = m->opLibre;
+    m->opLibre = i;
+    m->nbEnVol--;
+}
+
+
+/**
+ * @brief Boucle d'un thread du moteur MOTEUR_THREADS : exécute les opérations de la file
+ * et les range dans la liste des opérations achevées.
+ *
+ * @param arg La partition montée.
+ * @return NULL.
+ */
+static void* executerOperations(void* arg) {
+    partition* p = arg;
+    moteurES* m = &p->moteur;
+
+    pthread_mutex_lock(&m->verrou);
+    while (true) {
+        while (m->fileTete == -1 && !m->arret)
+            pthread_cond_wait(&m->travail, &m->verrou);
+        if (m->fileTete == -1)
+            break;
+        int i = m->fileTete;
+        operationES op = m->operations[i];
+        m->fileTete = op.suivante;
+        if (m->fileTete == -1) m->fileQueue = -1;
+        pthread_mutex_unlock(&m->verrou);
+
+        size_t fait = 0;
+        ssize_t n = 0;
+        while (fait < op.taille) {
+            n = op.ecriture ? pwrite(p->fd, op.buffer + fait, op.taille - fait, op.offset + fait)
+                            : pread(p->fd, op.buffer + fait, op.taille - fait, op.offset + fait);
+            compter(op.ecriture ? &statsDuThread(p)->ecritures : &statsDuThread(p)->lectures, 1);
+            if (n == -1 && errno == EINTR) continue;
+            if (n <= 0) break;
+            fait += n;
+        }
+
+        pthread_mutex_lock(&m->verrou);
+        m->operations[i].resultat = n == -1 ? -1 : (ssize_t)fait;
+        m->operations[i].suivante = m->termineesTete;
+        m->termineesTete = i;
+        pthread_cond_signal(&m->achevement);
+    }
+    pthread_mutex_unlock(&m->verrou);
+    return NULL;
+}
+
+
+/**
+ * @brief Envoie au moteur les opérations préparées (une seule entrée dans le noyau pour io_uring,
+ * un seul réveil des threads sinon).
+ */
+static int envoyerOperations(partition* p) {
+    moteurES* m = &p->moteur;
+    int ret = 0;
+
+    if (m->type == MOTEUR_AUCUN)
+        return 0;
+    pthread_mutex_lock(&m->verrou);
+    if (m->type == MOTEUR_URING)
+        ret = entrerAnneau(p, 0);
+    else
+        pthread_cond_broadcast(&m->travail);
+    pthread_mutex_unlock(&m->verrou);
+    return ret;
+}
+
+
+/**
+ * @brief Traite les opérations achevées du moteur.
+ *
+ * @param p La partition montée.
+ * @param attendre Vrai pour attendre au moins un achèvement s'il y a des opérations en vol.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int recolterOperations(partition* p, bool attendre) {
+    moteurES* m = &p->moteur;
+    int ret = 0;
+
+    if (m->type == MOTEUR_AUCUN)
+        return 0;
+    pthread_mutex_lock(&m->verrou);
+    if (m->type == MOTEUR_URING) {
+        anneauES* a = &m->anneau;
+        unsigned tete = *a->cqTete;
+        if (attendre && m->nbEnVol > 0 && tete == __atomic_load_n(a->cqQueue, __ATOMIC_ACQUIRE))
+            ret = entrerAnneau(p, 1);
+        unsigned queue = __atomic_load_n(a->cqQueue, __ATOMIC_ACQUIRE);
+        for (; tete != queue; tete++) {
+            struct io_uring_cqe* cqe = &((struct io_uring_cqe*)a->cqes)[tete & a->cqMasque];
+            terminerOperation(p, (int)cqe->user_data, cqe->res);
+        }
+        __atomic_store_n(a->cqTete, tete, __ATOMIC_RELEASE);
+    } else {
+        while (attendre && m->nbEnVol > 0 && m->termineesTete == -1)
+            pthread_cond_wait(&m->achevement, &m->verrou);
+        while (m->termineesTete != -1) {
+            int i = m->termineesTete;
+            m->termineesTete = m->operations[i].suivante;
+            terminerOperation(p, i, m->operations[i].resultat);
+        }
+    }
+    pthread_mutex_unlock(&m->verrou);
+    return ret;
+}
+
+
+/**
+ * @brief Attend l'achèvement de toutes les opérations en vol du moteur.
+ */
+static int attendreMoteur(partition* p) {
+    if (envoyerOperations(p) < 0) return ERROR_OTHER;
+    while (p->moteur.nbEnVol > 0)
+        if (recolterOperations(p, true) < 0) return ERROR_OTHER;
+    return 0;
+}
+
+
+/**
+ * @brief Arrête le moteur d'entrées / sorties après l'achèvement de ses opérations.
+ *
+ * Les requêtes (et leurs résultats en attente de myWait) sont conservées.
+ */
+static int arreterMoteur(partition* p) {
+    moteurES* m = &p->moteur;
+    int ret = attendreMoteur(p);
+
+    if (m->type == MOTEUR_AUCUN)
+        return ret;
+    if (m->type == MOTEUR_URING) {
+        fermerAnneau(&m->anneau);
+    } else {
+        pthread_mutex_lock(&m->verrou);
+        m->arret = true;
+        pthread_cond_broadcast(&m->travail);
+        pthread_mutex_unlock(&m->verrou);
+        for (int i = 0; i < m->nbThreads; i++)
+            pthread_join(m->threads[i], NULL);
+    }
+    pthread_cond_destroy(&m->achevement);
+    pthread_cond_destroy(&m->travail);
+    pthread_mutex_destroy(&m->verrou);
+    free(m->operations);
+    m->operations = NULL;
+    m->capaciteOperations = 0;
+    m->type = MOTEUR_AUCUN;
+    return ret;
+}
+
+
+/**
+ * @brief Choisit le moteur d'entrées / sorties asynchrones d'une partition.
+ *
+ * Le moteur actuel est arrêté après l'achèvement de ses opérations. MOTEUR_URING soumet les
+ * opérations par lots à un anneau io_uring (appels système directs) ; si io_uring est indisponible,
+ * le moteur MOTEUR_THREADS (NB_THREADS_MOTEUR threads exécutant pread / pwrite) est utilisé.
+ * Le moteur est démarré à la première opération asynchrone s'il n'a pas été choisi. Une partition
+ * projetée en mémoire (BACKEND_MMAP) n'en utilise pas : ses opérations sont faites immédiatement.
+ *
+ * @param p La partition montée.
+ * @param type MOTEUR_URING, MOTEUR_THREADS ou MOTEUR_AUCUN.
+ * @return Le moteur démarré, une valeur d'erreur sinon.
+ */
+int configurerMoteur(partition* p, int type) {
+    if (p == NULL)
+        return ERROR_OTHER;
+    moteurES* m = &p->moteur;
+
+    if (arreterMoteur(p) < 0) return ERROR_OTHER;
+    if (type == MOTEUR_AUCUN || p->backend == BACKEND_MMAP)
+        return MOTEUR_AUCUN;
+
+    m->opLibre = -1;
+    m->nbEnVol = 0;
+    m->nbEcrituresEnVol = 0;
+    m->fileTete = m->fileQueue = m->termineesTete = -1;
+    m->arret = false;
+    m->nbThreads = 0;
+    pthread_mutex_init(&m->verrou, NULL);
+    pthread_cond_init(&m->travail, NULL);
+    pthread_cond_init(&m->achevement, NULL);
+
+    if (type == MOTEUR_URING && ouvrirAnneau(&m->anneau) == 0) {
+        m->type = MOTEUR_URING;
+        return MOTEUR_URING;
+    }
+
+    //repli : groupe de threads
+    m->type = MOTEUR_THREADS;
+    while (m->nbThreads < NB_THREADS_MOTEUR
+           && pthread_create(&m->threads[m->nbThreads], NULL, executerOperations, p) == 0)
+        m->nbThreads++;
+    if (m->nbThreads == 0) {
+        arreterMoteur(p);
+        return ERROR_OTHER;
+    }
+    return MOTEUR_THREADS;
+}
+
+
+/**
+ * @brief Réserve une requête (un jeton d'achèvement) pour une opération asynchrone.
+ *
+ * La requête garde une référence tant que sa soumission n'est pas terminée (voir scellerRequete) :
+ * son tampon n'est pas libéré par l'achèvement de ses premières opérations.
+ *
+ * @param p La partition montée.
+ * @param resultat Le résultat de la requête si toutes ses opérations réussissent.
+ * @param tampon Le tampon intermédiaire de la requête (libéré à son achèvement), NULL s'il n'y en a pas.
+ * @return Le jeton, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+static int nouvelleRequete(partition* p, int resultat, char* tampon) {
+    moteurES* m = &p->moteur;
+    int jeton = 0;
+
+    while (jeton < m->nbRequetes && m->requetes[jeton].utilisee) jeton++;
+    if (jeton == m->nbRequetes) {
+        int nb = m->nbRequetes == 0 ? 16 : 2 * m->nbRequetes;
+        requeteES* requetes = realloc(m->requetes, nb * sizeof(requeteES));
+        if (requetes == NULL)
+            return ERROR_OTHER;
+        for (int i = m->nbRequetes; i < nb; i++)
+            requetes[i].utilisee = false;
+        m->requetes = requetes;
+        m->nbRequetes = nb;
+    }
+    requeteES* r = &m->requetes[jeton];
+    r->utilisee = true;
+    r->enCours = 1; //référence de la soumission, rendue par scellerRequete
+    r->resultat = resultat;
+    r->tampon = tampon;
+    return jeton;
+}
+
+
+/**
+ * @brief Termine la soumission d'une requête : rend la référence prise par nouvelleRequete
+ * (le tampon est libéré si toutes ses opérations sont déjà achevées).
+ */
+static void scellerRequete(partition* p, int jeton) {
+    requeteES* r = &p->moteur.requetes[jeton];
+    if (--r->enCours == 0) {
+        free(r->tampon);
+        r->tampon = NULL;
+    }
+}
+
+
+/**
+ * @brief Attend l'achèvement des écritures asynchrones en vol qui recouvrent une zone de la partition.
+ *
+ * Les lectures (lirePartition, prechargerPartition, myReadAsync) et les nouvelles écritures
+ * asynchrones d'une zone voient ainsi toujours les écritures déjà soumises, dans leur ordre.
+ *
+ * @param p La partition montée.
+ * @param offset L'offset de la zone.
+ * @param taille La taille de la zone, en octets.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int attendreEcritures(partition* p, off_t offset, size_t taille) {
+    moteurES* m = &p->moteur;
+    int ret = 0;
+
+    //les achèvements libèrent les tampons des requêtes, que les soumissions réallouent
+    pthread_mutex_lock(&p->verrou);
+    while (m->nbEcrituresEnVol > 0 && ret == 0) {
+        bool recouvre = false;
+        pthread_mutex_lock(&m->verrou);
+        for (int i = 0; i < m->capaciteOperations && !recouvre; i++) {
+            operationES* op = &m->operations[i];
+            recouvre = op->enVol && op->ecriture && op->offset < offset + (off_t)taille
+                       && offset < op->offset + (off_t)op->taille;
+        }
+        pthread_mutex_unlock(&m->verrou);
+        if (!recouvre)
+            break;
+        if (envoyerOperations(p) < 0 || recolterOperations(p, true) < 0) ret = ERROR_OTHER;
+    }
+    pthread_mutex_unlock(&p->verrou);
+    return ret;
+}
+
+
+/**
+ * @brief Ajoute une opération (lecture ou écriture d'une zone de la partition) à une requête.
+ *
+ * L'opération est préparée pour le moteur et partira au prochain envoyerOperations (io_uring : si
+ * l'anneau est plein, les opérations préparées partent et un achèvement est attendu). En mode
+ * BACKEND_MMAP, l'opération est faite immédiatement. Une écriture couvre des unités entières,
+ * retirées du cache (le contenu écrit les remplace).
+ *
+ * @param p La partition montée.
+ * @param jeton La requête.
+ * @param ecriture Vrai pour une écriture.
+ * @param buffer Le tampon (reste utilisé jusqu'à l'achèvement).
+ * @param taille Le nombre d'octets.
+ * @param offset L'offset de la zone dans la partition.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int soumettreOperation(partition* p, int jeton, bool ecriture, void* buffer, size_t taille, off_t offset) {
+    moteurES* m = &p->moteur;
+
+    if (attendreEcritures(p, offset, taille) < 0) return ERROR_OTHER;
+    if (ecriture)
+        oublierCache(p, offset / p->sb.tailleBloc, taille / p->sb.tailleBloc);
+    if (m->type == MOTEUR_AUCUN) {
+        ssize_t n = ecriture ? ecrireStockage(p, buffer, taille, offset) : lireStockage(p, buffer, taille, offset);
+        if (n == -1) m->requetes[jeton].resultat = ecriture ? ERROR_WRITE : ERROR_READ;
+        return 0;
+    }
+
+    //io_uring : pas plus d'opérations en vol que d'entrées dans l'anneau
+    while (m->type == MOTEUR_URING && m->nbEnVol >= (int)m->anneau.nbEntrees) {
+        if (envoyerOperations(p) < 0 || recolterOperations(p, true) < 0) return ERROR_OTHER;
+    }
+
+    pthread_mutex_lock(&m->verrou);
+    int i = reserverOperation(m);
+    if (i < 0) {
+        pthread_mutex_unlock(&m->verrou);
+        return ERROR_OTHER;
+    }
+    operationES* op = &m->operations[i];
+    op->ecriture = ecriture;
+    op->buffer = buffer;
+    op->taille = taille;
+    op->offset = offset;
+    op->jeton = jeton;
+    op->enVol = true;
+    op->suivante = -1;
+    m->requetes[jeton].enCours++;
+    m->nbEnVol++;
+    if (ecriture) __atomic_fetch_add(&m->nbEcrituresEnVol, 1, __ATOMIC_RELAXED);
+
+    if (m->type == MOTEUR_URING) {
+        anneauES* a = &m->anneau;
+        unsigned queue = *a->sqQueue;
+        unsigned indice = queue & a->sqMasque;
+        struct io_uring_sqe* sqe = &((struct io_uring_sqe*)a->sqes)[indice];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = ecriture ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe->fd = p->fd;
+        sqe->off = offset;
+        sqe->addr = (uintptr_t)buffer;
+        sqe->len = taille;
+        sqe->user_data = i;
+        a->sqTableau[indice] = indice;
+        __atomic_store_n(a->sqQueue, queue + 1, __ATOMIC_RELEASE);
+        a->aSoumettre++;
+    } else {
+        if (m->fileQueue == -1) m->fileTete = i;
+        else m->operations[m->fileQueue].suivante = i;
+        m->fileQueue = i;
+    }
+    pthread_mutex_unlock(&m->verrou);
+    return 0;
+}
+
+
+/**
+ * @brief Alloue un bloc de données.
+ *
+ * Cette fonction initialise un buffer de données (de tailleBloc octets) et le retourne en sortie.
+ * Le champ suiv est initialisé à -1 pour indiquer qu'il n'y a pas de bloc suivant.
+ * Le champ nbChars est initialisé à 0.
+ * Le tableau de données est initialisé avec des caractères nuls.
+ * Le buffer doit être libéré avec free.
+ *
+ * @param p La partition à laquelle le bloc est destiné.
+ * @return Le bloc de données initialisé, NULL en cas d'erreur d'allocation.
+ */
+blocData* alloc_bloc(partition* p) {
+    blocData* buf = calloc(1, p->sb.tailleBloc);
+    if (buf == NULL)
+        return NULL;
+    buf->suiv = -1;
+    buf->nbChars = 0;
+
+    return buf;
+}
+
+
+/******************espace libre helpers*****************/
+
+/**
+ * @brief Agrandit la table des unités libres pour qu'elle couvre au moins nbUnites unités.
+ *
+ * Les unités ajoutées sont marquées occupées.
+ *
+ * @param p La partition montée.
+ * @param nbUnites Le nombre d'unités à couvrir.
+ * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+static int agrandirBitmap(partition* p, off_t nbUnites) {
+    off_t octets = (nbUnites + 63) / 64 * 8;
+    if (octets <= p->octetsBitmap)
+        return 0;
+    if (octets < 2 * p->octetsBitmap)
+        octets = 2 * p->octetsBitmap;
+    unsigned char* bitmap = realloc(p->bitmapLibre, octets);
+    if (bitmap == NULL)
+        return ERROR_OTHER;
+    memset(bitmap + p->octetsBitmap, 0, octets - p->octetsBitmap);
+    p->bitmapLibre = bitmap;
+    p->octetsBitmap = octets;
+    return 0;
+}
+
+
+/**
+ * @brief Indique si une unité est libre.
+ */
+static bool estUniteLibre(partition* p, off_t unite) {
+    return unite < p->octetsBitmap * 8 && (p->bitmapLibre[unite / 8] >> (unite % 8)) & 1;
+}
+
+
+/**
+ * @brief Marque nb unités consécutives comme libres ou occupées, en tenant à jour nbUnitesLibres.
+ *
+ * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+static int marquerUnites(partition* p, off_t debut, off_t nb, bool libre) {
+    if (libre && agrandirBitmap(p, debut + nb) < 0)
+        return ERROR_OTHER;
+    for (off_t u = debut; u < debut + nb && u < p->octetsBitmap * 8; u++) {
+        unsigned char masque = 1 << (u % 8);
+        if (libre && !(p->bitmapLibre[u / 8] & masque)) {
+            p->bitmapLibre[u / 8] |= masque;
+            p->nbUnitesLibres++;
+        } else if (!libre && (p->bitmapLibre[u / 8] & masque)) {
+            p->bitmapLibre[u / 8] &= ~masque;
+            p->nbUnitesLibres--;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Marque la table des unités libres enregistrée comme périmée.
+ *
+ * Seul le champ bitmapValide du super bloc est réécrit, et uniquement à la première
+ * modification depuis le dernier enregistrement de la table.
+ */
+static void invaliderBitmap(partition* p) {
+    if (p->bitmapModifiee)
+        return;
+    int invalide = 0;
+    p->bitmapModifiee = true;
+    ecrireStockage(p, &invalide, sizeof(int), offsetof(superBloc, bitmapValide));
+}
+
+
+/**
+ * @brief Cherche nb unités libres consécutives (premier trouvé à partir de curseurLibre).
+ *
+ * Les mots de 64 unités entièrement occupés sont sautés d'un coup.
+ *
+ * @return La première unité de la zone trouvée, -1 si aucune zone ne convient.
+ */
+static off_t chercherUnitesLibres(partition* p, off_t nb) {
+    off_t total = p->octetsBitmap * 8;
+    off_t debutRecherche = p->curseurLibre < total ? p->curseurLibre : 0;
+
+    for (int passe = 0; passe < 2; passe++) {
+        off_t u = passe == 0 ? debutRecherche : 0;
+        off_t fin = passe == 0 ? total : debutRecherche;
+        off_t longueur = 0;
+        while (u < fin) {
+            if (longueur == 0 && u % 64 == 0 && u + 64 <= fin) {
+                uint64_t mot;
+                memcpy(&mot, p->bitmapLibre + u / 8, sizeof(mot));
+                if (mot == 0) {
+                    u += 64;
+                    continue;
+                }
+            }
+            if (estUniteLibre(p, u)) {
+                if (++longueur == nb)
+                    return u - nb + 1;
+            } else {
+                longueur = 0;
+            }
+            u++;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Réserve de l'espace dans la partition.
+ *
+ * La taille demandée est arrondie à un nombre entier de blocs (unités de tailleBloc octets).
+ * L'espace est pris en priorité dans la table des unités libres (espace rendu par myDelete et
+ * myTruncate) ; sinon il est prélevé sur la fin de la partition, tenue en mémoire (finPartition,
+ * toujours alignée sur tailleBloc). L'avance de la fin est atomique ; la réutilisation de
+ * l'espace libre n'est pas protégée contre les appels concurrents.
+ * La partition n'est agrandie qu'au moment où la zone est écrite ; l'appelant doit donc
+ * écrire l'espace réservé avant de le relire.
+ *
+ * @param p La partition montée.
+ * @param taille Le nombre d'octets à réserver.
+ * @return L'offset (multiple de tailleBloc) de l'espace réservé.
+ */
+off_t allouerEspace(partition* p, size_t taille) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    off_t nbUnites = ((off_t)taille + tailleBloc - 1) / tailleBloc;
+
+    compter(&statsDuThread(p)->blocsAlloues, nbUnites);
+    if (p->nbUnitesLibres >= nbUnites) {
+        off_t unite = chercherUnitesLibres(p, nbUnites);
+        if (unite != -1) {
+            marquerUnites(p, unite, nbUnites, false);
+            p->curseurLibre = unite + nbUnites;
+            invaliderBitmap(p);
+            return unite * tailleBloc;
+        }
+    }
+    return __atomic_fetch_add(&p->finPartition, nbUnites * tailleBloc, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * @brief Réserve de l'espace dans la partition, de préférence à un offset donné.
+ *
+ * Utilisé pour prolonger un fichier : l'offset souhaité est celui qui suit son dernier bloc,
+ * afin de garder ses blocs contigus. Si cet espace est libre (ou est la fin de la partition),
+ * il est réservé ; sinon l'allocation se fait comme pour allouerEspace.
+ *
+ * @param p La partition montée.
+ * @param taille Le nombre d'octets à réserver.
+ * @param offsetSouhaite L'offset souhaité (multiple de tailleBloc), -1 si aucun.
+ * @return L'offset (multiple de tailleBloc) de l'espace réservé.
+ */
+off_t allouerEspaceProche(partition* p, size_t taille, off_t offsetSouhaite) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    off_t nbUnites = ((off_t)taille + tailleBloc - 1) / tailleBloc;
+
+    if (offsetSouhaite >= 0 && offsetSouhaite % tailleBloc == 0) {
+        off_t unite = offsetSouhaite / tailleBloc;
+        off_t i = 0;
+        while (i < nbUnites && estUniteLibre(p, unite + i)) i++;
+        if (i == nbUnites) {
+            marquerUnites(p, unite, nbUnites, false);
+            invaliderBitmap(p);
+            compter(&statsDuThread(p)->blocsAlloues, nbUnites);
+            return offsetSouhaite;
+        }
+        //l'offset souhaité est la fin de la partition : l'avancer s'il n'a pas bougé entre temps
+        off_t fin = offsetSouhaite;
+        if (i == 0 && __atomic_compare_exchange_n(&p->finPartition, &fin, fin + nbUnites * tailleBloc,
+                                                  false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            compter(&statsDuThread(p)->blocsAlloues, nbUnites);
+            return offsetSouhaite;
+        }
+    }
+    return allouerEspace(p, taille);
+}
+
+
+/**
+ * @brief Agrandit la table des partages pour qu'elle couvre au moins nbUnites unités.
+ *
+ * Les unités ajoutées ne sont pas partagées.
+ *
+ * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+static int agrandirPartages(partition* p, off_t nbUnites) {
+    if (nbUnites <= p->nbPartages)
+        return 0;
+    if (nbUnites < 2 * p->nbPartages)
+        nbUnites = 2 * p->nbPartages;
+    unsigned short* partages = realloc(p->partages, nbUnites * sizeof(unsigned short));
+    if (partages == NULL)
+        return ERROR_OTHER;
+    memset(partages + p->nbPartages, 0, (nbUnites - p->nbPartages) * sizeof(unsigned short));
+    p->partages = partages;
+    p->nbPartages = nbUnites;
+    return 0;
+}
+
+
+/**
+ * @brief Indique si un bloc est partagé par plusieurs fichiers (voir myClone).
+ *
+ * @param p La partition montée.
+ * @param offset L'offset du bloc.
+ * @return Vrai si le bloc a au moins une référence en plus de la première.
+ */
+bool estBlocPartage(partition* p, off_t offset) {
+    off_t unite = offset / p->sb.tailleBloc;
+    return unite < p->nbPartages && p->partages[unite] > 0;
+}
+
+
+/**
+ * @brief Ajoute une référence à chacune des unités d'un espace occupé, qui devient partagé.
+ *
+ * Chaque libération (libererEspace) de l'espace retire ensuite une référence : les unités ne
+ * sont rendues à la table des unités libres qu'avec leur dernière référence.
+ *
+ * @param p La partition montée.
+ * @param offset L'offset (multiple de tailleBloc) de l'espace.
+ * @param taille La taille en octets de l'espace (arrondie à un nombre entier de blocs).
+ * @return 0 en cas de succès, ERROR_OTHER si une unité a déjà MAX_PARTAGES références supplémentaires
+ * (aucune référence n'est alors ajoutée) ou en cas d'erreur d'allocation.
+ */
+int partagerEspace(partition* p, off_t offset, size_t taille) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    off_t debut = offset / tailleBloc;
+    off_t nbUnites = ((off_t)taille + tailleBloc - 1) / tailleBloc;
+
+    if (offset < 0 || nbUnites == 0)
+        return 0;
+    if (agrandirPartages(p, debut + nbUnites) < 0) return ERROR_OTHER;
+    for (off_t u = debut; u < debut + nbUnites; u++)
+        if (p->partages[u] == MAX_PARTAGES) return ERROR_OTHER;
+    for (off_t u = debut; u < debut + nbUnites; u++)
+        p->partages[u]++;
+    invaliderBitmap(p);
+    return 0;
+}
+
+
+/**
+ * @brief Rend de l'espace à la table des unités libres.
+ *
+ * L'espace libéré sera réutilisé par les prochaines allocations (après la validation de la transaction
+ * en cours du journal, voir differerLiberation) ; son contenu n'est pas effacé.
+ * Une unité partagée (voir partagerEspace) perd seulement une référence (elle aussi à la validation) et
+ * reste occupée. Les compteurs blocsLiberes et referencesRetirees (voir myStats) progressent quand
+ * l'unité est effectivement rendue ou la référence effectivement retirée.
+ *
+ * @param p La partition montée.
+ * @param offset L'offset (multiple de tailleBloc) de l'espace à libérer.
+ * @param taille La taille en octets de l'espace (arrondie à un nombre entier de blocs).
+ */
+void libererEspace(partition* p, off_t offset, size_t taille) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    off_t nbUnites = ((off_t)taille + tailleBloc - 1) / tailleBloc;
+
+    if (offset < 0 || nbUnites == 0)
+        return;
+    statsES* stats = statsDuThread(p);
+    off_t u = offset / tailleBloc;
+    off_t fin = u + nbUnites;
+    while (u < fin) {
+        if (u < p->nbPartages && p->partages[u] > 0) {
+            //la référence aussi n'est rendue qu'à la validation : jusque-là l'unité reste copiée avant d'être modifiée
+            if (p->journal.capacite == 0 || differerLiberation(p, u, 1) < 0) {
+                p->partages[u]--;
+                compter(&stats->referencesRetirees, 1);
+            }
+            u++;
+            continue;
+        }
+        //plus longue suite d'unités non partagées à partir de u
+        off_t n = 1;
+        while (u + n < fin && !(u + n < p->nbPartages && p->partages[u + n] > 0)) n++;
+        //le contenu libéré n'a plus à être réécrit, ni à être rejoué
+        oublierCache(p, u, n);
+        revoquerJournal(p, u, n);
+        //avec un journal, l'espace n'est réutilisable qu'après la validation de la transaction qui le libère
+        if (p->journal.capacite == 0 || differerLiberation(p, u, n) < 0) {
+            marquerUnites(p, u, n, true);
+            compter(&stats->blocsLiberes, n);
+        }
+        u += n;
+    }
+    invaliderBitmap(p);
+}
+
+
+/**
+ * @brief Lit un bloc de données complet (tailleBloc octets).
+ *
+ * @param p La partition montée.
+ * @param offset L'offset du bloc dans la partition.
+ * @param bloc Le buffer (de tailleBloc octets) recevant le bloc.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int lireBlocData(partition* p, off_t offset, blocData* bloc) {
+    if (lirePartition(p, bloc, p->sb.tailleBloc, offset) == -1) return ERROR_READ;
+    return 0;
+}
+
+
+/**
+ * @brief Écrit un bloc de données complet (tailleBloc octets).
+ *
+ * @param p La partition montée.
+ * @param offset L'offset du bloc dans la partition.
+ * @param bloc Le bloc à écrire.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int ecrireBlocData(partition* p, off_t offset, blocData* bloc) {
+    if (ecrirePartition(p, bloc, p->sb.tailleBloc, offset) == -1) return ERROR_WRITE;
+    return 0;
+}
+
+
+ /**
+ * @brief Vérifie si une structure blocData est pleine.
+ *
+ * Cette fonction vérifie si tous les éléments de la structure blocData sont remplis.
+ *
+ * @param p La partition contenant le bloc.
+ * @param blocData La structure blocData à vérifier.
+ * @return 1 si la structure est pleine, 0 sinon.
+ */
+int estPleinBlocData(partition* p, blocData* bloc){
+    return bloc->nbChars == p->charsParBloc;
+}
+
+
+/**
+ * @brief Trouve le bloc de données à partir d'une position dans le fichier.
+ *
+ * Cette fonction calcule le bloc de données (utile pour écrire/lire) en utilisant la position actuelle et le nombre maximum de caractères par bloc.
+ *
+ * @param positionActuelle La position actuelle dans le fichier.
+ * @param nbCharMaxParBloc Le nombre maximum de caractères par bloc.
+ * @return Le bloc de données concerné par la position "positionActuelle".
+ */
+int trouverBlocData(int positionActuelle, int nbCharMaxParBloc){
+    return (positionActuelle / nbCharMaxParBloc) + 1;
+}
+
+
+/**
+ * @brief Trouve la position relative dans le tableau de données à partir de la position actuelle dans le fichier.
+ *
+ * Cette fonction calcule la position relative dans le tableau de données en utilisant
+ * la position actuelle et le nombre maximum de caractères par bloc.
+ *
+ * @param positionActuelle La position actuelle dans le bloc de caractères.
+ * @param nbCharMaxParBloc Le nombre maximum de caractères par bloc.
+ * @return La position d'insertion dans le bloc de caractères.
+ */
+int trouverPosition(int positionActuelle, int nbCharMaxParBloc){
+    return positionActuelle % nbCharMaxParBloc;  
+}
+
+/**
+ * @brief Trouve l'offset dans la partition du bloc numero blocNumber d'un fichier f.
+ *
+ * Cette fonction renvoie l'offset dans la partition du bloc
+ * numero blocNumber d'un fichier f donné.
+ * La recherche est dichotomique dans les extents de l'entête puis, si besoin, dans les blocs
+ * d'extents supplémentaires.
+ * Si le bloc est présent dans la table des blocs du descripteur, aucune lecture n'est effectuée.
+ *
+ * @param f Pointeur vers le fichier.
+ * @param blocNumber numéro du bloc du fichier.
+ * @return L'offset du bloc dans la partition, BLOC_TROU si le bloc n'est pas alloué (trou ou
+ *         bloc situé après le dernier bloc), une valeur d'erreur sinon.
+ */
+off_t trouveOffsetBlocFile(file* f, int blocNumber){
+    partition* p = f->part;
+    off_t offsetBloc = f->numEntete;
+    off_t tailleBloc = p->sb.tailleBloc;
+    blocEntete be;
+
+    //cas rapide : bloc deja connu dans la table des blocs du descripteur
+    if (blocNumber>=1 && blocNumber<=f->nbBlocsCharges)
+        return f->tabBlocs[blocNumber-1];
+
+    //lecture de l'entete
+    if (lireEntete(f->part, &be, offsetBloc) == -1) return ERROR_READ;
+    //lecture du nombre de blocs du fichier "f"
+    int nbBlocs = be.nbBlocs;
+
+
+    //cas ou le numero du bloc depasse le nombre de blocs actuel du fichier : bloc non alloué
+    if (nbBlocs<blocNumber)
+        return BLOC_TROU;
+
+    //1- recherche dans les extents de l'entete
+    int nbExtentsEntete = be.nbExtents<NB_EXTENTS_ENTETE ? be.nbExtents : NB_EXTENTS_ENTETE;
+    int i = rechercheExtent(be.tabExtents, nbExtentsEntete, blocNumber);
+    if (i!=-1)
+        return be.tabExtents[i].debut + (off_t)(blocNumber-be.tabExtents[i].premierBloc)*tailleBloc;
+    //2- parcours des blocs d'extents supplementaires
+    blocExtents bx;
+    off_t offsetExtents = be.numExtentsSuiv;
+    while (offsetExtents!=-1) {
+        compter(&statsDuThread(p)->sautsChaine, 1);
+        if (lirePartition(f->part, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_READ;
+        i = rechercheExtent(bx.tabExtents, bx.nbExtents, blocNumber);
+        if (i!=-1)
+            return bx.tabExtents[i].debut + (off_t)(blocNumber-bx.tabExtents[i].premierBloc)*tailleBloc;
+        offsetExtents = bx.suiv;
+    }
+    //aucun extent ne couvre le bloc : c'est un trou
+    return BLOC_TROU;
+}
+
+
+/**
+ * @brief Renvoie la position du dernier caractère dans le fichier.
+ *
+ * Cette fonction lit la taille logique du fichier, tenue à jour dans son entête, en tenant compte
+ * des données en attente dans le tampon d'écriture du descripteur. Elle renvoie la position qui suit le dernier caractère écrit dans le fichier.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @return La position du dernier caractère dans le fichier.
+ *         Si une erreur se produit lors de la lecture de l'entête, la fonction renvoie une valeur d'erreur.
+ */
+int getPosLastCharFile(file* f){
+    blocEntete be;
+
+    //lecture de l'entete
+    if (lireEntete(f->part, &be, f->numEntete)==-1) return ERROR_READ;
+    //les données tamponnées peuvent allonger le fichier
+    if (f->nbTampon > 0 && f->debutTampon + f->nbTampon > be.taille)
+        return f->debutTampon + f->nbTampon;
+    return be.taille;
+}
+/******************journal des métadonnées helpers*****************/
+
+/*
+ * Les métadonnées modifiées en place (entêtes, blocs d'extents, noeuds du répertoire, super bloc) ne sont
+ * pas écrites directement : leurs unités sont recopiées dans la transaction en cours (ecrireMetadonnees),
+ * où les lectures les retrouvent (recouvrirJournal). Valider la transaction, c'est :
+ *    - écrire les données en attente (cache de blocs, écritures asynchrones en vol), qui doivent
+ *      atteindre le support avant les métadonnées qui les référencent ;
+ *    - écrire la transaction (entête, tables, images) dans une moitié du journal ;
+ *    - synchroniser le support une seule fois : toutes les opérations de la transaction partagent ce fsync ;
+ *    - appliquer les images en place (à travers le cache de blocs).
+ * Les deux moitiés du journal sont utilisées à tour de rôle : quand une moitié est réutilisée, la
+ * synchronisation de la transaction suivante a rendu durable l'application en place de son ancien contenu.
+ *
+ * Les zones neuves écrites d'un seul coup (tables des unités libres et des partages, catalogue et
+ * tableaux des instantanés) ne sont pas journalisées : elles sont écrites comme des données, avant la
+ * transaction qui les référence.
+ *
+ * Une unité de la transaction précédente libérée puis réutilisée ne doit plus être rejouée : elle est
+ * révoquée dans la transaction en cours (revoquerJournal).
+ */
+
+/**
+ * @brief Renvoie l'heure d'une horloge monotone, en millisecondes.
+ */
+static long long horlogeMs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long long)t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+
+/**
+ * @brief Poursuit le calcul d'une somme de contrôle FNV-1a (valeur initiale 2166136261).
+ */
+static unsigned int sommeControle(unsigned int somme, const void* donnees, size_t taille) {
+    const unsigned char* octets = donnees;
+    for (size_t i = 0; i < taille; i++) {
+        somme ^= octets[i];
+        somme *= 16777619u;
+    }
+    return somme;
+}
+
+
+/**
+ * @brief Calcule la taille (arrondie à tailleBloc) de l'entête et des tables d'une transaction.
+ */
+static size_t tailleTablesTransaction(partition* p, int nbUnites, int nbRevocations) {
+    size_t taille = sizeof(enteteTransaction) + (size_t)(nbUnites + nbRevocations) * sizeof(off_t);
+    return (taille + p->sb.tailleBloc - 1) / p->sb.tailleBloc * p->sb.tailleBloc;
+}
+
+
+/**
+ * @brief Indique si la transaction en cours est vide (aucune unité, révocation ni libération).
+ */
+static bool transactionVide(journalMeta* j) {
+    return j->nbUnites == 0 && j->nbRevocations == 0 && j->nbLiberees == 0;
+}
+
+
+/**
+ * @brief Réveille le thread validateur du journal, s'il est démarré, pour qu'il réexamine la transaction en cours.
+ */
+static void reveillerValidateur(journalMeta* j) {
+    if (!j->validateurActif)
+        return;
+    pthread_mutex_lock(&j->verrouValidateur);
+    j->reveil = true;
+    pthread_cond_signal(&j->condValidateur);
+    pthread_mutex_unlock(&j->verrouValidateur);
+}
+
+
+/**
+ * @brief Note l'instant de la première modification de la transaction en cours (voir finOperationJournal)
+ * et arme le thread validateur.
+ */
+static void ouvrirTransaction(journalMeta* j) {
+    if (transactionVide(j)) {
+        j->debut = horlogeMs();
+        reveillerValidateur(j);
+    }
+}
+
+
+/**
+ * @brief Cherche une unité dans la transaction en cours.
+ *
+ * @return L'indice de l'unité dans la transaction, -1 si elle n'y est pas.
+ */
+static int chercherJournal(journalMeta* j, off_t unite) {
+    int i = j->tableHachage[unite & j->masqueHachage];
+    while (i != -1 && j->unites[i] != unite)
+        i = j->suivants[i];
+    return i;
+}
+
+
+/**
+ * @brief Retire l'unité d'indice i de la table de hachage de la transaction en cours.
+ */
+static void decrocherJournal(journalMeta* j, int i) {
+    int* lien = &j->tableHachage[j->unites[i] & j->masqueHachage];
+    while (*lien != i)
+        lien = &j->suivants[*lien];
+    *lien = j->suivants[i];
+}
+
+
+/**
+ * @brief Retire l'unité d'indice i de la transaction en cours ; la dernière unité de la transaction prend sa place.
+ */
+static void retirerJournal(journalMeta* j, int i, off_t tailleBloc) {
+    int dernier = j->nbUnites - 1;
+    decrocherJournal(j, i);
+    if (i != dernier) {
+        decrocherJournal(j, dernier);
+        j->unites[i] = j->unites[dernier];
+        memcpy(j->images + (off_t)i * tailleBloc, j->images + (off_t)dernier * tailleBloc, tailleBloc);
+        j->suivants[i] = j->tableHachage[j->unites[i] & j->masqueHachage];
+        j->tableHachage[j->unites[i] & j->masqueHachage] = i;
+    }
+    j->nbUnites--;
+}
+
+
+/**
+ * @brief Compare deux numéros d'unité (qsort, bsearch).
+ */
+static int comparerUnites(const void* a, const void* b) {
+    off_t ua = *(const off_t*)a, ub = *(const off_t*)b;
+    return ua < ub ? -1 : ua > ub;
+}
+
+
+/**
+ * @brief Calcule le nombre d'unités d'une transaction qui tiennent dans une moitié d'une zone de journal.
+ *
+ * Une transaction pleine tient dans une moitié, tables comprises (à raison de deux numéros d'unité
+ * par unité : l'unité et, au plus, une révocation).
+ *
+ * @param p La partition.
+ * @param tailleJournal La taille en octets de la zone du journal.
+ * @return Le nombre d'unités.
+ */
+static int capaciteMoitie(partition* p, int tailleJournal) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    return (tailleJournal / 2 - 2 * tailleBloc) / (tailleBloc + 2 * (off_t)sizeof(off_t));
+}
+
+
+/**
+ * @brief Lit et vérifie la transaction rangée dans une moitié du journal.
+ *
+ * @param p La partition (pas encore montée : accès direct au support).
+ * @param moitie La moitié du journal (0 ou 1).
+ * @param e L'entête lue.
+ * @return Le contenu alloué de la transaction (entête, tables puis images), NULL si la moitié ne contient pas
+ * une transaction complète à rejouer.
+ */
+static char* lireTransaction(partition* p, int moitie, enteteTransaction* e) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    off_t debut = p->sb.journal + moitie * (off_t)(p->sb.tailleJournal / 2);
+    int capacite = capaciteMoitie(p, p->sb.tailleJournal);
+
+    if (lireStockage(p, e, sizeof(enteteTransaction), debut) == -1) return NULL;
+    if (e->magic != MAGIC_JOURNAL || e->sequence < p->sb.sequenceJournal
+        || e->nbUnites < 0 || e->nbUnites > capacite || e->nbRevocations < 0 || e->nbRevocations > capacite)
+        return NULL;
+
+    size_t taille = tailleTablesTransaction(p, e->nbUnites, e->nbRevocations) + (size_t)e->nbUnites * tailleBloc;
+    char* transaction = malloc(taille);
+    if (transaction == NULL || lireStockage(p, transaction, taille, debut) == -1) {
+        free(transaction);
+        return NULL;
+    }
+    enteteTransaction* entete = (enteteTransaction*)transaction;
+    unsigned int somme = entete->somme;
+    entete->somme = 0;
+    if (sommeControle(2166136261u, transaction, taille) != somme) {
+        free(transaction);
+        return NULL;
+    }
+    return transaction;
+}
+
+
+/**
+ * @brief Rejoue les transactions validées du journal d'une partition qui n'a pas été démontée proprement.
+ *
+ * Appelée au montage, avant tout accès aux métadonnées. Les transactions complètes (somme de contrôle
+ * correcte) dont le numéro n'est pas inférieur à sequenceJournal sont appliquées en place dans l'ordre
+ * de leurs numéros ; les unités révoquées par la transaction suivante ne sont pas rejouées. Le super
+ * bloc est ensuite relu : la table des unités libres, qui ne suit pas le journal, sera reconstruite.
+ *
+ * @param p La partition (chargée par chargerPartition, en mode BACKEND_RW).
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int rejouerJournal(partition* p) {
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    if (p->sb.journal == -1)
+        return 0;
+
+    enteteTransaction e[2];
+    char* transactions[2];
+    for (int moitie = 0; moitie < 2; moitie++)
+        transactions[moitie] = lireTransaction(p, moitie, &e[moitie]);
+    //la plus ancienne d'abord ; elle n'est rejouée avec l'autre que si elles se suivent
+    int premiere = transactions[1] != NULL && (transactions[0] == NULL || e[1].sequence < e[0].sequence) ? 1 : 0;
+    int seconde = 1 - premiere;
+    if (transactions[premiere] != NULL && transactions[seconde] != NULL
+        && e[seconde].sequence != e[premiere].sequence + 1) {
+        free(transactions[premiere]);
+        transactions[premiere] = NULL;
+    }
+    if (transactions[premiere] == NULL && transactions[seconde] == NULL)
+        return 0;
+
+    fprintf(stderr, "Partition non démontée proprement : rejeu du journal des métadonnées.\n");
+    int ret = 0;
+    long derniere = 0;
+    int ordre[2] = {premiere, seconde};
+    for (int k = 0; k < 2 && ret == 0; k++) {
+        char* t = transactions[ordre[k]];
+        if (t == NULL)
+            continue;
+        enteteTransaction* entete = (enteteTransaction*)t;
+        off_t* unites = (off_t*)(t + sizeof(enteteTransaction));
+        char* images = t + tailleTablesTransaction(p, entete->nbUnites, entete->nbRevocations);
+        //unités révoquées par la transaction suivante
+        off_t* revoquees = NULL;
+        int nbRevoquees = 0;
+        if (k == 0 && transactions[seconde] != NULL) {
+            enteteTransaction* suivante = (enteteTransaction*)transactions[seconde];
+            revoquees = (off_t*)(transactions[seconde] + sizeof(enteteTransaction)) + suivante->nbUnites;
+            nbRevoquees = suivante->nbRevocations;
+            qsort(revoquees, nbRevoquees, sizeof(off_t), comparerUnites);
+        }
+        for (int i = 0; i < entete->nbUnites && ret == 0; i++) {
+            if (nbRevoquees > 0 && bsearch(&unites[i], revoquees, nbRevoquees, sizeof(off_t), comparerUnites) != NULL)
+                continue;
+            if (ecrireStockage(p, images + (off_t)i * tailleBloc, tailleBloc, unites[i] * tailleBloc) == -1) ret = ERROR_WRITE;
+        }
+        derniere = entete->sequence;
+    }
+    free(transactions[0]);
+    free(transactions[1]);
+    compter(&statsDuThread(p)->synchronisations, 1);
+    if (ret < 0 || fsync(p->fd) == -1) return ERROR_WRITE;
+
+    //le super bloc a pu être rejoué ; les transactions rejouées ne le seront plus
+    if (lireStockage(p, &p->sb, sizeof(superBloc), 0) == -1) return ERROR_READ;
+    p->sb.sequenceJournal = derniere + 1;
+    p->sb.bitmapValide = 0;
+    compter(&statsDuThread(p)->synchronisations, 1);
+    if (ecrireStockage(p, &p->sb, sizeof(superBloc), 0) == -1 || fsync(p->fd) == -1) return ERROR_WRITE;
+
+    struct stat st;
+    if (fstat(p->fd, &st) == -1) return ERROR_OTHER;
+    p->finPartition = (st.st_size + tailleBloc - 1) / tailleBloc * tailleBloc;
+    return 0;
+}
+
+
+/**
+ * @brief Prépare la transaction en cours du journal d'une partition montée (seuils par défaut).
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès (ou si la partition n'a pas de journal), ERROR_OTHER sinon.
+ */
+int initialiserJournal(partition* p) {
+    journalMeta* j = &p->journal;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    memset(j, 0, sizeof(journalMeta));
+    j->sequence = p->sb.sequenceJournal;
+    j->seuil = SEUIL_JOURNAL_DEFAUT;
+    j->delai = DELAI_JOURNAL_DEFAUT;
+    if (p->sb.journal == -1)
+        return 0;
+
+    //la transaction en cours peut grandir au-delà (voir agrandirTransaction)
+    int capacite = capaciteMoitie(p, p->sb.tailleJournal);
+    int tailleHachage = 1;
+    while (tailleHachage < 2 * capacite) tailleHachage *= 2;
+    j->unites = malloc(capacite * sizeof(off_t));
+    j->images = malloc((size_t)capacite * tailleBloc);
+    j->tableHachage = malloc(tailleHachage * sizeof(int));
+    j->suivants = malloc(capacite * sizeof(int));
+    j->precedentes = malloc(capacite * sizeof(off_t));
+    j->revoquees = malloc(capacite * sizeof(bool));
+    if (j->unites == NULL || j->images == NULL || j->tableHachage == NULL || j->suivants == NULL
+        || j->precedentes == NULL || j->revoquees == NULL) {
+        fermerJournal(p);
+        return ERROR_OTHER;
+    }
+    for (int i = 0; i < tailleHachage; i++)
+        j->tableHachage[i] = -1;
+    j->masqueHachage = tailleHachage - 1;
+    j->capacite = capacite;
+    j->capaciteMoitie = capacite;
+    return 0;
+}
+
+
+/**
+ * @brief Libère la transaction en cours du journal, après le démontage.
+ *
+ * Si le journal ne contient plus rien à rejouer (la transaction en cours est vide), le super bloc est mis à
+ * jour sur le support pour qu'aucune transaction ne soit rejouée au prochain montage. Les applications en
+ * place doivent avoir été rendues durables.
+ *
+ * @param p La partition.
+ * @return 0 en cas de succès, ERROR_WRITE sinon.
+ */
+int fermerJournal(partition* p) {
+    journalMeta* j = &p->journal;
+    int ret = 0;
+
+    if (j->capacite > 0 && transactionVide(j)) {
+        p->sb.sequenceJournal = j->sequence;
+        if (ecrireStockage(p, &p->sb.sequenceJournal, sizeof(long), offsetof(superBloc, sequenceJournal)) == -1) ret = ERROR_WRITE;
+    }
+    free(j->unites);
+    free(j->images);
+    free(j->tableHachage);
+    free(j->suivants);
+    free(j->precedentes);
+    free(j->revoquees);
+    free(j->liberees);
+    memset(j, 0, sizeof(journalMeta));
+    return ret;
+}
+
+
+/**
+ * @brief Règle les seuils de validation de la transaction en cours du journal.
+ *
+ * Une transaction est validée à la fin de l'opération (voir finOperationJournal) au cours de laquelle ses
+ * images, ou l'espace qu'elle libère, atteignent seuil octets, ou elle atteint l'âge de delai millisecondes.
+ * Sans nouvelle opération, le thread validateur la valide quand elle atteint cet âge (voir validerPeriodiquement).
+ * Avec un délai nul, chaque opération qui modifie des métadonnées est validée (et synchronisée) dès qu'elle se termine.
+ *
+ * @param p La partition montée.
+ * @param seuil La taille des images ou de l'espace libéré (en octets) qui déclenche la validation ; une
+ * transaction est aussi validée quand elle occupe la moitié de ce que peut contenir une moitié du journal
+ * (voir finOperationJournal).
+ * @param delai L'âge (en millisecondes) qui déclenche la validation.
+ * @return 0 en cas de succès, ERROR_OTHER si un paramètre est invalide.
+ */
+int configurerJournal(partition* p, size_t seuil, int delai) {
+    if (p == NULL || delai < 0)
+        return ERROR_OTHER;
+    pthread_mutex_lock(&p->verrou);
+    p->journal.seuil = seuil;
+    p->journal.delai = delai;
+    reveillerValidateur(&p->journal);
+    pthread_mutex_unlock(&p->verrou);
+    return 0;
+}
+
+
+/**
+ * @brief Réserve une nouvelle zone de journal dont une moitié peut recevoir la transaction en cours.
+ *
+ * Une opération peut modifier plus d'unités qu'une moitié du journal n'en contient ; la transaction
+ * n'est pas coupée pour autant (elle ne serait plus atomique). La taille de la zone est doublée
+ * autant de fois que nécessaire. Le super bloc en mémoire (et son image dans la transaction) désigne
+ * aussitôt la nouvelle zone, mais celui du support ne la désignera qu'une fois la transaction écrite
+ * dans sa première moitié et synchronisée (voir ecrireTransaction) : jusque-là, un arrêt brutal
+ * rejoue l'ancienne zone. L'ancienne zone est libérée après la validation.
+ *
+ * @param p La partition montée (avec un journal).
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int deplacerJournal(partition* p) {
+    journalMeta* j = &p->journal;
+    off_t tailleBloc = p->sb.tailleBloc;
+    int besoin = j->nbUnites > j->nbRevocations ? j->nbUnites : j->nbRevocations;
+
+    int taille = p->sb.tailleJournal;
+    while (capaciteMoitie(p, taille) < besoin) {
+        if (taille > INT_MAX / 2) return ERROR_OTHER;
+        taille *= 2;
+    }
+    off_t zone = allouerEspace(p, taille);
+    if (zone < 0) return ERROR_OTHER;
+
+    p->sb.journal = zone;
+    p->sb.tailleJournal = taille;
+    pthread_rwlock_wrlock(&p->verrouJournal);
+    int i = chercherJournal(j, 0);
+    if (i != -1) {
+        char* image = j->images + (off_t)i * tailleBloc;
+        memcpy(image + offsetof(superBloc, journal), &p->sb.journal, sizeof(off_t));
+        memcpy(image + offsetof(superBloc, tailleJournal), &p->sb.tailleJournal, sizeof(int));
+    }
+    pthread_rwlock_unlock(&p->verrouJournal);
+    j->capaciteMoitie = capaciteMoitie(p, taille);
+    j->moitie = 0;
+    return 0;
+}
+
+
+/**
+ * @brief Écrit et valide la transaction en cours du journal, puis l'applique en place.
+ *
+ * Si la transaction ne tient pas dans une moitié du journal, elle est écrite dans une zone plus grande
+ * (voir deplacerJournal) que le super bloc du support désigne dès qu'elle est synchronisée : ce
+ * basculement est la validation.
+ *
+ * @param p La partition montée (avec un journal).
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int ecrireTransaction(partition* p) {
+    journalMeta* j = &p->journal;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    if (transactionVide(j))
+        return 0;
+
+    //les données référencées par la transaction (et les transactions précédentes appliquées) d'abord
+    if (attendreMoteur(p) < 0) return ERROR_WRITE;
+    if (viderCache(p) < 0) return ERROR_WRITE;
+
+    off_t ancienJournal = -1;
+    int ancienneTaille = 0;
+    if (j->nbUnites > j->capaciteMoitie || j->nbRevocations > j->capaciteMoitie) {
+        ancienJournal = p->sb.journal;
+        ancienneTaille = p->sb.tailleJournal;
+        if (deplacerJournal(p) < 0) return ERROR_OTHER;
+    }
+
+    size_t tailleTables = tailleTablesTransaction(p, j->nbUnites, j->nbRevocations);
+    char* tables = calloc(1, tailleTables);
+    if (tables == NULL)
+        return ERROR_OTHER;
+    enteteTransaction* entete = (enteteTransaction*)tables;
+    entete->magic = MAGIC_JOURNAL;
+    entete->nbUnites = j->nbUnites;
+    entete->nbRevocations = j->nbRevocations;
+    entete->sequence = j->sequence;
+    off_t* table = (off_t*)(tables + sizeof(enteteTransaction));
+    memcpy(table, j->unites, j->nbUnites * sizeof(off_t));
+    int k = j->nbUnites;
+    for (int i = 0; i < j->nbPrecedentes; i++)
+        if (j->revoquees[i]) table[k++] = j->precedentes[i];
+    size_t tailleImages = (size_t)j->nbUnites * tailleBloc;
+    entete->somme = sommeControle(sommeControle(2166136261u, tables, tailleTables), j->images, tailleImages);
+
+    off_t debut = p->sb.journal + j->moitie * (off_t)(p->sb.tailleJournal / 2);
+    int ret = 0;
+    if (ecrireStockage(p, tables, tailleTables, debut) == -1
+        || (tailleImages > 0 && ecrireStockage(p, j->images, tailleImages, debut + tailleTables) == -1))
+        ret = ERROR_WRITE;
+    //nouvelle zone : l'autre moitié ne doit rien contenir à rejouer
+    if (ret == 0 && ancienJournal != -1) {
+        memset(tables, 0, sizeof(enteteTransaction));
+        if (ecrireStockage(p, tables, sizeof(enteteTransaction), debut + p->sb.tailleJournal / 2) == -1) ret = ERROR_WRITE;
+    }
+    free(tables);
+    if (ret < 0) return ret;
+    //la synchronisation qui valide la transaction
+    compter(&statsDuThread(p)->synchronisations, p->projection != NULL ? 2 : 1);
+    if (synchroniserProjection(p) == -1) return ERROR_WRITE;
+    if (fdatasync(p->fd) == -1) return ERROR_WRITE;
+    if (ancienJournal != -1) {
+        //le basculement du super bloc vers la nouvelle zone valide la transaction
+        if (ecrireStockage(p, &p->sb.journal, sizeof(off_t), offsetof(superBloc, journal)) == -1
+            || ecrireStockage(p, &p->sb.tailleJournal, sizeof(int), offsetof(superBloc, tailleJournal)) == -1)
+            return ERROR_WRITE;
+        compter(&statsDuThread(p)->synchronisations, p->projection != NULL ? 2 : 1);
+        if (synchroniserProjection(p) == -1) return ERROR_WRITE;
+        if (fdatasync(p->fd) == -1) return ERROR_WRITE;
+    }
+    j->validations++;
+
+    //application en place ; ces unités deviennent les unités révocables
+    //(les lectures concurrentes attendent : elles trouvent chaque unité dans le journal ou appliquée)
+    pthread_rwlock_wrlock(&p->verrouJournal);
+    for (int i = 0; i < j->nbUnites; i++) {
+        if (ecrirePartition(p, j->images + (off_t)i * tailleBloc, tailleBloc, j->unites[i] * tailleBloc) == -1) {
+            pthread_rwlock_unlock(&p->verrouJournal);
+            return ERROR_WRITE;
+        }
+        j->tableHachage[j->unites[i] & j->masqueHachage] = -1;
+    }
+    memcpy(j->precedentes, j->unites, j->nbUnites * sizeof(off_t));
+    qsort(j->precedentes, j->nbUnites, sizeof(off_t), comparerUnites);
+    memset(j->revoquees, 0, j->nbUnites * sizeof(bool));
+    j->nbPrecedentes = j->nbUnites;
+    j->nbRevocations = 0;
+    j->nbUnites = 0;
+    pthread_rwlock_unlock(&p->verrouJournal);
+    j->moitie = 1 - j->moitie;
+    j->sequence++;
+
+    //l'espace libéré par la transaction devient réutilisable ; les unités partagées perdent une référence
+    statsES* stats = statsDuThread(p);
+    for (int i = 0; i < j->nbLiberees; i++) {
+        off_t u = j->liberees[2 * i];
+        off_t fin = u + j->liberees[2 * i + 1];
+        while (u < fin) {
+            if (u < p->nbPartages && p->partages[u] > 0) {
+                p->partages[u++]--;
+                compter(&stats->referencesRetirees, 1);
+                continue;
+            }
+            off_t n = 1;
+            while (u + n < fin && !(u + n < p->nbPartages && p->partages[u + n] > 0)) n++;
+            marquerUnites(p, u, n, true);
+            compter(&stats->blocsLiberes, n);
+            u += n;
+        }
+    }
+    if (j->nbLiberees > 0)
+        invaliderBitmap(p);
+    j->nbLiberees = 0;
+    j->unitesLiberees = 0;
+
+    //l'ancienne zone du journal n'est plus désignée : elle sera réutilisable après la prochaine validation
+    if (ancienJournal != -1)
+        libererEspace(p, ancienJournal, ancienneTaille);
+    return 0;
+}
+
+
+/**
+ * @brief Double le nombre d'unités que peut contenir la transaction en cours.
+ *
+ * La table de hachage est reconstruite à sa nouvelle taille. Le verrou du journal doit être pris en
+ * écriture (les lectures recouvrent leurs zones par les images de la transaction).
+ *
+ * @param p La partition montée (avec un journal).
+ * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+static int agrandirTransaction(partition* p) {
+    journalMeta* j = &p->journal;
+    off_t tailleBloc = p->sb.tailleBloc;
+    int capacite = 2 * j->capacite;
+    int tailleHachage = 2 * (j->masqueHachage + 1);
+
+    off_t* unites = realloc(j->unites, capacite * sizeof(off_t));
+    if (unites != NULL) j->unites = unites;
+    char* images = realloc(j->images, (size_t)capacite * tailleBloc);
+    if (images != NULL) j->images = images;
+    int* suivants = realloc(j->suivants, capacite * sizeof(int));
+    if (suivants != NULL) j->suivants = suivants;
+    off_t* precedentes = realloc(j->precedentes, capacite * sizeof(off_t));
+    if (precedentes != NULL) j->precedentes = precedentes;
+    bool* revoquees = realloc(j->revoquees, capacite * sizeof(bool));
+    if (revoquees != NULL) j->revoquees = revoquees;
+    int* tableHachage = malloc(tailleHachage * sizeof(int));
+    if (unites == NULL || images == NULL || suivants == NULL || precedentes == NULL || revoquees == NULL
+        || tableHachage == NULL) {
+        free(tableHachage);
+        return ERROR_OTHER;
+    }
+
+    for (int i = 0; i < tailleHachage; i++)
+        tableHachage[i] = -1;
+    for (int i = 0; i < j->nbUnites; i++) {
+        j->suivants[i] = tableHachage[j->unites[i] & (tailleHachage - 1)];
+        tableHachage[j->unites[i] & (tailleHachage - 1)] = i;
+    }
+    free(j->tableHachage);
+    j->tableHachage = tableHachage;
+    j->masqueHachage = tailleHachage - 1;
+    j->capacite = capacite;
+    return 0;
+}
+
+
+/**
+ * @brief Écrit des métadonnées (entête, bloc d'extents, noeud du répertoire, super bloc) dans la transaction en cours.
+ *
+ * Chaque unité touchée est recopiée (lue à travers le cache) dans la transaction à sa première
+ * modification ; les écritures suivantes la modifient sur place. La transaction n'est jamais validée
+ * ici, au milieu d'une opération : si elle est pleine, elle est agrandie (voir agrandirTransaction).
+ * Sans journal, l'écriture est faite par ecrirePartition.
+ *
+ * @param p La partition montée.
+ * @param buffer Les données à écrire.
+ * @param taille Le nombre d'octets à écrire.
+ * @param offset L'offset de la zone dans la partition.
+ * @return Le nombre d'octets écrits, -1 en cas d'erreur.
+ */
+ssize_t ecrireMetadonnees(partition* p, const void* buffer, size_t taille, off_t offset) {
+    journalMeta* j = &p->journal;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    if (j->capacite == 0)
+        return ecrirePartition(p, buffer, taille, offset);
+
+    size_t ecrits = 0;
+    while (ecrits < taille) {
+        off_t unite = (offset + ecrits) / tailleBloc;
+        size_t debut = (offset + ecrits) % tailleBloc;
+        size_t n = tailleBloc - debut;
+        if (n > taille - ecrits) n = taille - ecrits;
+
+        int i = chercherJournal(j, unite);
+        if (i == -1) {
+            if (j->nbUnites == j->capacite) {
+                pthread_rwlock_wrlock(&p->verrouJournal);
+                int ret = agrandirTransaction(p);
+                pthread_rwlock_unlock(&p->verrouJournal);
+                if (ret < 0) return -1;
+            }
+            i = j->nbUnites;
+            //lue avant de prendre le verrou du journal (que la lecture prend aussi)
+            if (lirePartition(p, j->images + (off_t)i * tailleBloc, tailleBloc, unite * tailleBloc) == -1) return -1;
+        }
+        pthread_rwlock_wrlock(&p->verrouJournal);
+        if (i == j->nbUnites) {
+            ouvrirTransaction(j);
+            j->unites[i] = unite;
+            j->suivants[i] = j->tableHachage[unite & j->masqueHachage];
+            j->tableHachage[unite & j->masqueHachage] = i;
+            j->nbUnites++;
+        }
+        memcpy(j->images + (off_t)i * tailleBloc + debut, (const char*)buffer + ecrits, n);
+        pthread_rwlock_unlock(&p->verrouJournal);
+        ecrits += n;
+    }
+    return taille;
+}
+
+
+/**
+ * @brief Recouvre une zone lue dans la partition par les unités modifiées de la transaction en cours.
+ *
+ * Le verrou du journal doit être pris (en lecture, voir lirePartition).
+ *
+ * @param p La partition montée.
+ * @param buffer La zone lue.
+ * @param taille Le nombre d'octets de la zone.
+ * @param offset L'offset de la zone dans la partition.
+ */
+void recouvrirJournal(partition* p, void* buffer, size_t taille, off_t offset) {
+    journalMeta* j = &p->journal;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    if (j->nbUnites == 0)
+        return;
+    size_t lus = 0;
+    while (lus < taille) {
+        off_t unite = (offset + lus) / tailleBloc;
+        size_t debut = (offset + lus) % tailleBloc;
+        size_t n = tailleBloc - debut;
+        if (n > taille - lus) n = taille - lus;
+
+        int i = chercherJournal(j, unite);
+        if (i != -1)
+            memcpy((char*)buffer + lus, j->images + (off_t)i * tailleBloc + debut, n);
+        lus += n;
+    }
+}
+
+
+/**
+ * @brief Signale au journal la libération d'unités (voir libererEspace).
+ *
+ * Les unités retirent leurs images de la transaction en cours (leur contenu n'a plus à être écrit) ;
+ * celles de la dernière transaction validée sont révoquées : la transaction en cours empêchera qu'elles
+ * soient rejouées par-dessus leur prochain contenu.
+ *
+ * @param p La partition montée.
+ * @param debut La première unité libérée.
+ * @param nbUnites Le nombre d'unités libérées.
+ */
+void revoquerJournal(partition* p, off_t debut, off_t nbUnites) {
+    journalMeta* j = &p->journal;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    if (j->capacite == 0)
+        return;
+    //parcours de la plus courte des deux : la transaction ou la zone libérée
+    pthread_rwlock_wrlock(&p->verrouJournal);
+    if (j->nbUnites < nbUnites) {
+        for (int i = 0; i < j->nbUnites; ) {
+            if (j->unites[i] >= debut && j->unites[i] < debut + nbUnites)
+                retirerJournal(j, i, tailleBloc);
+            else
+                i++;
+        }
+    } else {
+        for (off_t u = debut; u < debut + nbUnites && j->nbUnites > 0; u++) {
+            int i = chercherJournal(j, u);
+            if (i != -1) retirerJournal(j, i, tailleBloc);
+        }
+    }
+    pthread_rwlock_unlock(&p->verrouJournal);
+
+    //première unité validée de la zone, puis les suivantes
+    int bas = 0, haut = j->nbPrecedentes;
+    while (bas < haut) {
+        int milieu = (bas + haut) / 2;
+        if (j->precedentes[milieu] < debut) bas = milieu + 1;
+        else haut = milieu;
+    }
+    for (int i = bas; i < j->nbPrecedentes && j->precedentes[i] < debut + nbUnites; i++) {
+        if (!j->revoquees[i]) {
+            ouvrirTransaction(j);
+            j->revoquees[i] = true;
+            j->nbRevocations++;
+        }
+    }
+}
+
+
+/**
+ * @brief Diffère la libération d'unités (voir libererEspace) jusqu'à la validation de la transaction en cours.
+ *
+ * Tant que la transaction n'est pas validée, les métadonnées sur le support référencent encore ces unités :
+ * elles ne doivent pas être réutilisées (et réécrites) avant, ni modifiées sur place par le dernier fichier
+ * qui partage encore l'une d'elles.
+ *
+ * @param p La partition montée (avec un journal).
+ * @param debut La première unité libérée.
+ * @param nbUnites Le nombre d'unités libérées.
+ * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+int differerLiberation(partition* p, off_t debut, off_t nbUnites) {
+    journalMeta* j = &p->journal;
+
+    if (j->nbLiberees == j->capaciteLiberees) {
+        int capacite = j->capaciteLiberees > 0 ? 2 * j->capaciteLiberees : 64;
+        off_t* liberees = realloc(j->liberees, 2 * capacite * sizeof(off_t));
+        if (liberees == NULL)
+            return ERROR_OTHER;
+        j->liberees = liberees;
+        j->capaciteLiberees = capacite;
+    }
+    ouvrirTransaction(j);
+    j->liberees[2 * j->nbLiberees] = debut;
+    j->liberees[2 * j->nbLiberees + 1] = nbUnites;
+    j->nbLiberees++;
+    j->unitesLiberees += nbUnites;
+    return 0;
+}
+
+
+/**
+ * @brief Valide la transaction en cours du journal, avec les noeuds du répertoire modifiés et le super bloc.
+ *
+ * Les noeuds modifiés du cache de noeuds et le super bloc (s'il est modifié) rejoignent la transaction,
+ * qui est écrite dans le journal et synchronisée une seule fois, puis appliquée en place (voir
+ * ecrireMetadonnees). Sans journal, les noeuds, les blocs modifiés du cache puis le super bloc sont écrits
+ * directement.
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int validerJournal(partition* p) {
+    for (int i = 0; i < NB_NOEUDS_CACHE; i++) {
+        noeudCache* c = &p->cacheNoeuds[i];
+        if (c->modifie) {
+            if (ecrireMetadonnees(p, &c->noeud, sizeof(noeudRepertoire), c->offset) == -1) return ERROR_WRITE;
+            c->modifie = false;
+        }
+    }
+
+    if (p->journal.capacite == 0) {
+        //les blocs modifiés du cache, avant le super bloc (écrit directement, en dernier)
+        if (viderCache(p) < 0) return ERROR_WRITE;
+        if (p->superBlocModifie) {
+            if (ecrireStockage(p, &p->sb, sizeof(superBloc), 0) == -1) return ERROR_WRITE;
+            p->superBlocModifie = false;
+        }
+        return 0;
+    }
+
+    if (p->superBlocModifie) {
+        if (ecrireMetadonnees(p, &p->sb, sizeof(superBloc), 0) == -1) return ERROR_WRITE;
+        p->superBlocModifie = false;
+    }
+    return ecrireTransaction(p);
+}
+
+
+/**
+ * @brief Termine une opération de la bibliothèque : valide la transaction en cours si elle a atteint l'un de ses seuils.
+ *
+ * La transaction n'est validée qu'entre deux opérations, jamais au milieu de l'une d'elles : toutes les
+ * opérations terminées depuis la dernière validation sont rendues durables ensemble (voir configurerJournal).
+ * Elle l'est aussi dès qu'elle occupe la moitié de ce que peut contenir une moitié du journal : l'opération
+ * suivante dispose ainsi d'une réserve avant que la zone du journal doive être agrandie (voir deplacerJournal).
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int finOperationJournal(partition* p) {
+    journalMeta* j = &p->journal;
+
+    if (j->capacite == 0 || transactionVide(j))
+        return 0;
+    //l'espace libéré n'est réutilisable qu'après la validation : il compte aussi
+    if ((size_t)j->nbUnites * p->sb.tailleBloc >= j->seuil || (size_t)j->unitesLiberees * p->sb.tailleBloc >= j->seuil
+        || 2 * j->nbUnites >= j->capaciteMoitie || 2 * j->nbRevocations >= j->capaciteMoitie
+        || horlogeMs() - j->debut >= j->delai)
+        return validerJournal(p);
+    return 0;
+}
+
+
+/**
+ * @brief Boucle du thread validateur : valide la transaction en cours quand elle atteint l'âge delai.
+ *
+ * Sans lui, une transaction ouverte par la dernière opération d'une rafale resterait en mémoire
+ * jusqu'à l'opération suivante. Le thread dort jusqu'à l'échéance de la transaction ouverte (ou
+ * jusqu'à son ouverture) ; il valide sous le verrou de la partition, donc entre deux opérations.
+ *
+ * @param arg La partition montée (avec un journal).
+ * @return NULL.
+ */
+static void* validerPeriodiquement(void* arg) {
+    partition* p = arg;
+    journalMeta* j = &p->journal;
+    bool arret = false;
+
+    while (!arret) {
+        long long echeance = -1;
+        pthread_mutex_lock(&p->verrou);
+        if (!transactionVide(j)) {
+            if (horlogeMs() - j->debut >= j->delai)
+                //une erreur sera de nouveau rencontrée (et rendue) par l'opération suivante
+                validerJournal(p);
+            else
+                echeance = j->debut + j->delai;
+        }
+        pthread_mutex_unlock(&p->verrou);
+
+        pthread_mutex_lock(&j->verrouValidateur);
+        if (!j->reveil && !j->arret) {
+            if (echeance == -1) {
+                pthread_cond_wait(&j->condValidateur, &j->verrouValidateur);
+            } else {
+                struct timespec t = {echeance / 1000, (echeance % 1000) * 1000000};
+                pthread_cond_timedwait(&j->condValidateur, &j->verrouValidateur, &t);
+            }
+        }
+        j->reveil = false;
+        arret = j->arret;
+        pthread_mutex_unlock(&j->verrouValidateur);
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Démarre le thread validateur du journal (voir validerPeriodiquement).
+ *
+ * Sans journal, ou si le thread ne peut être créé, les transactions ne sont validées qu'à la fin des opérations.
+ *
+ * @param p La partition montée.
+ */
+static void demarrerValidateur(partition* p) {
+    journalMeta* j = &p->journal;
+    pthread_condattr_t attributs;
+
+    if (j->capacite == 0)
+        return;
+    //échéances exprimées sur l'horloge de horlogeMs
+    pthread_condattr_init(&attributs);
+    pthread_condattr_setclock(&attributs, CLOCK_MONOTONIC);
+    pthread_cond_init(&j->condValidateur, &attributs);
+    pthread_condattr_destroy(&attributs);
+    pthread_mutex_init(&j->verrouValidateur, NULL);
+    j->reveil = false;
+    j->arret = false;
+    if (pthread_create(&j->validateur, NULL, validerPeriodiquement, p) != 0) {
+        pthread_cond_destroy(&j->condValidateur);
+        pthread_mutex_destroy(&j->verrouValidateur);
+        return;
+    }
+    j->validateurActif = true;
+}
+
+
+/**
+ * @brief Arrête le thread validateur du journal (avant la dernière validation du démontage).
+ */
+static void arreterValidateur(partition* p) {
+    journalMeta* j = &p->journal;
+
+    if (!j->validateurActif)
+        return;
+    pthread_mutex_lock(&j->verrouValidateur);
+    j->arret = true;
+    pthread_cond_signal(&j->condValidateur);
+    pthread_mutex_unlock(&j->verrouValidateur);
+    pthread_join(j->validateur, NULL);
+    j->validateurActif = false;
+    pthread_cond_destroy(&j->condValidateur);
+    pthread_mutex_destroy(&j->verrouValidateur);
+}
+
+
+/******************vecteurs (iovec) helpers*****************/
+
+/**
+ * @brief Position courante dans un tableau iovec (myReadv / myWritev, et source des écritures).
+ */
+typedef struct curseurVecteur{
+    const struct iovec* iov;
+    int iovcnt;
+    int indice; //l'élément courant
+    size_t decalage; //la position dans l'élément courant
+}curseurVecteur;
+
+
+/**
+ * @brief Copie les n octets suivants d'un vecteur dans un tampon et avance le curseur.
+ */
+static void copierDepuisVecteur(curseurVecteur* c, char* dest, size_t n) {
+    while (n > 0) {
+        size_t k = c->iov[c->indice].iov_len - c->decalage;
+        if (k > n) k = n;
+        memcpy(dest, (char*)c->iov[c->indice].iov_base + c->decalage, k);
+        dest += k;
+        n -= k;
+        c->decalage += k;
+        if (c->decalage == c->iov[c->indice].iov_len) {
+            c->indice++;
+            c->decalage = 0;
+        }
+    }
+}
+
+
+/**
+ * @brief Copie n octets dans les éléments suivants d'un vecteur (des zéros si src vaut NULL) et avance le curseur.
+ */
+static void copierVersVecteur(curseurVecteur* c, const char* src, size_t n) {
+    while (n > 0) {
+        size_t k = c->iov[c->indice].iov_len - c->decalage;
+        if (k > n) k = n;
+        if (src == NULL) {
+            memset((char*)c->iov[c->indice].iov_base + c->decalage, 0, k);
+        } else {
+            memcpy((char*)c->iov[c->indice].iov_base + c->decalage, src, k);
+            src += k;
+        }
+        n -= k;
+        c->decalage += k;
+        if (c->decalage == c->iov[c->indice].iov_len) {
+            c->indice++;
+            c->decalage = 0;
+        }
+    }
+}
+
+
+/**
+ * @brief Découpe les n octets suivants d'un vecteur en éléments iovec ajoutés à sortie.
+ *
+ * Le curseur n'avance que si les éléments tiennent dans sortie.
+ *
+ * @param c Le curseur.
+ * @param n Le nombre d'octets.
+ * @param sortie Le tableau recevant les éléments.
+ * @param nbSortie En entrée et en sortie, le nombre d'éléments de sortie.
+ * @param max La capacité de sortie.
+ * @return 0 si les éléments ont été ajoutés, -1 s'ils ne tiennent pas.
+ */
+static int decouperVecteur(curseurVecteur* c, size_t n, struct iovec* sortie, int* nbSortie, int max) {
+    curseurVecteur suite = *c;
+    int nb = *nbSortie;
+    while (n > 0) {
+        size_t k = suite.iov[suite.indice].iov_len - suite.decalage;
+        if (k > n) k = n;
+        if (k > 0) {
+            if (nb == max) return -1;
+            sortie[nb].iov_base = (char*)suite.iov[suite.indice].iov_base + suite.decalage;
+            sortie[nb].iov_len = k;
+            nb++;
+        }
+        n -= k;
+        suite.decalage += k;
+        if (suite.decalage == suite.iov[suite.indice].iov_len) {
+            suite.indice++;
+            suite.decalage = 0;
+        }
+    }
+    *c = suite;
+    *nbSortie = nb;
+    return 0;
+}
+
+
+/**
+ * @brief Calcule la taille totale d'un vecteur.
+ *
+ * @return La taille, ERROR_OTHER si le vecteur est invalide ou dépasse INT_MAX octets.
+ */
+static int tailleVecteur(const struct iovec* iov, int iovcnt) {
+    size_t total = 0;
+    if (iov == NULL || iovcnt < 0)
+        return ERROR_OTHER;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > 0 && iov[i].iov_base == NULL) return ERROR_OTHER;
+        total += iov[i].iov_len;
+        if (total > INT_MAX) return ERROR_OTHER;
+    }
+    return total;
+}
+
+/******************tableau trie helpers*****************/
+
+/**
+ * @brief Effectue une recherche dichotomique dans un tableau trié d'éléments de type elemTabIndex.
+ *
+ * @param tableau Le tableau dans lequel effectuer la recherche.
+ * @param taille La taille du tableau.
+ * @param nomFichier Le nom du fichier à rechercher.
+ * @return L'indice de l'élément correspondant au fichier recherché s'il est trouvé, -1 sinon.
+ */
+int rechercheDichotomique(elemTabIndex* tableau, int taille, char* nomFichier) {
+    int debut = 0;
+    int fin = taille - 1;
+
+    while (debut <= fin) {
+        int milieu = (debut + fin) / 2;
+        int cmp = strcmp(tableau[milieu].nomFichier, nomFichier);
+
+        if (cmp < 0)
+            debut = milieu + 1;
+        else if (cmp > 0)
+            fin = milieu - 1;
+        else
+            return milieu; // Le fichier a été trouvé
+    }
+
+    return -1; // Le fichier n'a pas été trouvé
+}
+
+
+/**
+ * @brief Insère un élément dans un tableau trié en fonction du nom de fichier.
+ *
+ * @param tableau Le tableau trié.
+ * @param taille La taille actuelle du tableau.
+ * @param element L'élément à insérer.
+ * @return La position d'insertion de l'élément dans le tableau.
+ */
+int insertionTableauTrie(elemTabIndex* tableau, int taille, elemTabIndex element) {
+    int i = taille - 1;
+
+    while (i >= 0 && strcmp(tableau[i].nomFichier, element.nomFichier) > 0) {
+        tableau[i + 1] = tableau[i];
+        i--;
+    }
+
+    tableau[i + 1] = element;
+
+    return i+1; //pos insertion
+}
+
+/******************repertoire (arbre B+) helpers*****************/
+
+/**
+ * @brief Initialise un verrou lecteurs / rédacteur qui donne la priorité au rédacteur.
+ *
+ * Un flot continu de lectures ne peut ainsi pas retarder indéfiniment une écriture ; en contrepartie,
+ * un thread ne doit pas reprendre en lecture un verrou qu'il détient déjà.
+ */
+static void initialiserVerrouLecteurs(pthread_rwlock_t* verrou) {
+    pthread_rwlockattr_t attributs;
+    pthread_rwlockattr_init(&attributs);
+    pthread_rwlockattr_setkind_np(&attributs, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(verrou, &attributs);
+    pthread_rwlockattr_destroy(&attributs);
+}
+
+
+/**
+ * @brief Monte une partition déjà ouverte : charge son super bloc.
+ *
+ * Une partition dont le super bloc est absent ou d'une autre version du format est refusée ; une
+ * partition à l'ancien format (sans super bloc, le tableau d'index à l'offset 0) est signalée comme
+ * telle : elle se convertit hors ligne avec migrer.
+ *
+ * @param fd Le descripteur de fichier de la partition.
+ * @return Un pointeur vers la partition montée, NULL en cas d'erreur.
+ */
+partition* chargerPartition(int fd) {
+    partition* p = malloc(sizeof(partition));
+    if (p == NULL)
+        return NULL;
+    p->cacheNoeuds = malloc(NB_NOEUDS_CACHE * sizeof(noeudCache));
+    if (p->cacheNoeuds == NULL) {
+        free(p);
+        return NULL;
+    }
+    for (int i = 0; i < NB_NOEUDS_CACHE; i++) {
+        p->cacheNoeuds[i].offset = -1;
+        p->cacheNoeuds[i].modifie = false;
+    }
+    p->fd = fd;
+    p->superBlocModifie = false;
+    p->backend = BACKEND_RW;
+    p->projection = NULL;
+    p->tailleProjection = 0;
+    p->bitmapLibre = NULL;
+    p->octetsBitmap = 0;
+    p->nbUnitesLibres = 0;
+    p->curseurLibre = 0;
+    p->bitmapModifiee = false;
+    p->partages = NULL;
+    p->nbPartages = 0;
+    memset(&p->cache, 0, sizeof(cacheBlocs));
+    memset(&p->moteur, 0, sizeof(moteurES));
+    memset(&p->journal, 0, sizeof(journalMeta));
+
+    //lecture du super bloc
+    if (pread(fd, &p->sb, sizeof(superBloc), 0) == -1) {
+        free(p->cacheNoeuds);
+        free(p);
+        return NULL;
+    }
+    if (p->sb.magic != MAGIC_PARTITION || p->sb.version != VERSION_PARTITION) {
+        //l'ancien format commence par le nombre de fichiers de son tableau d'index
+        if (p->sb.magic >= 0 && p->sb.magic <= NB_FICHIERS_ANCIEN_FORMAT)
+            fprintf(stderr, "Partition à l'ancien format (tableau d'index et blocs chaînés) : la convertir avec migrer.\n");
+        else
+            fprintf(stderr, "Format de partition non reconnu (partition à reformater).\n");
+        errno = EINVAL;
+        free(p->cacheNoeuds);
+        free(p);
+        return NULL;
+    }
+    p->charsParBloc = p->sb.tailleBloc - offsetof(blocData, donnee);
+    //fin de la partition, alignée sur tailleBloc
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        free(p->cacheNoeuds);
+        free(p);
+        return NULL;
+    }
+    p->finPartition = (st.st_size + p->sb.tailleBloc - 1) / p->sb.tailleBloc * p->sb.tailleBloc;
+
+    //verrous : celui de la partition peut être repris par le thread qui le détient (ceux du cache : voir configurerCache)
+    pthread_mutexattr_t recursif;
+    pthread_mutexattr_init(&recursif);
+    pthread_mutexattr_settype(&recursif, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&p->verrou, &recursif);
+    pthread_mutexattr_destroy(&recursif);
+    initialiserVerrouLecteurs(&p->verrouCopies);
+    initialiserVerrouLecteurs(&p->verrouJournal);
+    initialiserVerrouLecteurs(&p->verrouProjection);
+    p->fichiersOuverts = NULL;
+    //instrumentation : l'identifiant du montage invalide les compteurs mémorisés par les threads
+    pthread_mutex_init(&p->verrouStats, NULL);
+    p->generation = __atomic_add_fetch(&generationsMontage, 1, __ATOMIC_RELAXED);
+    p->statsThreads = NULL;
+    memset(&p->statsBase, 0, sizeof(statsES));
+    memset(p->histogrammesBase, 0, sizeof(p->histogrammesBase));
+    memset(&p->trace, 0, sizeof(traceLatences));
+    p->trace.seuil = LONG_MAX;
+    pthread_mutex_init(&p->trace.verrou, NULL);
+    return p;
+}
+
+
+/**
+ * @brief Lit un noeud du répertoire, depuis le cache si possible.
+ *
+ * @param p La partition montée.
+ * @param offset L'offset du noeud dans la partition.
+ * @param noeud Le noeud dans lequel recopier le contenu lu.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int lireNoeud(partition* p, off_t offset, noeudRepertoire* noeud) {
+    noeudCache* c = &p->cacheNoeuds[offset % NB_NOEUDS_CACHE];
+
+    compter(&statsDuThread(p)->lecturesIndex, 1);
+    if (c->offset != offset) {
+        //liberer l'emplacement : reecrire le noeud present s'il a été modifié
+        if (c->modifie) {
+            if (ecrireMetadonnees(p, &c->noeud, sizeof(noeudRepertoire), c->offset) == -1) return ERROR_WRITE;
+            c->modifie = false;
+        }
+        c->offset = -1;
+        if (lirePartition(p, &c->noeud, sizeof(noeudRepertoire), offset) == -1) return ERROR_READ;
+        c->offset = offset;
+    }
+    *noeud = c->noeud;
+    return 0;
+}
+
+
+/**
+ * @brief Écrit un noeud du répertoire dans le cache ; il sera réécrit dans la partition plus tard.
+ *
+ * @param p La partition montée.
+ * @param offset L'offset du noeud dans la partition.
+ * @param noeud Le nouveau contenu du noeud.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int ecrireNoeud(partition* p, off_t offset, noeudRepertoire* noeud) {
+    noeudCache* c = &p->cacheNoeuds[offset % NB_NOEUDS_CACHE];
+
+    compter(&statsDuThread(p)->ecrituresIndex, 1);
+    if (c->offset != offset && c->modifie) {
+        if (ecrireMetadonnees(p, &c->noeud, sizeof(noeudRepertoire), c->offset) == -1) return ERROR_WRITE;
+    }
+    c->offset = offset;
+    c->noeud = *noeud;
+    c->modifie = true;
+    return 0;
+}
+
+
+/**
+ * @brief Alloue un nouveau noeud du répertoire à la fin de la partition.
+ *
+ * Le noeud est écrit immédiatement dans l'espace réservé par allouerEspace.
+ *
+ * @param p La partition montée.
+ * @param noeud Le contenu initial du noeud.
+ * @return L'offset du nouveau noeud, une valeur d'erreur sinon.
+ */
+off_t allouerNoeud(partition* p, noeudRepertoire* noeud) {
+    off_t offset = allouerEspace(p, sizeof(noeudRepertoire));
+    if (offset < 0) return offset;
+    compter(&statsDuThread(p)->ecrituresIndex, 1);
+    if (ecrireMetadonnees(p, noeud, sizeof(noeudRepertoire), offset) == -1) return ERROR_WRITE;
+    return offset;
+}
+
+
+/**
+ * @brief Trouve, dans un noeud interne, l'indice du fils pouvant contenir un nom de fichier.
+ *
+ * @param noeud Le noeud interne.
+ * @param nomFichier Le nom du fichier.
+ * @return L'indice du fils (entre 0 et nbCles).
+ */
+int indiceFils(noeudRepertoire* noeud, char* nomFichier) {
+    int debut = 0;
+    int fin = noeud->nbCles;
+
+    //premier indice i tel que nomFichier < cles[i]
+    while (debut < fin) {
+        int milieu = (debut + fin) / 2;
+        if (strcmp(nomFichier, noeud->interne.cles[milieu]) < 0)
+            fin = milieu;
+        else
+            debut = milieu + 1;
+    }
+    return debut;
+}
+
+
+/**
+ * @brief Recherche un fichier dans le répertoire.
+ *
+ * Descend de la racine jusqu'à la feuille concernée puis effectue une recherche dichotomique.
+ *
+ * @param p La partition montée.
+ * @param nomFichier Le nom du fichier à rechercher.
+ * @return L'offset du bloc d'entête du fichier, -1 s'il n'existe pas, une autre valeur négative en cas d'erreur.
+ */
+off_t rechercheRepertoire(partition* p, char* nomFichier) {
+    noeudRepertoire n;
+    off_t offset = p->sb.racine;
+
+    while (true) {
+        if (lireNoeud(p, offset, &n) < 0) return ERROR_READ;
+        if (n.estFeuille) {
+            int i = rechercheDichotomique(n.entrees, n.nbCles, nomFichier);
+            return i == -1 ? -1 : n.entrees[i].numBlocEntete;
+        }
+        offset = n.interne.fils[indiceFils(&n, nomFichier)];
+    }
+}
+
+
+/**
+ * @brief Insère récursivement un élément dans le sous-arbre de racine offset.
+ *
+ * @param p La partition montée.
+ * @param offset L'offset du noeud racine du sous-arbre.
+ * @param element L'élément à insérer.
+ * @param cleMontee En sortie, la clé à insérer dans le parent si le noeud a été scindé.
+ * @param offsetNouveau En sortie, l'offset du nouveau noeud si le noeud a été scindé.
+ * @return 1 si le noeud a été scindé, 0 sinon, une valeur d'erreur en cas d'échec.
+ */
+static int insererNoeud(partition* p, off_t offset, elemTabIndex* element, char* cleMontee, off_t* offsetNouveau) {
+    noeudRepertoire n;
+    noeudRepertoire nouveau;
+
+    if (lireNoeud(p, offset, &n) < 0) return ERROR_READ;
+
+    if (n.estFeuille) {
+        //cas 1: il reste de la place dans la feuille
+        if (n.nbCles < NB_ENTREES_FEUILLE) {
+            insertionTableauTrie(n.entrees, n.nbCles, *element);
+            n.nbCles++;
+            return ecrireNoeud(p, offset, &n);
+        }
+        //cas 2: scinder la feuille en deux
+        elemTabIndex tmp[NB_ENTREES_FEUILLE + 1];
+        memcpy(tmp, n.entrees, sizeof(n.entrees));
+        insertionTableauTrie(tmp, NB_ENTREES_FEUILLE, *element);
+        int gauche = (NB_ENTREES_FEUILLE + 1) / 2;
+
+        memset(&nouveau, 0, sizeof(noeudRepertoire));
+        nouveau.estFeuille = 1;
+        nouveau.nbCles = NB_ENTREES_FEUILLE + 1 - gauche;
+        memcpy(nouveau.entrees, tmp + gauche, nouveau.nbCles * sizeof(elemTabIndex));
+        nouveau.suiv = n.suiv;
+        *offsetNouveau = allouerNoeud(p, &nouveau);
+        if (*offsetNouveau < 0) return ERROR_WRITE;
+
+        n.nbCles = gauche;
+        memcpy(n.entrees, tmp, gauche * sizeof(elemTabIndex));
+        n.suiv = *offsetNouveau;
+        if (ecrireNoeud(p, offset, &n) < 0) return ERROR_WRITE;
+
+        strcpy(cleMontee, nouveau.entrees[0].nomFichier);
+        return 1;
+    }
+
+    //noeud interne : inserer dans le fils concerné
+    int i = indiceFils(&n, element->nomFichier);
+    char cleFils[MAX_LEN_NAME];
+    off_t offsetFils;
+    int ret = insererNoeud(p, n.interne.fils[i], element, cleFils, &offsetFils);
+    if (ret <= 0) return ret;
+
+    //le fils a été scindé : inserer (cleFils, offsetFils) en position i
+    if (n.nbCles < NB_CLES_INTERNE) {
+        memmove(n.interne.cles[i + 1], n.interne.cles[i], (n.nbCles - i) * MAX_LEN_NAME);
+        memmove(&n.interne.fils[i + 2], &n.interne.fils[i + 1], (n.nbCles - i) * sizeof(off_t));
+        strcpy(n.interne.cles[i], cleFils);
+        n.interne.fils[i + 1] = offsetFils;
+        n.nbCles++;
+        return ecrireNoeud(p, offset, &n);
+    }
+
+    //scinder le noeud interne : la clé du milieu remonte au parent
+    char cles[NB_CLES_INTERNE + 1][MAX_LEN_NAME];
+    off_t fils[NB_CLES_INTERNE + 2];
+    memcpy(cles, n.interne.cles, i * MAX_LEN_NAME);
+    strcpy(cles[i], cleFils);
+    memcpy(cles[i + 1], n.interne.cles[i], (NB_CLES_INTERNE - i) * MAX_LEN_NAME);
+    memcpy(fils, n.interne.fils, (i + 1) * sizeof(off_t));
+    fils[i + 1] = offsetFils;
+    memcpy(&fils[i + 2], &n.interne.fils[i + 1], (NB_CLES_INTERNE - i) * sizeof(off_t));
+
+    int milieu = (NB_CLES_INTERNE + 1) / 2;
+    memset(&nouveau, 0, sizeof(noeudRepertoire));
+    nouveau.estFeuille = 0;
+    nouveau.suiv = -1;
+    nouveau.nbCles = NB_CLES_INTERNE - milieu;
+    memcpy(nouveau.interne.cles, cles[milieu + 1], nouveau.nbCles * MAX_LEN_NAME);
+    memcpy(nouveau.interne.fils, &fils[milieu + 1], (nouveau.nbCles + 1) * sizeof(off_t));
+    *offsetNouveau = allouerNoeud(p, &nouveau);
+    if (*offsetNouveau < 0) return ERROR_WRITE;
+
+    n.nbCles = milieu;
+    memcpy(n.interne.cles, cles, milieu * MAX_LEN_NAME);
+    memcpy(n.interne.fils, fils, (milieu + 1) * sizeof(off_t));
+    if (ecrireNoeud(p, offset, &n) < 0) return ERROR_WRITE;
+
+    strcpy(cleMontee, cles[milieu]);
+    return 1;
+}
+
+
+/**
+ * @brief Insère un nouveau fichier dans le répertoire.
+ *
+ * Le coût est d'une lecture de noeud par niveau de l'arbre et d'une écriture par noeud modifié.
+ * Lorsque la racine est scindée, une nouvelle racine est créée et l'arbre grandit d'un niveau.
+ * L'élément ne doit pas déjà être présent dans le répertoire.
+ *
+ * @param p La partition montée.
+ * @param element L'élément (nom, offset de l'entête) à insérer.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int insererRepertoire(partition* p, elemTabIndex element) {
+    char cleMontee[MAX_LEN_NAME];
+    off_t offsetNouveau;
+
+    int ret = insererNoeud(p, p->sb.racine, &element, cleMontee, &offsetNouveau);
+    if (ret < 0) return ret;
+
+    if (ret == 1) {
+        //la racine a été scindée : nouvelle racine
+        noeudRepertoire racine;
+        memset(&racine, 0, sizeof(noeudRepertoire));
+        racine.estFeuille = 0;
+        racine.nbCles = 1;
+        racine.suiv = -1;
+        strcpy(racine.interne.cles[0], cleMontee);
+        racine.interne.fils[0] = p->sb.racine;
+        racine.interne.fils[1] = offsetNouveau;
+        off_t offsetRacine = allouerNoeud(p, &racine);
+        if (offsetRacine < 0) return ERROR_WRITE;
+        p->sb.racine = offsetRacine;
+        p->sb.hauteur++;
+    }
+    p->sb.nbFichiers++;
+    p->superBlocModifie = true;
+    return 0;
+}
+
+
+/**
+ * @brief Libère un noeud du répertoire retiré de l'arbre (sa copie en cache n'est pas réécrite).
+ */
+static void libererNoeud(partition* p, off_t offset) {
+    noeudCache* c = &p->cacheNoeuds[offset % NB_NOEUDS_CACHE];
+
+    if (c->offset == offset) {
+        c->offset = -1;
+        c->modifie = false;
+    }
+    libererEspace(p, offset, sizeof(noeudRepertoire));
+}
+
+
+/**
+ * @brief Rééquilibre le fils i d'un noeud interne, devenu sous-rempli, avec l'un de ses voisins.
+ *
+ * Le voisin de gauche est choisi s'il existe. Si les deux noeuds tiennent dans un seul, le second est
+ * fusionné dans le premier et libéré : le parent perd une clé et un fils. Sinon, leurs éléments (ou
+ * leurs clés, avec la clé de séparation du parent) sont répartis à parts égales et la clé de séparation
+ * est remplacée. Le parent est modifié en mémoire ; il reste à l'écrire.
+ *
+ * @param p La partition montée.
+ * @param parent Le noeud interne.
+ * @param i L'indice du fils sous-rempli.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int reequilibrerFils(partition* p, noeudRepertoire* parent, int i) {
+    noeudRepertoire g, d;
+    int k = i > 0 ? i - 1 : i; //la clé de séparation des deux noeuds
+    off_t offsetGauche = parent->interne.fils[k];
+    off_t offsetDroite = parent->interne.fils[k + 1];
+
+    if (lireNoeud(p, offsetGauche, &g) < 0 || lireNoeud(p, offsetDroite, &d) < 0) return ERROR_READ;
+
+    bool fusion;
+    if (g.estFeuille) {
+        elemTabIndex entrees[2 * NB_ENTREES_FEUILLE];
+        int total = g.nbCles + d.nbCles;
+        memcpy(entrees, g.entrees, g.nbCles * sizeof(elemTabIndex));
+        memcpy(entrees + g.nbCles, d.entrees, d.nbCles * sizeof(elemTabIndex));
+        fusion = total <= NB_ENTREES_FEUILLE;
+        g.nbCles = fusion ? total : total / 2;
+        memcpy(g.entrees, entrees, g.nbCles * sizeof(elemTabIndex));
+        if (fusion) {
+            g.suiv = d.suiv;
+        } else {
+            d.nbCles = total - g.nbCles;
+            memcpy(d.entrees, entrees + g.nbCles, d.nbCles * sizeof(elemTabIndex));
+            strcpy(parent->interne.cles[k], d.entrees[0].nomFichier);
+        }
+    } else {
+        //clés des deux noeuds, séparées par celle du parent
+        char cles[2 * NB_CLES_INTERNE + 1][MAX_LEN_NAME];
+        off_t fils[2 * NB_CLES_INTERNE + 2];
+        int total = g.nbCles + 1 + d.nbCles;
+        memcpy(cles, g.interne.cles, g.nbCles * MAX_LEN_NAME);
+        strcpy(cles[g.nbCles], parent->interne.cles[k]);
+        memcpy(cles[g.nbCles + 1], d.interne.cles, d.nbCles * MAX_LEN_NAME);
+        memcpy(fils, g.interne.fils, (g.nbCles + 1) * sizeof(off_t));
+        memcpy(&fils[g.nbCles + 1], d.interne.fils, (d.nbCles + 1) * sizeof(off_t));
+        fusion = total <= NB_CLES_INTERNE;
+        //sans fusion, la clé du milieu remonte au parent
+        g.nbCles = fusion ? total : (total - 1) / 2;
+        memcpy(g.interne.cles, cles, g.nbCles * MAX_LEN_NAME);
+        memcpy(g.interne.fils, fils, (g.nbCles + 1) * sizeof(off_t));
+        if (!fusion) {
+            d.nbCles = total - 1 - g.nbCles;
+            memcpy(d.interne.cles, cles[g.nbCles + 1], d.nbCles * MAX_LEN_NAME);
+            memcpy(d.interne.fils, &fils[g.nbCles + 1], (d.nbCles + 1) * sizeof(off_t));
+            strcpy(parent->interne.cles[k], cles[g.nbCles]);
+        }
+    }
+
+    if (ecrireNoeud(p, offsetGauche, &g) < 0) return ERROR_WRITE;
+    if (!fusion)
+        return ecrireNoeud(p, offsetDroite, &d) < 0 ? ERROR_WRITE : 0;
+
+    //fusion : le parent perd la clé k et le fils k + 1
+    memmove(parent->interne.cles[k], parent->interne.cles[k + 1], (parent->nbCles - k - 1) * MAX_LEN_NAME);
+    memmove(&parent->interne.fils[k + 1], &parent->interne.fils[k + 2], (parent->nbCles - k - 1) * sizeof(off_t));
+    parent->nbCles--;
+    libererNoeud(p, offsetDroite);
+    return 0;
+}
+
+
+/**
+ * @brief Supprime récursivement un élément du sous-arbre de racine offset.
+ *
+ * @param p La partition montée.
+ * @param offset L'offset du noeud racine du sous-arbre.
+ * @param nomFichier Le nom du fichier à supprimer.
+ * @param sousRempli En sortie, vrai si le noeud a moins d'éléments (ou de clés) que le minimum d'un noeud scindé.
+ * @return 0 en cas de succès, -1 si le fichier n'existe pas, une autre valeur d'erreur sinon.
+ */
+static int supprimerNoeud(partition* p, off_t offset, char* nomFichier, bool* sousRempli) {
+    noeudRepertoire n;
+
+    *sousRempli = false;
+    if (lireNoeud(p, offset, &n) < 0) return ERROR_READ;
+
+    if (n.estFeuille) {
+        int i = rechercheDichotomique(n.entrees, n.nbCles, nomFichier);
+        if (i == -1) return -1;
+        memmove(&n.entrees[i], &n.entrees[i + 1], (n.nbCles - i - 1) * sizeof(elemTabIndex));
+        n.nbCles--;
+        *sousRempli = n.nbCles < NB_ENTREES_FEUILLE / 2;
+        return ecrireNoeud(p, offset, &n) < 0 ? ERROR_WRITE : 0;
+    }
+
+    //noeud interne : supprimer dans le fils concerné, puis le rééquilibrer s'il est sous-rempli
+    int i = indiceFils(&n, nomFichier);
+    bool filsSousRempli;
+    int ret = supprimerNoeud(p, n.interne.fils[i], nomFichier, &filsSousRempli);
+    if (ret != 0 || !filsSousRempli) return ret;
+    if (reequilibrerFils(p, &n, i) < 0) return ERROR_WRITE;
+    *sousRempli = n.nbCles < (NB_CLES_INTERNE - 1) / 2;
+    return ecrireNoeud(p, offset, &n) < 0 ? ERROR_WRITE : 0;
+}
+
+
+/**
+ * @brief Supprime un fichier du répertoire.
+ *
+ * Un noeud devenu sous-rempli (moins d'éléments que la moitié d'un noeud scindé) est rééquilibré avec
+ * un voisin : les deux sont fusionnés s'ils tiennent dans un seul noeud, sinon leurs éléments sont
+ * répartis (voir reequilibrerFils). Lorsque la racine interne n'a plus qu'un fils, celui-ci devient la
+ * racine et l'arbre perd un niveau. Les noeuds retirés de l'arbre sont libérés.
+ *
+ * @param p La partition montée.
+ * @param nomFichier Le nom du fichier à supprimer.
+ * @return 0 en cas de succès, -1 si le fichier n'existe pas, une autre valeur d'erreur sinon.
+ */
+int supprimerRepertoire(partition* p, char* nomFichier) {
+    bool sousRempli;
+
+    int ret = supprimerNoeud(p, p->sb.racine, nomFichier, &sousRempli);
+    if (ret != 0) return ret;
+
+    if (sousRempli && p->sb.hauteur > 1) {
+        noeudRepertoire racine;
+        if (lireNoeud(p, p->sb.racine, &racine) < 0) return ERROR_READ;
+        if (racine.nbCles == 0) {
+            off_t ancienne = p->sb.racine;
+            p->sb.racine = racine.interne.fils[0];
+            p->sb.hauteur--;
+            libererNoeud(p, ancienne);
+        }
+    }
+    p->sb.nbFichiers--;
+    p->superBlocModifie = true;
+    return 0;
+}
+
+
+/**
+ * @brief Change l'offset de l'entête d'un fichier du répertoire (l'entête a été déplacé, voir myDefrag).
+ *
+ * Seule la feuille contenant le fichier est réécrite : les clés de l'arbre ne changent pas.
+ *
+ * @param p La partition montée.
+ * @param nomFichier Le nom du fichier.
+ * @param offsetEntete Le nouvel offset de l'entête.
+ * @return 0 en cas de succès, -1 si le fichier n'existe pas, une autre valeur d'erreur sinon.
+ */
+static int modifierRepertoire(partition* p, char* nomFichier, off_t offsetEntete) {
+    noeudRepertoire n;
+    off_t offset = p->sb.racine;
+
+    if (lireNoeud(p, offset, &n) < 0) return ERROR_READ;
+    while (!n.estFeuille) {
+        offset = n.interne.fils[indiceFils(&n, nomFichier)];
+        if (lireNoeud(p, offset, &n) < 0) return ERROR_READ;
+    }
+
+    int i = rechercheDichotomique(n.entrees, n.nbCles, nomFichier);
+    if (i == -1) return -1;
+    n.entrees[i].numBlocEntete = offsetEntete;
+    return ecrireNoeud(p, offset, &n) < 0 ? ERROR_WRITE : 0;
+}
+
+
+/**
+ * @brief Parcourt les fichiers du répertoire dans l'ordre alphabétique.
+ *
+ * Descend jusqu'à la feuille la plus à gauche puis suit le chaînage des feuilles.
+ *
+ * @param p La partition montée.
+ * @param traitement La fonction appelée pour chaque élément ; une valeur non nulle arrête le parcours.
+ * @param arg L'argument transmis à traitement.
+ * @return 0 en cas de succès (ou la valeur non nulle renvoyée par traitement), une valeur d'erreur sinon.
+ */
+int parcourirRepertoire(partition* p, int (*traitement)(elemTabIndex* element, void* arg), void* arg) {
+    noeudRepertoire n;
+    off_t offset = p->sb.racine;
+
+    //descendre jusqu'à la feuille la plus à gauche
+    if (lireNoeud(p, offset, &n) < 0) return ERROR_READ;
+    while (!n.estFeuille) {
+        offset = n.interne.fils[0];
+        if (lireNoeud(p, offset, &n) < 0) return ERROR_READ;
+    }
+
+    //suivre le chaînage des feuilles
+    while (true) {
+        for (int i = 0; i < n.nbCles; i++) {
+            int ret = traitement(&n.entrees[i], arg);
+            if (ret != 0) return ret;
+        }
+        if (n.suiv == -1) break;
+        if (lireNoeud(p, n.suiv, &n) < 0) return ERROR_READ;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Valide la transaction en cours du journal (avec les noeuds du répertoire modifiés et le super bloc),
+ * réécrit dans la partition la table des unités libres (validée à son tour avec le super bloc) puis
+ * réécrit les blocs modifiés du cache de blocs.
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int flushIndex(partition* p) {
+    if (p == NULL)
+        return ERROR_OTHER;
+
+    //les opérations terminées : l'espace qu'elles ont libéré devient réutilisable
+    if (validerJournal(p) < 0) return ERROR_WRITE;
+
+    //la table des unités libres (son enregistrement peut allouer de l'espace), référencée par le super bloc
+    if (p->bitmapModifiee && (enregistrerBitmap(p) < 0 || validerJournal(p) < 0)) return ERROR_WRITE;
+
+    //les blocs modifiés du cache, dont les métadonnées qui viennent d'être appliquées en place
+    if (viderCache(p) < 0) return ERROR_WRITE;
+
+    return 0;
+}
+
+/******************extents helpers*****************/
+
+/**
+ * @brief Effectue une recherche dichotomique de l'extent contenant un bloc donné.
+ *
+ * @param tableau Le tableau d'extents, trié par premierBloc.
+ * @param taille Le nombre d'extents du tableau.
+ * @param blocNumber Le numéro du bloc recherché (à partir de 1).
+ * @return L'indice de l'extent contenant le bloc s'il est trouvé, -1 sinon.
+ */
+int rechercheExtent(extent* tableau, int taille, int blocNumber) {
+    int debut = 0;
+    int fin = taille - 1;
+
+    while (debut <= fin) {
+        int milieu = (debut + fin) / 2;
+
+        if (blocNumber < tableau[milieu].premierBloc)
+            fin = milieu - 1;
+        else if (blocNumber >= tableau[milieu].premierBloc + tableau[milieu].nbBlocs)
+            debut = milieu + 1;
+        else
+            return milieu; // L'extent a été trouvé
+    }
+
+    return -1; // Aucun extent ne contient le bloc
+}
+
+
+/**
+ * @brief Ajoute un bloc de données à la fin d'un fichier.
+ *
+ * Le bloc situé à l'offset offsetBloc devient le bloc numéro numBloc (au moins nbBlocs+1) du
+ * fichier ; les blocs compris entre l'ancien dernier bloc et numBloc restent des trous.
+ * Si ce bloc suit immédiatement le dernier extent, dans la partition comme dans le fichier, l'extent est prolongé,
+ * sinon un nouvel extent est créé (dans l'entête, ou dans un bloc d'extents alloué à la fin
+ * de la partition lorsque l'entête est plein). Le nombre de blocs et le dernier bloc de l'entête sont actualisés.
+ * Le chaînage (champ suiv du bloc précédent) reste à la charge de l'appelant.
+ * La table des blocs du descripteur est complétée.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @param numBloc Le numéro du nouveau bloc dans le fichier.
+ * @param offsetBloc L'offset du nouveau bloc de données dans la partition.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int ajouterExtentFile(file* f, int numBloc, off_t offsetBloc) {
+    blocEntete be;
+    blocExtents bx;
+    off_t offsetExtents = -1; //offset du bloc d'extents contenant le dernier extent (-1: entete)
+
+    if (f == NULL)
+        return ERROR_OTHER;
+
+    if (lireEntete(f->part, &be, f->numEntete) == -1) return ERROR_READ;
+
+    int nbBlocsAvant = be.nbBlocs;
+    if (numBloc <= nbBlocsAvant)
+        return ERROR_OTHER;
+    extent* dernier = NULL;
+
+    //localiser le dernier extent
+    if (be.nbExtents > 0 && be.nbExtents <= NB_EXTENTS_ENTETE) {
+        dernier = &be.tabExtents[be.nbExtents - 1];
+    } else if (be.nbExtents > NB_EXTENTS_ENTETE) {
+        offsetExtents = be.numExtentsSuiv;
+        if (lirePartition(f->part, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_READ;
+        while (bx.suiv != -1) {
+            offsetExtents = bx.suiv;
+            if (lirePartition(f->part, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_READ;
+        }
+        dernier = &bx.tabExtents[bx.nbExtents - 1];
+    }
+
+    if (dernier != NULL && dernier->premierBloc + dernier->nbBlocs == numBloc
+        && dernier->debut + (off_t)dernier->nbBlocs * f->part->sb.tailleBloc == offsetBloc) {
+        //cas 1: le bloc prolonge le dernier extent
+        dernier->nbBlocs++;
+    } else {
+        //cas 2: nouvel extent
+        extent e;
+        e.debut = offsetBloc;
+        e.premierBloc = numBloc;
+        e.nbBlocs = 1;
+        if (be.nbExtents < NB_EXTENTS_ENTETE) {
+            be.tabExtents[be.nbExtents] = e;
+        } else if (offsetExtents != -1 && bx.nbExtents < NB_EXTENTS_PAR_BLOC) {
+            bx.tabExtents[bx.nbExtents++] = e;
+        } else {
+            //allouer un nouveau bloc d'extents à la fin de la partition et le chainer
+            blocExtents nouveau;
+            nouveau.nbExtents = 1;
+            nouveau.tabExtents[0] = e;
+            nouveau.suiv = -1;
+            off_t offsetNouveau = allouerEspace(f->part, sizeof(struct blocExtents));
+            if (offsetNouveau < 0) return offsetNouveau;
+            if (ecrireMetadonnees(f->part, &nouveau, sizeof(struct blocExtents), offsetNouveau) == -1) return ERROR_WRITE;
+            if (offsetExtents == -1) {
+                be.numExtentsSuiv = offsetNouveau;
+            } else {
+                bx.suiv = offsetNouveau;
+            }
+        }
+        be.nbExtents++;
+    }
+
+    //actualiser le bloc d'extents modifié
+    if (offsetExtents != -1) {
+        if (ecrireMetadonnees(f->part, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_WRITE;
+    }
+    //actualiser l'entete
+    be.nbBlocs = numBloc;
+    if (be.nbBlocs == 1) be.numTete = offsetBloc;
+    be.numQueue = offsetBloc;
+    be.nbBlocsAlloues++;
+    if (ecrireMetadonnees(f->part, &be, sizeof(struct blocEntete), f->numEntete) == -1) return ERROR_WRITE;
+
+    //actualiser la table des blocs du descripteur si elle est à jour (les trous y sont notés BLOC_TROU)
+    if (f->nbBlocsCharges == nbBlocsAvant) {
+        while (f->nbBlocsCharges < numBloc - 1)
+            if (ajouterTableBlocs(f, BLOC_TROU) < 0) return ERROR_OTHER;
+        return ajouterTableBlocs(f, offsetBloc);
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Réécrit les extents d'un fichier à partir de la liste ordonnée de ses blocs.
+ *
+ * Les blocs contigus sont regroupés en extents, les trous (BLOC_TROU) ne sont couverts par aucun extent ; les anciens blocs d'extents supplémentaires
+ * sont libérés et de nouveaux sont alloués si l'entête ne suffit pas. Le nombre de blocs, la
+ * tête et la queue du fichier sont mis à jour. Les blocs de données eux-mêmes et la taille
+ * logique ne sont pas modifiés.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @param blocs Les offsets des blocs du fichier, dans l'ordre (BLOC_TROU pour un trou).
+ * @param nbBlocs Le nombre de blocs logiques.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int reecrireExtents(file* f, off_t* blocs, int nbBlocs) {
+    partition* p = f->part;
+    off_t tailleBloc = p->sb.tailleBloc;
+    blocEntete be;
+    blocExtents bx;
+
+    if (lireEntete(p, &be, f->numEntete) == -1) return ERROR_READ;
+
+    //liberer les anciens blocs d'extents supplémentaires
+    off_t offsetExtents = be.numExtentsSuiv;
+    while (offsetExtents != -1) {
+        if (lirePartition(p, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_READ;
+        libererEspace(p, offsetExtents, sizeof(struct blocExtents));
+        offsetExtents = bx.suiv;
+    }
+
+    //les trous de fin ne comptent pas : le dernier bloc logique est le dernier bloc alloué
+    while (nbBlocs > 0 && blocs[nbBlocs - 1] == BLOC_TROU) nbBlocs--;
+    be.nbBlocs = nbBlocs;
+    be.numTete = nbBlocs > 0 ? blocs[0] : -1;
+    be.numQueue = nbBlocs > 0 ? blocs[nbBlocs - 1] : -1;
+    be.nbBlocsAlloues = 0;
+    be.nbExtents = 0;
+    be.numExtentsSuiv = -1;
+    offsetExtents = -1; //bloc d'extents en cours de remplissage (-1 : entete)
+
+    int i = 0;
+    while (i < nbBlocs) {
+        if (blocs[i] == BLOC_TROU) {
+            i++;
+            continue;
+        }
+        //regrouper les blocs contigus à partir du bloc i
+        extent e;
+        e.debut = blocs[i];
+        e.premierBloc = i + 1;
+        e.nbBlocs = 1;
+        while (i + e.nbBlocs < nbBlocs && blocs[i + e.nbBlocs] == e.debut + (off_t)e.nbBlocs * tailleBloc)
+            e.nbBlocs++;
+        i += e.nbBlocs;
+        be.nbBlocsAlloues += e.nbBlocs;
+
+        if (be.nbExtents < NB_EXTENTS_ENTETE) {
+            be.tabExtents[be.nbExtents++] = e;
+            continue;
+        }
+        if (offsetExtents == -1 || bx.nbExtents == NB_EXTENTS_PAR_BLOC) {
+            //nouveau bloc d'extents, chainé au précédent (écrit une fois complet)
+            off_t offsetNouveau = allouerEspace(p, sizeof(struct blocExtents));
+            if (offsetExtents == -1) {
+                be.numExtentsSuiv = offsetNouveau;
+            } else {
+                bx.suiv = offsetNouveau;
+                if (ecrireMetadonnees(p, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_WRITE;
+            }
+            offsetExtents = offsetNouveau;
+            bx.nbExtents = 0;
+            bx.suiv = -1;
+        }
+        bx.tabExtents[bx.nbExtents++] = e;
+        be.nbExtents++;
+    }
+    if (offsetExtents != -1) {
+        if (ecrireMetadonnees(p, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_WRITE;
+    }
+
+    if (ecrireMetadonnees(p, &be, sizeof(struct blocEntete), f->numEntete) == -1) return ERROR_WRITE;
+    return 0;
+}
+
+/******************table des blocs helpers*****************/
+
+/**
+ * @brief Ajoute l'offset d'un bloc à la fin de la table des blocs d'un descripteur.
+ *
+ * La table est agrandie (capacité doublée) lorsqu'elle est pleine.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @param offsetBloc L'offset du bloc dans la partition.
+ * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+int ajouterTableBlocs(file* f, off_t offsetBloc) {
+    if (f->nbBlocsCharges == f->capaciteBlocs) {
+        int capacite = f->capaciteBlocs == 0 ? 16 : 2 * f->capaciteBlocs;
+        off_t* tab = realloc(f->tabBlocs, capacite * sizeof(off_t));
+        if (tab == NULL)
+            return ERROR_OTHER;
+        f->tabBlocs = tab;
+        f->capaciteBlocs = capacite;
+    }
+    f->tabBlocs[f->nbBlocsCharges++] = offsetBloc;
+    return 0;
+}
+
+
+/**
+ * @brief Ajoute à la table des blocs les blocs d'un extent, précédés des trous qui le séparent du bloc précédent.
+ *
+ * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+static int ajouterExtentTableBlocs(file* f, extent* e) {
+    while (f->nbBlocsCharges < e->premierBloc - 1)
+        if (ajouterTableBlocs(f, BLOC_TROU) < 0) return ERROR_OTHER;
+    for (int j = 0; j < e->nbBlocs; j++)
+        if (ajouterTableBlocs(f, e->debut + (off_t)j * f->part->sb.tailleBloc) < 0) return ERROR_OTHER;
+    return 0;
+}
+
+
+/**
+ * @brief Construit la table des blocs d'un descripteur de fichier.
+ *
+ * La table est déduite des extents de l'entête et des blocs d'extents (les trous y sont notés
+ * BLOC_TROU).
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int chargerTableBlocs(file* f) {
+    blocEntete be;
+    blocExtents bx;
+
+    f->nbBlocsCharges = 0;
+
+    if (lireEntete(f->part, &be, f->numEntete) == -1) return ERROR_READ;
+
+    //les extents sont parcourus dans l'ordre des blocs
+    int nbExtentsEntete = be.nbExtents < NB_EXTENTS_ENTETE ? be.nbExtents : NB_EXTENTS_ENTETE;
+    for (int i = 0; i < nbExtentsEntete; i++)
+        if (ajouterExtentTableBlocs(f, &be.tabExtents[i]) < 0) return ERROR_OTHER;
+
+    off_t offsetExtents = be.numExtentsSuiv;
+    while (offsetExtents != -1) {
+        if (lirePartition(f->part, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_READ;
+        for (int i = 0; i < bx.nbExtents; i++)
+            if (ajouterExtentTableBlocs(f, &bx.tabExtents[i]) < 0) return ERROR_OTHER;
+        offsetExtents = bx.suiv;
+    }
+
+    return 0;
+}
+
+/******************table des unités libres helpers*****************/
+
+/**
+ * @brief Appelle traitement pour chaque zone de la partition occupée par un fichier.
+ *
+ * Les zones sont : l'entête, chaque extent et chaque bloc d'extents supplémentaire. Un bloc d'extents est lu avant d'être traité.
+ *
+ * @param p La partition montée.
+ * @param offsetEntete L'offset de l'entête du fichier.
+ * @param traitement La fonction appelée avec l'offset et la taille de chaque zone.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int parcourirEspaceFichier(partition* p, off_t offsetEntete, void (*traitement)(partition* p, off_t offset, size_t taille)) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    blocEntete be;
+    blocExtents bx;
+
+    if (lireEntete(p, &be, offsetEntete) == -1) return ERROR_READ;
+
+    int nbExtentsEntete = be.nbExtents < NB_EXTENTS_ENTETE ? be.nbExtents : NB_EXTENTS_ENTETE;
+    for (int i = 0; i < nbExtentsEntete; i++)
+        traitement(p, be.tabExtents[i].debut, (size_t)be.tabExtents[i].nbBlocs * tailleBloc);
+    off_t offsetExtents = be.numExtentsSuiv;
+    while (offsetExtents != -1) {
+        if (lirePartition(p, &bx, sizeof(struct blocExtents), offsetExtents) == -1) return ERROR_READ;
+        for (int i = 0; i < bx.nbExtents; i++)
+            traitement(p, bx.tabExtents[i].debut, (size_t)bx.tabExtents[i].nbBlocs * tailleBloc);
+        traitement(p, offsetExtents, sizeof(struct blocExtents));
+        offsetExtents = bx.suiv;
+    }
+
+    traitement(p, offsetEntete, sizeof(struct blocEntete));
+    return 0;
+}
+
+
+/**
+ * @brief Marque une zone comme occupée lors de la reconstruction de la table des unités libres.
+ *
+ * Une unité déjà occupée est référencée par plusieurs fichiers : une référence lui est ajoutée
+ * dans la table des partages.
+ */
+static void occuperEspace(partition* p, off_t offset, size_t taille) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    off_t u = offset / tailleBloc;
+    off_t fin = u + ((off_t)taille + tailleBloc - 1) / tailleBloc;
+    off_t finUnites = p->finPartition / tailleBloc;
+
+    while (u < fin) {
+        if (!estUniteLibre(p, u)) {
+            if (u < finUnites && agrandirPartages(p, u + 1) == 0 && p->partages[u] < MAX_PARTAGES)
+                p->partages[u]++;
+            u++;
+            continue;
+        }
+        off_t n = 1;
+        while (u + n < fin && estUniteLibre(p, u + n)) n++;
+        marquerUnites(p, u, n, false);
+        u += n;
+    }
+}
+
+
+/**
+ * @brief Marque comme occupés les noeuds du sous-arbre du répertoire de racine offset.
+ */
+static int occuperNoeuds(partition* p, off_t offset) {
+    noeudRepertoire n;
+
+    occuperEspace(p, offset, sizeof(noeudRepertoire));
+    if (lireNoeud(p, offset, &n) < 0) return ERROR_READ;
+    if (n.estFeuille)
+        return 0;
+    for (int i = 0; i <= n.nbCles; i++)
+        if (occuperNoeuds(p, n.interne.fils[i]) < 0) return ERROR_READ;
+    return 0;
+}
+
+
+/**
+ * @brief Marque comme occupé l'espace d'un fichier du répertoire (voir parcourirRepertoire).
+ */
+static int occuperFichier(elemTabIndex* element, void* arg) {
+    return parcourirEspaceFichier((partition*)arg, element->numBlocEntete, occuperEspace);
+}
+
+
+/**
+ * @brief Marque comme occupés le catalogue des instantanés, leurs tableaux de fichiers et l'espace de leurs fichiers.
+ */
+static int occuperInstantanes(partition* p) {
+    int nb = p->sb.nbInstantanes;
+    if (nb == 0)
+        return 0;
+
+    instantane* catalogue = malloc(nb * sizeof(instantane));
+    if (catalogue == NULL) return ERROR_OTHER;
+    if (lirePartition(p, catalogue, nb * sizeof(instantane), p->sb.instantanes) == -1) {
+        free(catalogue);
+        return ERROR_READ;
+    }
+    occuperEspace(p, p->sb.instantanes, nb * sizeof(instantane));
+
+    int ret = 0;
+    for (int i = 0; i < nb && ret == 0; i++) {
+        if (catalogue[i].nbFichiers == 0)
+            continue;
+        size_t taille = catalogue[i].nbFichiers * sizeof(elemTabIndex);
+        elemTabIndex* fichiers = malloc(taille);
+        if (fichiers == NULL || lirePartition(p, fichiers, taille, catalogue[i].index) == -1) {
+            free(fichiers);
+            ret = ERROR_READ;
+            break;
+        }
+        occuperEspace(p, catalogue[i].index, taille);
+        for (int j = 0; j < catalogue[i].nbFichiers && ret == 0; j++)
+            ret = occuperFichier(&fichiers[j], p);
+        free(fichiers);
+    }
+    free(catalogue);
+    return ret;
+}
+
+
+/**
+ * @brief Charge la table des unités libres d'une partition montée.
+ *
+ * Si la table enregistrée n'est pas à jour (partition non démontée proprement), elle est reconstruite.
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int chargerBitmap(partition* p) {
+    off_t finUnites = p->finPartition / p->sb.tailleBloc;
+
+    if (!p->sb.bitmapValide) {
+        fprintf(stderr, "Partition non démontée proprement : reconstruction de la table des unités libres.\n");
+        return reconstruireBitmap(p);
+    }
+
+    p->bitmapModifiee = false;
+    p->nbUnitesLibres = 0;
+    p->curseurLibre = 0;
+    if (p->sb.partages != -1) {
+        if (agrandirPartages(p, p->sb.taillePartages / sizeof(unsigned short)) < 0) return ERROR_OTHER;
+        if (lirePartition(p, p->partages, p->sb.taillePartages, p->sb.partages) == -1) return ERROR_READ;
+    }
+    if (p->sb.bitmap == -1)
+        return 0;
+
+    if (agrandirBitmap(p, (off_t)p->sb.tailleBitmap * 8) < 0) return ERROR_OTHER;
+    if (lirePartition(p, p->bitmapLibre, p->sb.tailleBitmap, p->sb.bitmap) == -1) return ERROR_READ;
+    for (off_t u = 0; u < p->octetsBitmap * 8; u++) {
+        if (!estUniteLibre(p, u))
+            continue;
+        //les unités au-delà de la fin de la partition n'existent pas
+        if (u >= finUnites)
+            p->bitmapLibre[u / 8] &= ~(1 << (u % 8));
+        else
+            p->nbUnitesLibres++;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Reconstruit la table des unités libres et la table des partages à partir du répertoire.
+ *
+ * Toutes les unités situées après le super bloc sont d'abord marquées libres, puis celles
+ * occupées par le journal, par les noeuds du répertoire, par les fichiers (entêtes, extents, blocs
+ * d'extents) et par les instantanés sont marquées occupées ; une unité rencontrée plusieurs fois est partagée.
+ * Les tables reconstruites seront enregistrées par flushIndex.
+ * Les unités occupées qu'aucune de ces structures ne référence (espace perdu) redeviennent libres.
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int reconstruireBitmap(partition* p) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    off_t debutUnites = ((off_t)TAILLE_NOEUD + tailleBloc - 1) / tailleBloc;
+    off_t finUnites = p->finPartition / tailleBloc;
+
+    //les zones des tables enregistrées peuvent être réutilisées : la table du super bloc n'est plus à jour
+    invaliderBitmap(p);
+    free(p->bitmapLibre);
+    p->bitmapLibre = NULL;
+    p->octetsBitmap = 0;
+    p->nbUnitesLibres = 0;
+    p->curseurLibre = 0;
+    free(p->partages);
+    p->partages = NULL;
+    p->nbPartages = 0;
+
+    if (finUnites > debutUnites && marquerUnites(p, debutUnites, finUnites - debutUnites, true) < 0) return ERROR_OTHER;
+    if (p->sb.journal != -1)
+        occuperEspace(p, p->sb.journal, p->sb.tailleJournal);
+    if (occuperNoeuds(p, p->sb.racine) < 0) return ERROR_READ;
+    if (parcourirRepertoire(p, occuperFichier, p) < 0) return ERROR_READ;
+    if (occuperInstantanes(p) < 0) return ERROR_READ;
+
+    //les anciennes zones des tables ne sont plus référencées : elles font partie de l'espace libre
+    p->sb.bitmap = -1;
+    p->sb.tailleBitmap = 0;
+    p->sb.partages = -1;
+    p->sb.taillePartages = 0;
+    p->bitmapModifiee = true;
+    return 0;
+}
+
+
+/**
+ * @brief Rend immédiatement à la table des unités libres l'ancienne zone d'une table (unités libres ou partages).
+ *
+ * Ces zones ne sont pas journalisées : après un arrêt brutal, bitmapValide vaut 0 et leur contenu est ignoré.
+ */
+static void libererZoneTable(partition* p, off_t offset, int taille) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    marquerUnites(p, offset / tailleBloc, taille / tailleBloc, true);
+    oublierCache(p, offset / tailleBloc, taille / tailleBloc);
+}
+
+
+/**
+ * @brief Enregistre la table des unités libres (et la table des partages, si elle existe) dans la partition.
+ *
+ * La table est écrite dans une zone allouée dans la partition (et référencée par le super bloc) ;
+ * si la zone actuelle est trop petite, elle est libérée et une zone deux fois plus grande que
+ * nécessaire est allouée. Le super bloc est marqué modifié (bitmapValide = 1).
+ * La table des partages est enregistrée de la même façon, avant la table des unités libres
+ * (dont elle peut modifier le contenu).
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int enregistrerBitmap(partition* p) {
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    //plus aucun bloc partagé : la table des partages disparaît
+    off_t u = 0;
+    while (u < p->nbPartages && p->partages[u] == 0) u++;
+    if (p->partages != NULL && u == p->nbPartages) {
+        if (p->sb.partages != -1)
+            libererZoneTable(p, p->sb.partages, p->sb.taillePartages);
+        free(p->partages);
+        p->partages = NULL;
+        p->nbPartages = 0;
+        p->sb.partages = -1;
+        p->sb.taillePartages = 0;
+    }
+
+    if (p->partages != NULL) {
+        off_t besoinPartages = p->nbPartages * sizeof(unsigned short);
+        if (p->sb.partages == -1 || besoinPartages > p->sb.taillePartages) {
+            if (p->sb.partages != -1)
+                libererZoneTable(p, p->sb.partages, p->sb.taillePartages);
+            off_t taille = (2 * besoinPartages + tailleBloc - 1) / tailleBloc * tailleBloc;
+            p->sb.partages = allouerEspace(p, taille);
+            p->sb.taillePartages = taille;
+        }
+        if (agrandirPartages(p, p->sb.taillePartages / sizeof(unsigned short)) < 0) return ERROR_OTHER;
+        if (ecrirePartition(p, p->partages, p->sb.taillePartages, p->sb.partages) == -1) return ERROR_WRITE;
+    }
+
+    off_t besoin = (p->finPartition / tailleBloc + 7) / 8;
+
+    while (p->sb.bitmap == -1 || besoin > p->sb.tailleBitmap) {
+        if (p->sb.bitmap != -1)
+            libererZoneTable(p, p->sb.bitmap, p->sb.tailleBitmap);
+        off_t taille = (2 * besoin + tailleBloc - 1) / tailleBloc * tailleBloc;
+        p->sb.bitmap = allouerEspace(p, taille);
+        p->sb.tailleBitmap = taille;
+        besoin = (p->finPartition / tailleBloc + 7) / 8;
+    }
+
+    if (agrandirBitmap(p, (off_t)p->sb.tailleBitmap * 8) < 0) return ERROR_OTHER;
+    if (ecrirePartition(p, p->bitmapLibre, p->sb.tailleBitmap, p->sb.bitmap) == -1) return ERROR_WRITE;
+
+    p->sb.bitmapValide = 1;
+    p->superBlocModifie = true;
+    p->bitmapModifiee = false;
+    return 0;
+}
+
+
+/**
+ * @brief Libère tout l'espace occupé par un fichier (données, blocs d'extents et entête).
+ *
+ * @param p La partition montée.
+ * @param offsetEntete L'offset de l'entête du fichier.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int libererFichier(partition* p, off_t offsetEntete) {
+    return parcourirEspaceFichier(p, offsetEntete, libererEspace);
+}
+
+
+/**
+ * @brief Crée une nouvelle entête décrivant les mêmes blocs de données qu'un fichier existant (clone).
+ *
+ * Chaque bloc alloué du fichier gagne une référence dans la table des partages (voir partagerEspace) ;
+ * l'entête et les blocs d'extents du clone lui sont propres. Le clone a la taille logique du fichier
+ * et n'est ajouté à aucun répertoire.
+ *
+ * @param p La partition montée.
+ * @param offsetEntete L'offset de l'entête du fichier à cloner.
+ * @param nomFichier Le nom rangé dans l'entête du clone.
+ * @return L'offset de l'entête du clone, une valeur d'erreur sinon (ERROR_OTHER notamment si un bloc
+ * a atteint MAX_PARTAGES références supplémentaires).
+ */
+off_t clonerEntete(partition* p, off_t offsetEntete, char* nomFichier) {
+    off_t tailleBloc = p->sb.tailleBloc;
+    blocEntete be;
+    file source;
+
+    if (lireEntete(p, &be, offsetEntete) == -1) return ERROR_READ;
+    memset(&source, 0, sizeof(file));
+    source.part = p;
+    source.numEntete = offsetEntete;
+    if (chargerTableBlocs(&source) < 0) {
+        free(source.tabBlocs);
+        return ERROR_READ;
+    }
+
+    //une référence de plus pour chaque suite de blocs contigus
+    off_t ret = 0;
+    int i = 0;
+    while (i < source.nbBlocsCharges) {
+        if (source.tabBlocs[i] == BLOC_TROU) {
+            i++;
+            continue;
+        }
+        int n = 1;
+        while (i + n < source.nbBlocsCharges && source.tabBlocs[i + n] == source.tabBlocs[i] + n * tailleBloc) n++;
+        if (partagerEspace(p, source.tabBlocs[i], (size_t)n * tailleBloc) < 0) {
+            ret = ERROR_OTHER;
+            break;
+        }
+        i += n;
+    }
+
+    //entête du clone : sans bloc, puis décrite par les extents de la source
+    if (ret == 0) {
+        file clone = source;
+        strcpy(be.nomFichier, nomFichier);
+        be.nbBlocs = 0;
+        be.numTete = -1;
+        be.nbExtents = 0;
+        be.numExtentsSuiv = -1;
+        be.numQueue = -1;
+        be.nbBlocsAlloues = 0;
+        clone.numEntete = allouerEspace(p, sizeof(struct blocEntete));
+        if (ecrireMetadonnees(p, &be, sizeof(struct blocEntete), clone.numEntete) == -1 ||
+            reecrireExtents(&clone, source.tabBlocs, source.nbBlocsCharges) < 0) {
+            libererEspace(p, clone.numEntete, sizeof(struct blocEntete));
+            ret = ERROR_WRITE;
+        } else {
+            ret = clone.numEntete;
+        }
+    }
+
+    //échec : retirer les références déjà ajoutées
+    if (ret < 0) {
+        for (int j = 0; j < i; j++)
+            if (source.tabBlocs[j] != BLOC_TROU) libererEspace(p, source.tabBlocs[j], tailleBloc);
+    }
+    free(source.tabBlocs);
+    return ret;
+}
+
+/*********************************************************************
+ |       		FONCTIONS DE MANIPULATION D'ENTETE		|
+ ********************************************************************/
+
+ /****************************PRECONDITION: Partition formatée (appel effectué à myFormat)*****************************************/
+ /*****************************************GETTERS********************************************/
+
+/**
+ * \brief Récupère le nombre de blocs d'un fichier.
+ *
+ * Cette fonction retourne le nombre de blocs d'un fichier spécifié par le pointeur \p f.
+ *
+ * \param f Le pointeur vers la structure de fichier.
+ * \return Le nombre de blocs du fichier.
+ *         En cas d'erreur, la fonction retourne ERROR_OTHER si \p f est NULL,
+ *         ERROR_LSEEK si une erreur s'est produite lors du déplacement vers le début du fichier,
+ *         ou ERROR_READ si une erreur s'est produite lors de la lecture du bloc d'entête.
+ */
+int getNbBlocsFile(file* f) { //fd: descripteur de fichier
+
+    if (f == NULL)
+        return ERROR_OTHER;
+
+    blocEntete buff;
+
+    off_t numEntete = f->numEntete; //recuperer l'offset vers l'entete du fichier depuis le debut de la partition
+
+
+    // Lire le bloc d'entete du fichier
+    if (lireEntete(f->part, &buff, numEntete) == -1)
+        return ERROR_READ;
+
+	//à la sortie, f pointe vers le bloc suivant
+    return buff.nbBlocs; //nombre de blocs du fichier
+}
+
+
+/**
+ * \brief Récupère l'offset vers le premier bloc de données du fichier.
+ *
+ * Cette fonction retourne le nombre de blocs d'un fichier spécifié par le pointeur \p f.
+ *
+ * \param f Le pointeur vers la structure de fichier.
+ * \return L'offset vers le premier bloc de données.
+ *         En cas d'erreur, la fonction retourne ERROR_OTHER si \p f est NULL,
+ *         ERROR_LSEEK si une erreur s'est produite lors du déplacement evrs bloc d'entete,
+ *         ou ERROR_READ si une erreur s'est produite lors de la lecture du bloc d'entête.
+ */
+off_t getNumTeteFile(file* f) { //fd descripteur de fichier
+
+
+    if (f == NULL)
+        return ERROR_OTHER;
+
+
+    blocEntete buff;
+
+
+    off_t numEntete = f->numEntete; //recuperer l'offset vers l'entete du fichier depuis le debut de la partition
+
+
+    // Lire le bloc d'entete du fichier
+    if (lireEntete(f->part, &buff, numEntete) == -1)
+        return ERROR_READ;
+
+        //à la sortie, l'offset du fichier est sur le 1er bloc data
+    return buff.numTete; //nombre de blocs du fichier
+}
+
+
+
+/****************************PRECONDITION: Partition formatée (appel effectué à myFormat)*****************************************/
+/*******************************************SETTERS*************************************************/
+
+/**
+ * @brief Modifie le nombre de blocs d'un fichier.
+ *
+ * Cette fonction permet de modifier le nombre de blocs d'un fichier spécifié.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @param val La nouvelle valeur du nombre de blocs.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int setNbBlocsFile(file* f, int val) {
+
+    if (f == NULL)
+        return ERROR_OTHER;
+
+    blocEntete buff;
+
+    // Lire le bloc d'entete du fichier
+    if (lireEntete(f->part, &buff, f->numEntete) == -1)
+        return ERROR_READ;
+
+    //modifier le nombre de blocs du fichier
+    buff.nbBlocs = val;
+    //actualiser le bloc d'entete
+    if (ecrireMetadonnees(f->part, &buff, sizeof(struct blocEntete), f->numEntete) == -1)
+        return ERROR_WRITE;
+
+    return 0; //renvoyer 0 si succés
+}
+
+
+/**
+ * @brief Modifie l'offset vers la tête (premier bloc de données) du fichier.
+ *
+ * Cette fonction modifie l'offset vers la tête du fichier (premier bloc de données) spécifié par le pointeur `f`.
+ * L'offset spécifié est donné par le paramètre `val`.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @param val La nouvelle valeur de l'offset vers la tête du fichier.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int setNumTeteFile(file* f, off_t val) {
+
+    if (f == NULL)
+        return ERROR_OTHER;
+
+
+    blocEntete buff;
+
+
+    off_t numEntete = f->numEntete; //recuperer l'offset vers l'entete du fichier depuis le debut de la partition
+
+
+    // Lire le bloc d'entete du fichier
+    if (lireEntete(f->part, &buff, numEntete) == -1)
+        return ERROR_READ;
+
+
+    //modifier l'offset vers la tete
+    buff.numTete = val;
+    //actualiser le bloc d'entete
+    if (ecrireMetadonnees(f->part, &buff, sizeof(struct blocEntete), numEntete) == -1)
+        return ERROR_WRITE;
+
+    return 0; //renvoyer 0 si succés
+}
+
+
+
+/******************************************TAILLE FICHIER***************************************/
+
+/**
+ * @brief Calcule la taille du fichier.
+ *
+ * Cette fonction calcule la taille du fichier en fonction du nombre de blocs de données qu'il occupe réellement (trous exclus).
+ * Le tampon d'écriture du descripteur est d'abord vidé (voir myFlush), ses données devant occuper leurs blocs.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @return La taille du fichier en octets.
+ *         En cas d'erreur, la fonction renvoie une valeur négative correspondant à un code d'erreur spécifique.
+ */
+int size(file* f){
+	blocEntete buff;
+
+	if (f== NULL)
+		return ERROR_OTHER;
+	if (myFlush(f) < 0)
+		return ERROR_WRITE;
+
+	off_t offset_entete = f->numEntete;
+
+        //lire le bloc d'entete du fichier
+        if (lireEntete(f->part, &buff, offset_entete) == -1)
+        	return ERROR_READ;
+
+        //calculer la taille (les trous n'occupent aucun bloc)
+        int sizeFile = buff.nbBlocsAlloues*f->part->sb.tailleBloc;
+
+        return sizeFile;
+}
+
+
+/**
+ * \brief Calcule la taille réelle d'un fichier.
+ *
+ * Cette fonction renvoie la taille logique du fichier (nombre de caractères jusqu'au dernier
+ * caractère écrit), lue dans son entête.
+ *
+ * \param f Un pointeur vers une structure de fichier contenant les informations nécessaires.
+ * \return La taille réelle du fichier en nombre de caractères, ou 0 si le fichier est vide,
+ *         ou une valeur d'erreur si une erreur s'est produite lors de la lecture de l'entête.
+ *         Les valeurs d'erreur possibles sont définies dans le fichier d'en-tête correspondant.
+ */
+int getSizeReelFile(file* f){
+    if (f == NULL)
+        return ERROR_OTHER;
+    return getPosLastCharFile(f);
+}
+
+/***********************************************************************************************/
+/*                          FONCTIONS PRINCIPALES                                              */
+/***********************************************************************************************/
+/************************MyFormat*******************************/
+
+/**
+ * \brief Fonction pour formater une partition et initialiser un répertoire vide.
+ *
+ * \param partitionName Le nom de la partition à formater.
+ * \param tailleBloc La taille en octets des blocs (puissance de 2 entre TAILLE_BLOC_MIN et TAILLE_BLOC_MAX, 0 pour TAILLE_BLOC_DEFAUT).
+ * \return 0 si le formattage est réussi, sinon un code d'erreur.
+ *
+ * Cette fonction tente de créer un fichier représentant la partition spécifiée. Si le fichier existe déjà,
+ * il ouvre le fichier existant. Sinon, il crée un nouveau fichier et y écrit le super bloc (qui mémorise
+ * la taille des blocs) suivi de la racine (feuille vide) du répertoire en arbre B+ et de la zone
+ * (TAILLE_JOURNAL octets) du journal des métadonnées.
+ *
+ * \note Cette fonction utilise les fonctions open et pwrite pour manipuler les fichiers.
+ *
+ * La partition doit ensuite être montée avec myMount pour être utilisée.
+ *
+ * \warning Assurez-vous d'avoir les permissions nécessaires pour créer et écrire dans le fichier spécifié.
+ *
+ * \see superBloc
+ */
+int myFormat(char* partitionName, int tailleBloc){
+    //initialiser un super bloc et un répertoire vide
+    superBloc sb;
+    noeudRepertoire racine;
+
+    //la taille des blocs doit etre une puissance de 2 comprise entre TAILLE_BLOC_MIN et TAILLE_BLOC_MAX
+    if (tailleBloc == 0) tailleBloc = TAILLE_BLOC_DEFAUT;
+    if (tailleBloc < TAILLE_BLOC_MIN || tailleBloc > TAILLE_BLOC_MAX || (tailleBloc & (tailleBloc - 1)) != 0) {
+        fprintf(stderr, "Taille de bloc invalide : %d (puissance de 2 entre %d et %d attendue).\n",
+                tailleBloc, TAILLE_BLOC_MIN, TAILLE_BLOC_MAX);
+        return ERROR_OTHER;
+    }
+
+
+    //essayer de creer le fichier representant la partition
+    int fd = open(partitionName, O_CREAT | O_EXCL | O_RDWR, 0777);
+
+    if (fd == -1) {
+        //en cas d'erreur car fichier existe deja
+        if (errno == EEXIST) {
+            //fichier de la partition existe deja : elle est conservée telle quelle
+            printf("Formatage d'une partition qui existe deja (son contenu et sa taille de bloc sont conservés)...\n");
+            printf("formattage réussi.\n");
+            return 0;
+        } else {
+            //erreur
+            perror("Erreur lors du formattage de la partition.\n");
+            return ERROR_OPEN;
+        }
+    } else {
+        //Partition créée
+
+        //le super bloc occupe les TAILLE_NOEUD premiers octets, arrondis à un nombre entier de blocs
+        off_t tailleZoneSb = ((off_t)TAILLE_NOEUD + tailleBloc - 1) / tailleBloc * tailleBloc;
+        //la racine (feuille vide) du répertoire suit le super bloc
+        memset(&sb, 0, sizeof(superBloc));
+        sb.magic = MAGIC_PARTITION;
+        sb.version = VERSION_PARTITION;
+        sb.nbFichiers = 0;
+        sb.hauteur = 1;
+        sb.tailleBloc = tailleBloc;
+        sb.racine = tailleZoneSb;
+        //aucun espace libre : la table des unités libres (vide) est à jour
+        sb.bitmap = -1;
+        sb.tailleBitmap = 0;
+        sb.bitmapValide = 1;
+        //aucun bloc partagé, aucun instantané
+        sb.partages = -1;
+        sb.taillePartages = 0;
+        sb.instantanes = -1;
+        sb.nbInstantanes = 0;
+        //le journal des métadonnées (vide) suit la racine
+        sb.journal = sb.racine + ((off_t)TAILLE_NOEUD + tailleBloc - 1) / tailleBloc * tailleBloc;
+        sb.tailleJournal = TAILLE_JOURNAL;
+        sb.sequenceJournal = 1;
+        //ecriture du super bloc
+        if (pwrite(fd, &sb, sizeof(superBloc), 0) == -1) {
+            close(fd);
+            return ERROR_WRITE;
+        }
+        //ecriture de la racine du répertoire
+        memset(&racine, 0, sizeof(noeudRepertoire));
+        racine.estFeuille = 1;
+        racine.nbCles = 0;
+        racine.suiv = -1;
+        if (pwrite(fd, &racine, sizeof(noeudRepertoire), sb.racine) == -1) {
+            close(fd);
+            return ERROR_WRITE;
+        }
+        //réservation du journal (lu comme des zéros : aucune transaction)
+        if (ftruncate(fd, sb.journal + sb.tailleJournal) == -1) {
+            close(fd);
+            return ERROR_WRITE;
+        }
+        if (close(fd) == -1) return ERROR_OTHER;
+
+        printf("Partition formattée et répertoire initialisé avec succés.\n");
+        return 0;
+    }
+}
+
+/*********************************MyMount / MyUnmount**********************/
+
+/**
+ * @brief Monte une partition existante.
+ *
+ * Le super bloc est lu une seule fois ; les noeuds du répertoire sont ensuite servis par le cache de noeuds.
+ * Si la partition n'a pas été démontée proprement, les transactions validées du journal des métadonnées
+ * sont d'abord rejouées (voir rejouerJournal). La partition montée est le contexte à passer à myOpen ; plusieurs partitions peuvent être montées à la fois.
+ *
+ * En mode BACKEND_MMAP la partition est projetée en mémoire : les lectures et écritures deviennent
+ * des copies mémoire, sans appel système par bloc. La projection est agrandie par pas de PAS_PROJECTION.
+ * En mode BACKEND_RW, un cache de blocs de TAILLE_CACHE_DEFAUT octets est créé (voir configurerCache).
+ *
+ * @param partitionName Le nom de la partition à monter.
+ * @param backend Le mode d'accès : BACKEND_RW (pread / pwrite) ou BACKEND_MMAP.
+ * @return Un pointeur vers la partition montée, NULL en cas d'erreur.
+ */
+partition* myMount(char* partitionName, int backend) {
+    int fdPartition = open(partitionName, O_RDWR);
+    if (fdPartition == -1) {
+        perror("Erreur d'ouverture de la partition");
+        return NULL;
+    }
+    partition* p = chargerPartition(fdPartition);
+    if (p == NULL) {
+        perror("Erreur de lecture du super bloc");
+        close(fdPartition);
+        return NULL;
+    }
+    if (rejouerJournal(p) < 0 || initialiserJournal(p) < 0) {
+        perror("Erreur de rejeu du journal des métadonnées");
+        myUnmount(p);
+        return NULL;
+    }
+    if (backend == BACKEND_MMAP) {
+        //projection de toute la partition, arrondie au pas d'agrandissement
+        off_t taille = (p->finPartition + PAS_PROJECTION - 1) / PAS_PROJECTION * PAS_PROJECTION;
+        if (ftruncate(fdPartition, taille) == -1) {
+            perror("Erreur d'agrandissement de la partition");
+            myUnmount(p);
+            return NULL;
+        }
+        p->projection = mmap(NULL, taille, PROT_READ | PROT_WRITE, MAP_SHARED, fdPartition, 0);
+        if (p->projection == MAP_FAILED) {
+            perror("Erreur de projection de la partition");
+            p->projection = NULL;
+            myUnmount(p);
+            return NULL;
+        }
+        p->tailleProjection = taille;
+        p->backend = BACKEND_MMAP;
+    }
+    if (configurerCache(p, TAILLE_CACHE_DEFAUT) < 0) {
+        perror("Erreur d'allocation du cache de blocs");
+        myUnmount(p);
+        return NULL;
+    }
+    if (chargerBitmap(p) < 0) {
+        perror("Erreur de chargement de la table des unités libres");
+        myUnmount(p);
+        return NULL;
+    }
+    demarrerValidateur(p);
+    return p;
+}
+
+
+/**
+ * @brief Démonte une partition : réécrit les noeuds du répertoire modifiés, libère la projection éventuelle puis ferme la partition.
+ *
+ * Les métadonnées sont validées puis synchronisées : au prochain montage, le journal n'est pas rejoué.
+ *
+ * L'espace libre situé à la fin de la partition lui est retiré : la partition est ramenée
+ * à la fin du dernier espace occupé. Aucune autre opération ne doit être en cours sur la partition.
+ *
+ * @param p La partition montée (NULL accepté).
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int myUnmount(partition* p) {
+    if (p == NULL)
+        return 0;
+
+    //plus de validation en arrière-plan : la dernière est faite ici
+    arreterValidateur(p);
+    //les opérations asynchrones en vol s'achèvent avant l'écriture des métadonnées
+    int retMoteur = arreterMoteur(p);
+    free(p->moteur.requetes);
+
+    //l'espace libéré par les dernières opérations devient réutilisable
+    int ret = validerJournal(p);
+
+    //rendre l'espace libre de fin de partition
+    off_t tailleBloc = p->sb.tailleBloc;
+    while (p->nbUnitesLibres > 0 && estUniteLibre(p, p->finPartition / tailleBloc - 1)) {
+        marquerUnites(p, p->finPartition / tailleBloc - 1, 1, false);
+        p->finPartition -= tailleBloc;
+        invaliderBitmap(p);
+    }
+
+    if (ret == 0) ret = flushIndex(p);
+    if (retMoteur < 0 && ret == 0) ret = ERROR_WRITE;
+    if (p->projection != NULL && msync(p->projection, p->tailleProjection, MS_SYNC) == -1 && ret == 0) ret = ERROR_WRITE;
+    //les métadonnées appliquées en place sont durables : le journal n'a plus rien à rejouer
+    if (ret == 0 && fsync(p->fd) == -1) ret = ERROR_WRITE;
+    if (fermerJournal(p) < 0 && ret == 0) ret = ERROR_WRITE;
+    if (p->projection != NULL)
+        munmap(p->projection, p->tailleProjection);
+    //la partition est ramenée à la fin de l'espace alloué (la projection l'a agrandie par pas)
+    if (ftruncate(p->fd, p->finPartition) == -1 && ret == 0) ret = ERROR_WRITE;
+    if (close(p->fd) == -1 && ret == 0) ret = ERROR_OTHER;
+    configurerCache(p, 0);
+    free(p->bitmapLibre);
+    free(p->partages);
+    free(p->cacheNoeuds);
+    pthread_mutex_destroy(&p->verrou);
+    pthread_rwlock_destroy(&p->verrouCopies);
+    pthread_rwlock_destroy(&p->verrouJournal);
+    pthread_rwlock_destroy(&p->verrouProjection);
+    while (p->fichiersOuverts != NULL) {
+        fichierOuvert* o = p->fichiersOuverts;
+        p->fichiersOuverts = o->suivant;
+        pthread_rwlock_destroy(&o->verrou);
+        free(o);
+    }
+    while (p->statsThreads != NULL) {
+        statsThread* t = p->statsThreads;
+        p->statsThreads = t->suivant;
+        free(t);
+    }
+    pthread_mutex_destroy(&p->verrouStats);
+    free(p->trace.lentes);
+    pthread_mutex_destroy(&p->trace.verrou);
+    free(p);
+    return ret;
+}
+
+/*********************************MyOpen***********************************/
+///////////////file * myOpen(char* fileName);///////////////////////////////////////////////
+
+/**
+ * @brief Rattache un descripteur au fichier ouvert de son entête, créé pour le premier descripteur.
+ *
+ * Le verrou de la partition doit être pris.
+ *
+ * @param f Le descripteur (numEntete renseigné).
+ * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur d'allocation.
+ */
+static int rattacherFichierOuvert(file* f) {
+    partition* p = f->part;
+    fichierOuvert* o = p->fichiersOuverts;
+    while (o != NULL && o->numEntete != f->numEntete)
+        o = o->suivant;
+    if (o == NULL) {
+        o = malloc(sizeof(fichierOuvert));
+        if (o == NULL)
+            return ERROR_OTHER;
+        o->numEntete = f->numEntete;
+        o->nbDescripteurs = 0;
+        o->version = 0;
+        initialiserVerrouLecteurs(&o->verrou);
+        o->suivant = p->fichiersOuverts;
+        p->fichiersOuverts = o;
+    }
+    o->nbDescripteurs++;
+    f->ouvert = o;
+    //les écritures changent la version sous le seul verrou du fichier
+    f->versionBlocs = __atomic_load_n(&o->version, __ATOMIC_RELAXED);
+    return 0;
+}
+
+
+/**
+ * @brief Détache un descripteur de son fichier ouvert, libéré avec le dernier descripteur.
+ */
+static void detacherFichierOuvert(file* f) {
+    partition* p = f->part;
+    if (f->ouvert == NULL)
+        return;
+    pthread_mutex_lock(&p->verrou);
+    if (--f->ouvert->nbDescripteurs == 0) {
+        fichierOuvert** lien = &p->fichiersOuverts;
+        while (*lien != f->ouvert)
+            lien = &(*lien)->suivant;
+        *lien = f->ouvert->suivant;
+        pthread_rwlock_destroy(&f->ouvert->verrou);
+        free(f->ouvert);
+    }
+    f->ouvert = NULL;
+    pthread_mutex_unlock(&p->verrou);
+}
+
+
+/**
+ * @brief Indique si des descripteurs sont ouverts sur le fichier dont l'entête est à offsetEntete.
+ *
+ * Le verrou de la partition doit être pris. Un fichier ouvert ne peut être ni supprimé ni remplacé :
+ * ses descripteurs écriraient dans des blocs rendus à la table des unités libres.
+ */
+static bool estFichierOuvert(partition* p, off_t offsetEntete) {
+    for (fichierOuvert* o = p->fichiersOuverts; o != NULL; o = o->suivant)
+        if (o->numEntete == offsetEntete && o->nbDescripteurs > 0)
+            return true;
+    return false;
+}
+
+
+/**
+ * @brief Recharge la table des blocs d'un descripteur si un autre descripteur a modifié le fichier depuis.
+ *
+ * Le verrou du fichier doit être pris.
+ *
+ * @return 0 en cas de succès, ERROR_READ sinon.
+ */
+static int actualiserTableBlocs(file* f) {
+    if (f->versionBlocs == f->ouvert->version)
+        return 0;
+    if (chargerTableBlocs(f) < 0) return ERROR_READ;
+    f->versionBlocs = f->ouvert->version;
+    return 0;
+}
+
+
+/**
+ * @brief Prend le verrou d'un fichier en lecture : les autres lectures du fichier restent possibles.
+ *
+ * @return 0 en cas de succès (le verrou est pris), une valeur d'erreur sinon.
+ */
+static int verrouillerLecture(file* f) {
+    pthread_rwlock_rdlock(&f->ouvert->verrou);
+    debuterInstrumentation(f);
+    if (actualiserTableBlocs(f) < 0) {
+        terminerInstrumentation(f);
+        pthread_rwlock_unlock(&f->ouvert->verrou);
+        return ERROR_READ;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Rend le verrou pris par verrouillerLecture.
+ */
+static void deverrouillerLecture(file* f) {
+    terminerInstrumentation(f);
+    pthread_rwlock_unlock(&f->ouvert->verrou);
+}
+
+
+/**
+ * @brief Prend le verrou d'un fichier en écriture : les lectures et les autres écritures du fichier attendent.
+ *
+ * Le verrou de la partition n'est pas pris : les écritures ne le prennent qu'autour des
+ * modifications des métadonnées, de l'espace libre et du journal (voir ecrireFichier).
+ *
+ * @return 0 en cas de succès (le verrou est pris), une valeur d'erreur sinon.
+ */
+static int verrouillerEcriture(file* f) {
+    pthread_rwlock_wrlock(&f->ouvert->verrou);
+    debuterInstrumentation(f);
+    if (actualiserTableBlocs(f) < 0) {
+        terminerInstrumentation(f);
+        pthread_rwlock_unlock(&f->ouvert->verrou);
+        return ERROR_READ;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Rend le verrou pris par verrouillerEcriture ; la table des blocs des autres descripteurs du fichier devient périmée.
+ */
+static void deverrouillerEcriture(file* f) {
+    terminerInstrumentation(f);
+    f->versionBlocs = __atomic_add_fetch(&f->ouvert->version, 1, __ATOMIC_RELAXED);
+    pthread_rwlock_unlock(&f->ouvert->verrou);
+}
+
+
+/**
+ * @brief Crée un descripteur (position 0, table des blocs chargée) sur le fichier dont l'entête est à offsetEntete.
+ *
+ * Le verrou de la partition doit être pris.
+ *
+ * @param p La partition montée contenant le fichier.
+ * @param offsetEntete L'offset de l'entête du fichier.
+ * @return Un pointeur vers la structure file, NULL en cas d'erreur.
+ */
+static file* ouvrirDescripteur(partition* p, off_t offsetEntete) {
+    file *f = malloc(sizeof(file));
+    if (f == NULL) {
+        perror("Erreur d'allocation de mémoire");
+        return NULL;
+    }
+    f->part = p;
+    f->numEntete = offsetEntete;
+    f->pos = 0;
+    f->tabBlocs = NULL;
+    f->nbBlocsCharges = 0;
+    f->capaciteBlocs = 0;
+    f->tampon = NULL;
+    f->debutTampon = 0;
+    f->nbTampon = 0;
+    f->finLecture = -1;
+    f->fenetreLecture = 0;
+    f->blocAnticipe = 0;
+    f->lectureSeule = false;
+    f->ouvert = NULL;
+    memset(&f->stats, 0, sizeof(statsES));
+    //construire la table des blocs du fichier
+    if (rattacherFichierOuvert(f) < 0 || chargerTableBlocs(f) < 0) {
+        perror("Erreur de chargement de la table des blocs");
+        myClose(f);
+        return NULL;
+    }
+
+    return f;
+}
+
+
+
+/**
+ * @brief Ouvre un fichier, créé s'il n'existe pas (voir myOpen). Le verrou de la partition doit être pris.
+ */
+static file* ouvrirFichier(partition* p, char* fileName) {
+    off_t offsetEntete;
+
+    // Rechercher le fichier dans le répertoire
+    offsetEntete = rechercheRepertoire(p, fileName);
+    if (offsetEntete < -1) {
+        perror("Erreur de lecture du répertoire\n");
+        return NULL;
+    }
+
+    // Si le fichier n'existe pas, le créer
+    if (offsetEntete == -1) {
+        // Initialiser le bloc d'entête
+        blocEntete entete;
+        strcpy(entete.nomFichier, fileName);
+        entete.nbBlocs = 0;
+        entete.numTete = -1;
+        entete.nbExtents = 0;
+        entete.numExtentsSuiv = -1;
+        entete.taille = 0;
+        entete.numQueue = -1;
+        entete.nbBlocsAlloues = 0;
+
+
+    // Écrire le bloc d'entête à la fin de la partition
+        offsetEntete=allouerEspace(p, sizeof(struct blocEntete)); //Reserver un bloc à la fin de la partition
+        if (offsetEntete<0 || ecrireMetadonnees(p, &entete, sizeof(struct blocEntete), offsetEntete) == -1) { //Ecrire l'entete
+            perror("Erreur d'écriture du bloc d'entête\n");
+            return NULL;
+        }
+
+        // Ajouter le fichier au répertoire (les noeuds modifiés restent dans le cache jusqu'au flushIndex / myUnmount)
+        elemTabIndex element;
+        strcpy(element.nomFichier, fileName);
+        element.numBlocEntete = offsetEntete;
+        if (insererRepertoire(p, element) < 0) {
+            perror("Erreur d'insertion dans le répertoire");
+            return NULL;
+        }
+        if (finOperationJournal(p) < 0) {
+            perror("Erreur de validation du journal");
+            return NULL;
+        }
+    }
+
+    // Ouvrir le fichier (qu'il soit nouveau ou existant)
+    return ouvrirDescripteur(p, offsetEntete);
+}
+
+
+/**
+ * @brief Ouvre un fichier et retourne une structure file contenant les informations nécessaires.
+ *
+ * La recherche se fait dans le répertoire en arbre B+ de la partition p. À la création
+ * d'un fichier, seuls les noeuds modifiés du répertoire sont marqués pour être réécrits plus tard.
+ *
+ * @param p La partition montée contenant le fichier.
+ * @param fileName Le nom du fichier à ouvrir.
+ * @return Un pointeur vers la structure file si le fichier est ouvert avec succès, NULL sinon.
+ */
+file * myOpen(partition* p, char* fileName) {
+    if (p == NULL) {
+        perror("Aucune partition montée\n");
+        return NULL;
+    }
+    long debut = debuterChrono(p);
+    //la création d'un fichier par un autre thread ne peut pas s'intercaler entre la recherche et l'insertion
+    pthread_mutex_lock(&p->verrou);
+    file* f = ouvrirFichier(p, fileName);
+    pthread_mutex_unlock(&p->verrou);
+    terminerChrono(p, TRACE_OPEN, debut, f == NULL ? ERROR_OPEN : 0);
+    return f;
+}
+
+
+/*********************************MyWrite**********************************/
+
+/**
+ * @brief Propose un offset pour allouer le bloc numéro blocNumber d'un fichier.
+ *
+ * L'offset proposé suit le dernier bloc alloué qui précède blocNumber dans le fichier (ou
+ * l'entête si le fichier n'a aucun bloc avant), afin que les blocs restent contigus.
+ * La table des blocs du descripteur doit être chargée.
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @param blocNumber Le numéro du bloc à allouer.
+ * @param nbBlocs Le nombre de blocs logiques du fichier.
+ * @return L'offset souhaité pour le bloc.
+ */
+static off_t offsetSouhaiteBloc(file* f, int blocNumber, int nbBlocs) {
+    off_t tailleBloc = f->part->sb.tailleBloc;
+    int i = (blocNumber <= nbBlocs ? blocNumber : nbBlocs + 1) - 2;
+
+    while (i >= 0 && f->tabBlocs[i] == BLOC_TROU) i--;
+    if (i >= 0)
+        return f->tabBlocs[i] + tailleBloc;
+    return f->numEntete + ((off_t)sizeof(struct blocEntete) + tailleBloc - 1) / tailleBloc * tailleBloc;
+}
+
+
+/**
+ * @brief Les blocs alloués par une écriture, en attendant qu'ils soient enregistrés dans les extents (voir enregistrerAllocation).
+ */
+typedef struct allocationEcriture{
+    off_t* nouveaux; //les blocs alloués (trous comblés, blocs ajoutés, copies de blocs partagés)
+    int nbNouveaux;
+    off_t* remplaces; //les blocs partagés remplacés par une copie
+    int nbRemplaces;
+    int nbBlocsAvant; //le nombre de blocs décrits par les extents avant l'écriture
+    bool tableModifiee; //vrai si un trou a été comblé ou un bloc partagé remplacé
+}allocationEcriture;
+
+
+/**
+ * @brief Renvoie l'offset du bloc numéro blocNumber d'un fichier en vue d'y écrire, en l'allouant s'il n'existe pas.
+ *
+ * Un bloc n'est alloué que lorsqu'il reçoit des données. Il est pris de préférence à
+ * offsetSouhaite et noté dans la table des blocs du descripteur (les blocs sautés après le dernier
+ * bloc y sont des trous), mais pas encore dans les extents : ceux-ci ne sont mis à jour qu'une fois
+ * les données écrites (voir enregistrerAllocation), si bien qu'une transaction validée entre temps par
+ * un autre thread ne référence jamais un bloc dont le contenu n'est pas écrit.
+ * Un bloc partagé avec un autre fichier (myClone) est copié sur écriture : un nouveau bloc le
+ * remplace dans la table des blocs et l'ancien ne perdra sa référence qu'à l'enregistrement ; c'est à
+ * l'appelant de recopier l'ancien contenu (*origine) s'il ne recouvre pas tout le bloc.
+ * La table des blocs du descripteur doit être chargée et le verrou de la partition pris.
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @param blocNumber Le numéro du bloc.
+ * @param offsetSouhaite L'offset souhaité en cas d'allocation.
+ * @param nbBlocs En entrée et en sortie, le nombre de blocs logiques du fichier.
+ * @param a Reçoit le bloc alloué et, après une copie sur écriture, le bloc remplacé.
+ * @param blocNeuf En sortie, vrai si le bloc vient d'être alloué (son contenu est à écrire entièrement).
+ * @param origine En sortie, l'offset où lire le contenu actuel du bloc (différent du bloc renvoyé après une copie sur écriture).
+ * @return L'offset du bloc, une valeur d'erreur sinon.
+ */
+static off_t blocPourEcriture(file* f, int blocNumber, off_t offsetSouhaite, int* nbBlocs, allocationEcriture* a, bool* blocNeuf, off_t* origine) {
+    partition* p = f->part;
+    off_t offsetBloc = blocNumber <= *nbBlocs ? f->tabBlocs[blocNumber - 1] : BLOC_TROU;
+
+    *blocNeuf = false;
+    *origine = offsetBloc;
+    if (offsetBloc != BLOC_TROU && !estBlocPartage(p, offsetBloc))
+        return offsetBloc;
+
+    offsetBloc = allouerEspaceProche(p, p->sb.tailleBloc, offsetSouhaite);
+    if (offsetBloc < 0) return offsetBloc;
+    a->nouveaux[a->nbNouveaux++] = offsetBloc;
+
+    if (*origine != BLOC_TROU) {
+        //copie sur écriture : l'ancien bloc reste aux autres fichiers qui le partagent
+        a->remplaces[a->nbRemplaces++] = *origine;
+        f->tabBlocs[blocNumber - 1] = offsetBloc;
+        a->tableModifiee = true;
+        return offsetBloc;
+    }
+
+    *blocNeuf = true;
+    if (blocNumber > *nbBlocs) {
+        //bloc ajouté après le dernier bloc (la table couvre alors exactement nbBlocs blocs)
+        while (f->nbBlocsCharges < blocNumber - 1)
+            if (ajouterTableBlocs(f, BLOC_TROU) < 0) return ERROR_OTHER;
+        if (ajouterTableBlocs(f, offsetBloc) < 0) return ERROR_OTHER;
+        *nbBlocs = blocNumber;
+    } else {
+        f->tabBlocs[blocNumber - 1] = offsetBloc;
+        a->tableModifiee = true;
+    }
+    return offsetBloc;
+}
+
+
+/**
+ * @brief Enregistre dans les extents les blocs alloués par une écriture, une fois leurs données écrites.
+ *
+ * Les blocs ajoutés après le dernier bloc prolongent les extents (voir ajouterExtentFile) ; si un trou
+ * a été comblé ou un bloc partagé remplacé, les extents sont réécrits et les blocs remplacés perdent
+ * une référence. Si l'écriture a échoué, les blocs alloués sont libérés et la table des blocs est
+ * rechargée depuis les extents, qui n'ont pas changé.
+ * Le verrou de la partition doit être pris.
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @param a Les blocs alloués et remplacés par l'écriture (voir blocPourEcriture).
+ * @param nbBlocs Le nombre de blocs logiques du fichier après l'écriture.
+ * @param reussie Vrai si les données ont été écrites.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int enregistrerAllocation(file* f, allocationEcriture* a, int nbBlocs, bool reussie) {
+    partition* p = f->part;
+
+    if (!reussie) {
+        for (int i = 0; i < a->nbNouveaux; i++)
+            libererEspace(p, a->nouveaux[i], p->sb.tailleBloc);
+        return chargerTableBlocs(f);
+    }
+
+    for (int i = 0; i < a->nbRemplaces; i++)
+        libererEspace(p, a->remplaces[i], p->sb.tailleBloc);
+    if (a->tableModifiee)
+        return reecrireExtents(f, f->tabBlocs, nbBlocs) < 0 ? ERROR_WRITE : 0;
+    for (int i = a->nbBlocsAvant; i < nbBlocs; i++)
+        if (f->tabBlocs[i] != BLOC_TROU && ajouterExtentFile(f, i + 1, f->tabBlocs[i]) < 0) return ERROR_WRITE;
+    return 0;
+}
+
+
+/**
+ * @brief Efface les caractères qui suivent la position taille dans le bloc de données qui la contient (s'il est alloué).
+ *
+ * Ce bloc peut contenir des caractères au-delà de la taille validée dans le journal (fin d'un
+ * fichier raccourci par myTruncate, ou écrite avant un arrêt brutal) : ils ne doivent pas
+ * réapparaître quand le fichier s'allonge. Le bloc n'est effacé qu'au moment de l'allonger, au-delà
+ * de la taille validée : un arrêt brutal avant la validation de la nouvelle taille ne change donc pas
+ * le contenu lisible du fichier. Un bloc partagé est d'abord remplacé par une copie. Le verrou de la
+ * partition doit être pris.
+ *
+ * @param f Un pointeur vers une structure de fichier (table des blocs chargée).
+ * @param taille La position à partir de laquelle le bloc est effacé (la taille validée du fichier).
+ * @param nbBlocs Le nombre de blocs logiques du fichier.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int effacerFinBloc(file* f, int taille, int nbBlocs) {
+    partition* p = f->part;
+    int charsParBloc = p->charsParBloc;
+    int numero = (taille + charsParBloc - 1) / charsParBloc;
+
+    if (numero == 0 || numero > nbBlocs || f->tabBlocs[numero - 1] == BLOC_TROU)
+        return 0;
+    off_t nouveau, remplace;
+    allocationEcriture a = {&nouveau, 0, &remplace, 0, nbBlocs, false};
+    bool blocNeuf;
+    off_t origine;
+    off_t offsetBloc = blocPourEcriture(f, numero, offsetSouhaiteBloc(f, numero, nbBlocs),
+                                        &nbBlocs, &a, &blocNeuf, &origine);
+    if (offsetBloc < 0) {
+        enregistrerAllocation(f, &a, nbBlocs, false);
+        return offsetBloc;
+    }
+    int reste = taille - (numero - 1) * charsParBloc;
+    blocData* bloc = alloc_bloc(p);
+    int ret = bloc == NULL ? ERROR_OTHER : lireBlocData(p, origine, bloc);
+    if (ret == 0) {
+        memset(bloc->donnee + reste, 0, charsParBloc - reste);
+        ret = ecrireBlocData(p, offsetBloc, bloc);
+    }
+    free(bloc);
+    if (enregistrerAllocation(f, &a, nbBlocs, ret == 0) < 0 && ret == 0)
+        ret = ERROR_WRITE;
+    return ret;
+}
+
+
+/**
+ * @brief Alloue (voir blocPourEcriture) les blocs numéros premier à dernier d'un fichier, dans l'ordre, en vue d'y écrire.
+ *
+ * Chaque bloc est pris de préférence à la suite du précédent. La table des blocs du descripteur doit
+ * être chargée et le verrou de la partition pris.
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @param premier Le numéro du premier bloc.
+ * @param dernier Le numéro du dernier bloc.
+ * @param nbBlocs En entrée et en sortie, le nombre de blocs logiques du fichier.
+ * @param a Reçoit les blocs alloués et remplacés.
+ * @param neuf En sortie, pour le premier et le dernier bloc : vrai si le bloc vient d'être alloué.
+ * @param origine En sortie, pour le premier et le dernier bloc : l'offset où lire son contenu actuel.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int allouerBlocsEcriture(file* f, int premier, int dernier, int* nbBlocs, allocationEcriture* a, bool neuf[2], off_t origine[2]) {
+    off_t offsetSouhaite = offsetSouhaiteBloc(f, premier, *nbBlocs);
+
+    for (int numero = premier; numero <= dernier; numero++) {
+        bool blocNeuf;
+        off_t blocOrigine;
+        off_t offsetBloc = blocPourEcriture(f, numero, offsetSouhaite, nbBlocs, a, &blocNeuf, &blocOrigine);
+        if (offsetBloc < 0) return offsetBloc;
+        if (numero == premier) {
+            neuf[0] = blocNeuf;
+            origine[0] = blocOrigine;
+        }
+        if (numero == dernier) {
+            neuf[1] = blocNeuf;
+            origine[1] = blocOrigine;
+        }
+        offsetSouhaite = offsetBloc + f->part->sb.tailleBloc;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Écrit des données dans un fichier à la position courante, sans passer par le tampon d'écriture du descripteur.
+ *
+ * L'écriture se fait par tranches de bloc : chaque bloc touché reçoit un seul memcpy puis une seule écriture.
+ * Le champ nbChars d'un bloc est le nombre de caractères depuis le début du bloc jusqu'au dernier
+ * caractère écrit ; il est mis à jour par arithmétique sur la tranche écrite.
+ *
+ * Seuls les blocs qui reçoivent des données sont alloués : écrire au-delà de la fin du fichier
+ * laisse un trou (non alloué, lu comme des caractères nuls) entre l'ancienne fin et la position d'écriture.
+ *
+ * La fonction myWrite effectue les opérations suivantes :
+ * 1. Sous le verrou de la partition : allouer les blocs touchés qui n'existent pas (de préférence à la
+ *    suite les uns des autres) et remplacer par une copie ceux qui sont partagés (voir blocPourEcriture).
+ * 2. Sans le verrou de la partition, pour chaque bloc touché :
+ *    - si la tranche ne couvre pas tout le bloc et que le bloc existait, le lire ;
+ *    - copier la tranche (memcpy) et mettre à jour nbChars et suiv ;
+ *    - écrire le bloc en une seule fois.
+ * 3. Sous le verrou de la partition : enregistrer les blocs alloués dans les extents (voir
+ *    enregistrerAllocation), mettre à jour la position courante dans le fichier et, si elle la
+ *    dépasse, la taille logique de l'entête.
+ * Le verrou des copies est pris en lecture tout du long : myCopy, myClone et mySnapshot ne voient pas
+ * une écriture à moitié faite, et aucun bloc ne devient partagé pendant qu'il est écrit sur place.
+ * L'appelant termine l'opération dans le journal des métadonnées (voir finEcritureJournal).
+ *
+ * @param f Un pointeur vers une structure de fichier (verrouillé en écriture).
+ * @param source Les données à écrire (curseur sur un vecteur, avancé de size octets).
+ * @param size La taille des données à écrire (strictement positive).
+ * @param jeton -1 pour une écriture synchrone ; sinon la requête asynchrone (myWriteAsync) dont le
+ * tampon reçoit les blocs composés, confiés au moteur d'entrées / sorties au lieu d'être écrits.
+ * @return Le nombre de caractères écrits, une valeur d'erreur sinon.
+ */
+static int ecrireFichier(file* f, curseurVecteur* source, int size, int jeton) {
+    partition* p = f->part;
+    off_t tailleBloc = p->sb.tailleBloc;
+    int charsParBloc = p->charsParBloc;
+    bool neuf[2] = {false, false}; //vrai si le premier (le dernier) bloc vient d'etre alloué
+    off_t origine[2]; //offset du contenu actuel du premier (du dernier) bloc (bloc partagé copié sur écriture)
+
+    // Trouver les blocs touchés et la position d'insertion dans le premier
+    int premier = trouverBlocData(f->pos, charsParBloc);
+    int dernier = trouverBlocData(f->pos + size - 1, charsParBloc);
+    int positionInBloc = trouverPosition(f->pos, charsParBloc);
+    int nbTouches = dernier - premier + 1;
+
+    off_t* blocsAlloues = malloc(2 * (size_t)nbTouches * sizeof(off_t));
+    blocData* blocAlloue = jeton < 0 ? alloc_bloc(p) : NULL;
+    if (blocsAlloues == NULL || (jeton < 0 && blocAlloue == NULL)) {
+        free(blocsAlloues);
+        free(blocAlloue);
+        return ERROR_OTHER;
+    }
+    allocationEcriture a = {blocsAlloues, 0, blocsAlloues + nbTouches, 0, 0, false};
+
+    //1- allocation des blocs
+    pthread_rwlock_rdlock(&p->verrouCopies);
+    pthread_mutex_lock(&p->verrou);
+    //Lire l'entete du fichier (nombre de blocs et taille logique) et s'assurer que la table des blocs est chargée
+    blocEntete be;
+    int nbBlocs = 0;
+    int ret = lireEntete(p, &be, f->numEntete) == -1 ? ERROR_READ : 0;
+    if (ret == 0) {
+        nbBlocs = be.nbBlocs;
+        a.nbBlocsAvant = nbBlocs;
+        if (f->nbBlocsCharges != nbBlocs && chargerTableBlocs(f) < 0) ret = ERROR_READ;
+    }
+    //écriture au-delà de la fin : l'intervalle laissé entre les deux doit se lire comme des zéros
+    if (ret == 0 && f->pos > be.taille && be.taille % charsParBloc != 0 && effacerFinBloc(f, be.taille, nbBlocs) < 0)
+        ret = ERROR_WRITE;
+    if (ret == 0)
+        ret = allouerBlocsEcriture(f, premier, dernier, &nbBlocs, &a, neuf, origine);
+    //écriture asynchrone : chaque bloc est composé dans le tampon de la requête, qu'il occupe jusqu'à l'achèvement
+    char* tampon = jeton < 0 ? NULL : p->moteur.requetes[jeton].tampon;
+    pthread_mutex_unlock(&p->verrou);
+
+    //2- composition et écriture des blocs, hors du verrou de la partition
+    int nbEcrits = 0;
+    for (int numero = premier; numero <= dernier && ret == 0; numero++) {
+        blocData* bloc = jeton < 0 ? blocAlloue : (blocData*)(tampon + (off_t)(numero - premier) * tailleBloc);
+        // taille de la tranche à ecrire dans le bloc
+        int n = charsParBloc - positionInBloc;
+        if (n > size - nbEcrits) n = size - nbEcrits;
+
+        //seuls le premier et le dernier bloc peuvent ne recevoir qu'une tranche partielle
+        int extremite = numero == premier ? 0 : 1;
+        if (n < charsParBloc && !neuf[extremite]) {
+            //ecriture partielle d'un bloc existant : conserver le reste du bloc
+            if (lireBlocData(p, origine[extremite], bloc) < 0) {
+                ret = ERROR_READ;
+                break;
+            }
+        } else {
+            //bloc neuf ou entierement recouvert : rien à lire (l'espace réutilisé peut contenir d'anciennes données)
+            if (n < charsParBloc)
+                memset(bloc->donnee, 0, charsParBloc);
+            bloc->nbChars = 0;
+        }
+
+        copierDepuisVecteur(source, bloc->donnee + positionInBloc, n);
+        if (positionInBloc + n > bloc->nbChars)
+            bloc->nbChars = positionInBloc + n;
+        nbEcrits += n;
+        off_t suivant = numero < nbBlocs ? f->tabBlocs[numero] : BLOC_TROU;
+        bloc->suiv = suivant == BLOC_TROU ? -1 : suivant;
+
+        // ecrire le bloc en une seule fois (une écriture asynchrone est confiée au moteur ensuite)
+        if (jeton < 0 && ecrireBlocData(p, f->tabBlocs[numero - 1], bloc) < 0)
+            ret = ERROR_WRITE;
+        positionInBloc = 0;
+    }
+
+    //3- enregistrement des blocs et de la taille
+    pthread_mutex_lock(&p->verrou);
+    for (int numero = premier; numero <= dernier && jeton >= 0 && ret == 0; numero++) {
+        if (soumettreOperation(p, jeton, true, tampon + (off_t)(numero - premier) * tailleBloc, tailleBloc, f->tabBlocs[numero - 1]) < 0)
+            ret = ERROR_WRITE;
+    }
+    //les blocs rendus ne doivent plus recevoir d'écriture en vol
+    if (ret < 0 && jeton >= 0) attendreMoteur(p);
+    if (enregistrerAllocation(f, &a, nbBlocs, ret == 0) < 0 && ret == 0)
+        ret = ERROR_WRITE;
+    // Mettre à jour la position courante dans le fichier et, si le fichier s'allonge, sa taille logique
+    if (ret == 0) {
+        f->pos += size;
+        if (f->pos > be.taille && ecrireMetadonnees(p, &f->pos, sizeof(int), f->numEntete + offsetof(blocEntete, taille)) == -1)
+            ret = ERROR_WRITE;
+    }
+    pthread_mutex_unlock(&p->verrou);
+    pthread_rwlock_unlock(&p->verrouCopies);
+
+    free(blocsAlloues);
+    free(blocAlloue);
+    return ret < 0 ? ret : size;
+}
+
+
+/**
+ * @brief Termine dans le journal une opération d'écriture (voir finOperationJournal), sous le verrou de la partition.
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int finEcritureJournal(partition* p) {
+    pthread_mutex_lock(&p->verrou);
+    int ret = finOperationJournal(p);
+    pthread_mutex_unlock(&p->verrou);
+    return ret;
+}
+
+
+/**
+ * @brief Écrit le tampon d'écriture d'un fichier, sans terminer l'opération dans le journal (voir myFlush).
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int viderTampon(file* f) {
+    if (f->nbTampon == 0)
+        return 0;
+
+    int pos = f->pos;
+    f->pos = f->debutTampon;
+    struct iovec iov = {f->tampon, f->nbTampon};
+    curseurVecteur source = {&iov, 1, 0, 0};
+    int ret = ecrireFichier(f, &source, f->nbTampon, -1);
+    f->pos = pos;
+    if (ret < 0) return ret;
+    f->nbTampon = 0;
+    return 0;
+}
+
+
+/**
+ * @brief Écrit des données dans un fichier (voir myWrite). Le fichier doit être verrouillé en écriture.
+ */
+static int ecrireDescripteur(file* f, void* buffer, int size) {
+    char* buff = (char*)buffer;
+    int charsParBloc = f->part->charsParBloc;
+
+    //écriture d'au moins un bloc : directe
+    if (size >= charsParBloc) {
+        struct iovec iov = {buff, size};
+        curseurVecteur source = {&iov, 1, 0, 0};
+        if (viderTampon(f) < 0) return ERROR_WRITE;
+        int ret = ecrireFichier(f, &source, size, -1);
+        if (ret >= 0 && finEcritureJournal(f->part) < 0) ret = ERROR_WRITE;
+        return ret;
+    }
+
+    if (f->tampon == NULL) {
+        f->tampon = malloc(charsParBloc);
+        if (f->tampon == NULL) return ERROR_OTHER;
+    }
+
+    int nbEcrits = 0;
+    while (nbEcrits < size) {
+        //la position doit prolonger (ou recouvrir) la zone tamponnée, sans sortir de son bloc
+        int finFenetre = (f->debutTampon / charsParBloc + 1) * charsParBloc;
+        if (f->nbTampon > 0 && (f->pos < f->debutTampon || f->pos > f->debutTampon + f->nbTampon || f->pos >= finFenetre)) {
+            if (viderTampon(f) < 0) return ERROR_WRITE;
+        }
+        if (f->nbTampon == 0) {
+            f->debutTampon = f->pos;
+            finFenetre = (f->debutTampon / charsParBloc + 1) * charsParBloc;
+        }
+
+        int n = finFenetre - f->pos;
+        if (n > size - nbEcrits) n = size - nbEcrits;
+        memcpy(f->tampon + (f->pos - f->debutTampon), buff + nbEcrits, n);
+        if (f->pos + n - f->debutTampon > f->nbTampon)
+            f->nbTampon = f->pos + n - f->debutTampon;
+        f->pos += n;
+        nbEcrits += n;
+
+        //bloc complet : il est écrit en une fois
+        if (f->debutTampon + f->nbTampon == finFenetre && viderTampon(f) < 0) return ERROR_WRITE;
+    }
+    if (finEcritureJournal(f->part) < 0) return ERROR_WRITE;
+    return size;
+}
+
+
+/**
+ * @brief Permet d'écrire des données dans un fichier.
+ *
+ * La fonction myWrite prend en paramètres un pointeur vers une structure de fichier (file* f), un pointeur vers un buffer de données (void* buffer),
+ * et la taille des données à écrire (int size). Elle retourne le nombre de caractères écrits.
+ *
+ * Les petites écritures sont accumulées dans le tampon d'écriture du descripteur, qui couvre au plus
+ * la fin d'un bloc de données : le tampon est écrit (voir myFlush) dès que son bloc est complet,
+ * avant une écriture hors de la zone tamponnée, et par myRead, myTruncate, myClose ou un déplacement
+ * (mySeek) hors de cette zone. Une écriture d'au moins un bloc est faite directement, après avoir vidé le tampon.
+ * Les autres descripteurs ouverts sur le fichier ne voient les données tamponnées qu'après myFlush.
+ * L'écriture est refusée sur un fichier d'instantané (voir myOpenSnapshot). Elle est exclusive : les
+ * lectures et écritures du même fichier depuis d'autres threads attendent sa fin (voir fichierOuvert).
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @param buffer Un pointeur vers un buffer de données.
+ * @param size La taille des données à écrire.
+ * @return Le nombre de caractères écrits, une valeur d'erreur sinon.
+ */
+int myWrite(file* f, void* buffer, int size) {
+    if (f == NULL || f->lectureSeule || buffer == NULL || size < 0)
+        return ERROR_OTHER;
+    if (size == 0)
+        return 0;
+
+    long debut = debuterChrono(f->part);
+    int ret = ERROR_READ;
+    if (verrouillerEcriture(f) == 0) {
+        ret = ecrireDescripteur(f, buffer, size);
+        if (ret > 0) compter(&statsDuThread(f->part)->octetsEcritsFichiers, ret);
+        deverrouillerEcriture(f);
+    }
+    terminerChrono(f->part, TRACE_WRITE, debut, ret);
+    return ret;
+}
+
+/*********************************MyFlush**********************************/
+
+/**
+ * @brief Écrit dans la partition les données en attente dans le tampon d'écriture d'un fichier.
+ *
+ * La position courante n'est pas modifiée. Les données écrites restent soumises au cache de
+ * blocs de la partition ; mySync les rend durables.
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int myFlush(file* f) {
     if (f == NULL)
         return ERROR_OTHER;
+    if (f->nbTampon == 0)
+        return 0;
+    if (verrouillerEcriture(f) < 0) return ERROR_READ;
+    int ret = viderTampon(f) < 0 ? ERROR_WRITE : finEcritureJournal(f->part);
+    deverrouillerEcriture(f);
+    return ret;
+}
+
+/*********************************MyRead*************************************/
+
+/**
+ * @brief Charge à l'avance (ou signale au système) les blocs alloués d'un intervalle de blocs d'un fichier.
+ *
+ * Les blocs contigus dans la partition sont traités par zones. La table des blocs doit être chargée.
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @param debut Le numéro du premier bloc.
+ * @param fin Le numéro du dernier bloc (inclus).
+ * @param charger Vrai pour charger les blocs dans le cache (prechargerPartition), faux pour un simple conseil (conseillerPartition).
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int anticiperBlocs(file* f, int debut, int fin, bool charger) {
+    partition* p = f->part;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    int i = debut;
+    while (i <= fin) {
+        off_t offsetBloc = f->tabBlocs[i - 1];
+        if (offsetBloc == BLOC_TROU) {
+            i++;
+            continue;
+        }
+        int n = 1;
+        while (i + n <= fin && f->tabBlocs[i + n - 1] == offsetBloc + n * tailleBloc) n++;
+        if (charger) {
+            if (prechargerPartition(p, offsetBloc, (size_t)n * tailleBloc) < 0) return ERROR_READ;
+        } else {
+            conseillerPartition(p, offsetBloc, (size_t)n * tailleBloc);
+        }
+        i += n;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Lecture anticipée : charge dans le cache les blocs qu'une lecture séquentielle va demander.
+ *
+ * Une lecture est séquentielle si elle commence là où la précédente s'est arrêtée. La fenêtre
+ * (nombre de blocs anticipés) part de MIN_BLOCS_ANTICIPES et double à chaque lecture séquentielle,
+ * jusqu'à MAX_BLOCS_ANTICIPES ; une lecture non séquentielle l'annule. Tant que l'avance dépasse
+ * la moitié de la fenêtre, rien n'est chargé. Sinon, les blocs de la lecture et de la fenêtre
+ * sont chargés en une fois et la fenêtre suivante est signalée au système.
+ *
+ * @param f Un pointeur vers une structure de fichier.
+ * @param be L'entête du fichier.
+ * @param premier Le numéro du premier bloc de la lecture.
+ * @param dernier Le numéro du dernier bloc de la lecture.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int anticiperLecture(file* f, blocEntete* be, int premier, int dernier) {
+    if (f->pos != f->finLecture) {
+        f->fenetreLecture = 0;
+        f->blocAnticipe = 0;
+        return 0;
+    }
+    f->fenetreLecture = f->fenetreLecture == 0 ? MIN_BLOCS_ANTICIPES : 2 * f->fenetreLecture;
+    if (f->fenetreLecture > MAX_BLOCS_ANTICIPES) f->fenetreLecture = MAX_BLOCS_ANTICIPES;
+    if (f->blocAnticipe >= dernier + f->fenetreLecture / 2)
+        return 0;
+
+    //pas au-delà du dernier bloc alloué ni de la fin du fichier
+    int dernierBloc = trouverBlocData(be->taille - 1, f->part->charsParBloc);
+    if (dernierBloc > be->nbBlocs) dernierBloc = be->nbBlocs;
+    if (f->nbBlocsCharges != be->nbBlocs && chargerTableBlocs(f) < 0) return ERROR_READ;
+
+    int debut = premier > f->blocAnticipe ? premier : f->blocAnticipe + 1;
+    int fin = dernier + f->fenetreLecture < dernierBloc ? dernier + f->fenetreLecture : dernierBloc;
+    if (anticiperBlocs(f, debut, fin, true) < 0) return ERROR_READ;
+    int suivant = fin + f->fenetreLecture < dernierBloc ? fin + f->fenetreLecture : dernierBloc;
+    anticiperBlocs(f, fin + 1, suivant, false);
+    if (fin > f->blocAnticipe) f->blocAnticipe = fin;
+    return 0;
+}
+
+
+/**
+ * @brief Lit des données d'un fichier (voir myRead). Le fichier doit être verrouillé en lecture.
+ */
+static int lireDescripteur(file* f, void* buffer, int nBytes) {
+    partition* p = f->part;
+    int charsParBloc = p->charsParBloc;
+    char* buff = (char*)buffer;
+
+    // Trouver le numero du blocData à lire et la position exacte (dans le bloc) de debut de lecture
+    int blocNumber = trouverBlocData(f->pos, charsParBloc);
+    int positionInBloc = trouverPosition(f->pos, charsParBloc);
+
+    //ne pas lire au-delà de la fin du fichier
+    blocEntete be;
+    if (lireEntete(p, &be, f->numEntete) == -1) return ERROR_READ;
+    if (f->pos >= be.taille) return 0;
+    if (nBytes > be.taille - f->pos) nBytes = be.taille - f->pos;
+
+    if (anticiperLecture(f, &be, blocNumber, trouverBlocData(f->pos + nBytes - 1, charsParBloc)) < 0) return ERROR_READ;
+
+    int nbyteslu = 0; // initialisation du nombre d'octets lus
+    while (nbyteslu < nBytes) {
+        // taille de la tranche à lire dans le bloc courant
+        int n = charsParBloc - positionInBloc;
+        if (n > nBytes - nbyteslu) n = nBytes - nbyteslu;
+
+        off_t currentBlocOffset = blocNumber > be.nbBlocs ? BLOC_TROU : trouveOffsetBlocFile(f, blocNumber);
+        if (currentBlocOffset < 0) return currentBlocOffset;
+        if (currentBlocOffset == BLOC_TROU) {
+            // trou : la tranche est lue comme des caractères nuls
+            memset(buff + nbyteslu, 0, n);
+        }
+        // lecture directe de la tranche dans le tampon
+        else if (lirePartition(f->part, buff + nbyteslu, n, currentBlocOffset + offsetof(blocData, donnee) + positionInBloc) == -1) {
+            perror("Erreur lors de la lecture du fichier");
+            return ERROR_READ;
+        }
+        nbyteslu += n;
+        blocNumber++;
+        positionInBloc = 0;
+    }
+
+    // Mettre à jour la position courante dans le fichier
+    f->pos += nbyteslu;
+    f->finLecture = f->pos;
+    return nbyteslu;
+}
+
+
+/**
+ * @brief Permet de lire des données à partir d'un fichier.
+ *
+ * La fonction myRead lit les données à partir d'un fichier spécifié par le descripteur de fichier (file *f).
+ * Les données lues sont stockées dans un tampon (void *buffer) d'une taille spécifiée (int nBytes).
+ * La fonction retourne le nombre d'octets lus avec succès.
+ *
+ * La lecture se fait par tranches de bloc : pour chaque bloc touché, la tranche utile est lue
+ * directement dans le tampon de l'appelant, en une seule lecture. Le tampon d'écriture du
+ * descripteur est d'abord vidé (voir myFlush). La lecture s'arrête à la fin
+ * du fichier (taille logique de l'entête). Les trous sont lus comme des caractères nuls, sans accès à la partition.
+ * Une lecture séquentielle déclenche une lecture anticipée des blocs suivants (voir anticiperLecture).
+ * Le fichier n'est verrouillé qu'en lecture : plusieurs threads peuvent le lire en même temps.
+ *
+ * @param f Le descripteur de fichier à partir duquel lire les données.
+ * @param buffer Le tampon dans lequel stocker les données lues.
+ * @param nBytes Le nombre d'octets à lire.
+ * @return Le nombre d'octets lus avec succès, ou une valeur d'erreur en cas d'échec.
+ */
+int myRead(file *f,void * buffer, int nBytes){
+    if(f==NULL || buffer==NULL || nBytes <=0)
+    {
+        //Vérification des paramétres d'entrée
+        return ERROR_OTHER;
+    }
+    long debut = debuterChrono(f->part);
+    int ret;
+    //les données tamponnées doivent être visibles
+    if (myFlush(f) < 0) {
+        ret = ERROR_WRITE;
+    } else if (verrouillerLecture(f) < 0) {
+        ret = ERROR_READ;
+    } else {
+        ret = lireDescripteur(f, buffer, nBytes);
+        if (ret > 0) compter(&statsDuThread(f->part)->octetsLusFichiers, ret);
+        deverrouillerLecture(f);
+    }
+    terminerChrono(f->part, TRACE_READ, debut, ret);
+    return ret;
+}
+
+/*********************************MySeek***********************************/
+
+/**
+ * @brief Déplace la position courante dans un fichier.
+ *
+ * Cette fonction permet de déplacer la position courante dans un fichier en fonction de l'offset et de la base spécifiés.
+ *
+ * @param f Un pointeur vers la structure de fichier.
+ * @param offset L'offset de déplacement.
+ * @param base La base de déplacement (SEEK_SET, SEEK_CUR, SEEK_END).
+ *
+ * Un déplacement hors de la zone du tampon d'écriture vide ce tampon (voir myFlush).
+ *
+ * @note Si la nouvelle position est négative, une erreur sera affichée.
+ */
+void mySeek(file* f, int offset, int base){
+    long debut = debuterChrono(f->part);
+    int pos=f->pos;
+    int ancienne=f->pos;
+    switch (base) {
+        case SEEK_SET:
+            offset>=0?f->pos=offset:perror("impossible de se deplacer de l'offset fournit. Nouvelle position negative.");
+            break;
+        case SEEK_CUR:
+            pos = pos+offset;
+            pos>=0?f->pos=pos:perror("impossible de se deplacer de l'offset fournit. Nouvelle position negative.");
+            break;
+        case SEEK_END:
+            pos=getPosLastCharFile(f)+offset;
+            pos>=0?f->pos=pos:perror("impossible de se deplacer de l'offset fournit. Nouvelle position negative.");
+            break;
+        default: //
+            perror("valeur erronée de 'base', valeurs possibles: SEEK_SET, SEEK_CUR, SEEK_END.");
+    }
+    if (f->pos != ancienne && (f->pos < f->debutTampon || f->pos > f->debutTampon + f->nbTampon) && myFlush(f) < 0)
+        perror("Erreur d'écriture du tampon du fichier");
+    terminerChrono(f->part, TRACE_SEEK, debut, f->pos);
+}
+/*********************************MyClose***********************************/
+
+/**
+ * \brief Ferme un fichier.
+ *
+ * Cette fonction écrit les données en attente dans le tampon d'écriture (voir myFlush) puis
+ * libère la mémoire allouée pour la structure de fichier spécifiée, sa table des blocs et son tampon.
+ *
+ * \param f Le pointeur vers la structure de fichier à fermer.
+ */
+void myClose(file* f){
+    if (f == NULL) return;
+    if (f->ouvert != NULL && myFlush(f) < 0)
+        perror("Erreur d'écriture du tampon du fichier");
+    detacherFichierOuvert(f);
+    free(f->tampon);
+    free(f->tabBlocs);
+    free(f);
+}
+/*********************************MyDelete***********************************/
+
+/**
+ * @brief Supprime un fichier de la partition (voir myDelete). Le verrou de la partition doit être pris.
+ */
+static int supprimerFichier(partition* p, char* fileName) {
+    off_t offsetEntete = rechercheRepertoire(p, fileName);
+    if (offsetEntete == -1) return ERROR_OPEN;
+    if (offsetEntete < 0) return ERROR_READ;
+    if (estFichierOuvert(p, offsetEntete)) return ERROR_OTHER;
+
+    if (supprimerRepertoire(p, fileName) < 0) return ERROR_WRITE;
+    int ret = libererFichier(p, offsetEntete);
+    if (ret < 0) return ret;
+    return finOperationJournal(p);
+}
+
+
+/**
+ * @brief Supprime un fichier de la partition.
+ *
+ * Le fichier est retiré du répertoire et tout son espace (entête, blocs d'extents et blocs de
+ * données) est rendu à la table des unités libres pour être réutilisé. Un fichier ouvert
+ * (un descripteur au moins, dans n'importe quel thread) n'est pas supprimé.
+ *
+ * @param p La partition montée.
+ * @param fileName Le nom du fichier à supprimer.
+ * @return 0 en cas de succès, ERROR_OPEN si le fichier n'existe pas, ERROR_OTHER s'il est ouvert, une autre valeur d'erreur sinon.
+ */
+int myDelete(partition* p, char* fileName) {
+    if (p == NULL || fileName == NULL)
+        return ERROR_OTHER;
+
+    pthread_mutex_lock(&p->verrou);
+    int ret = supprimerFichier(p, fileName);
+    pthread_mutex_unlock(&p->verrou);
+    return ret;
+}
+
+/*********************************MyTruncate*********************************/
+
+/**
+ * @brief Modifie la taille d'un fichier (voir myTruncate). Le fichier doit être verrouillé en écriture,
+ * son tampon d'écriture vide et le verrou de la partition pris.
+ */
+static int changerTaille(file* f, int taille) {
+    partition* p = f->part;
+    int charsParBloc = p->charsParBloc;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    int tailleActuelle = getPosLastCharFile(f);
+    if (tailleActuelle < 0) return tailleActuelle;
+    if (taille == tailleActuelle) return 0;
+
+    //agrandissement : la partie ajoutée est un trou, seule la taille logique change
+    if (taille > tailleActuelle) {
+        if (tailleActuelle % charsParBloc != 0) {
+            int nbBlocs = getNbBlocsFile(f);
+            if (nbBlocs < 0) return nbBlocs;
+            if (f->nbBlocsCharges != nbBlocs && chargerTableBlocs(f) < 0) return ERROR_READ;
+            if (effacerFinBloc(f, tailleActuelle, nbBlocs) < 0) return ERROR_WRITE;
+        }
+        if (ecrireMetadonnees(p, &taille, sizeof(int), f->numEntete + offsetof(blocEntete, taille)) == -1) return ERROR_WRITE;
+        return finOperationJournal(p);
+    }
+
+    int nbBlocs = getNbBlocsFile(f);
+    if (nbBlocs < 0) return nbBlocs;
+    if (f->nbBlocsCharges != nbBlocs && chargerTableBlocs(f) < 0) return ERROR_READ;
+    int nbGardes = (taille + charsParBloc - 1) / charsParBloc;
+
+    if (nbGardes < nbBlocs) {
+        //liberer les blocs retirés, par zones contigues
+        int i = nbGardes;
+        while (i < nbBlocs) {
+            if (f->tabBlocs[i] == BLOC_TROU) {
+                i++;
+                continue;
+            }
+            int n = 1;
+            while (i + n < nbBlocs && f->tabBlocs[i + n] == f->tabBlocs[i] + n * tailleBloc) n++;
+            libererEspace(p, f->tabBlocs[i], (size_t)n * tailleBloc);
+            i += n;
+        }
+        if (reecrireExtents(f, f->tabBlocs, nbGardes) < 0) return ERROR_WRITE;
+        //la table suit l'entête : les trous de fin sont retirés
+        f->nbBlocsCharges = nbGardes;
+        while (f->nbBlocsCharges > 0 && f->tabBlocs[f->nbBlocsCharges - 1] == BLOC_TROU) f->nbBlocsCharges--;
+    }
+    //la fin du nouveau dernier bloc n'est pas effacée ici : elle ne le sera que si le fichier
+    //s'allonge (voir effacerFinBloc), après la validation de la nouvelle taille
+    if (ecrireMetadonnees(p, &taille, sizeof(int), f->numEntete + offsetof(blocEntete, taille)) == -1) return ERROR_WRITE;
+    return finOperationJournal(p);
+}
+
+
+/**
+ * @brief Modifie la taille d'un fichier.
+ *
+ * Si la nouvelle taille est plus petite, les blocs devenus inutiles sont rendus à la table des
+ * unités libres (ou perdent une référence s'ils sont partagés) et les extents sont réécrits ; le
+ * nouveau dernier bloc n'est pas modifié, les caractères qui suivent la nouvelle taille ne sont plus lus.
+ * Si elle est plus grande, la partie ajoutée est un trou (lu comme des caractères nuls, sans bloc alloué) ;
+ * les caractères restés après l'ancienne taille dans son dernier bloc sont effacés.
+ * La position courante n'est pas modifiée. Les autres descripteurs ouverts sur le fichier rechargent
+ * leur table des blocs à leur prochaine opération. Un fichier d'instantané (voir myOpenSnapshot) ne peut pas être tronqué.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @param taille La nouvelle taille du fichier, en caractères.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int myTruncate(file* f, int taille) {
+    if (f == NULL || f->lectureSeule || taille < 0)
+        return ERROR_OTHER;
+
+    if (verrouillerEcriture(f) < 0) return ERROR_READ;
+    int ret = viderTampon(f);
+    if (ret == 0) {
+        pthread_mutex_lock(&f->part->verrou);
+        ret = changerTaille(f, taille);
+        pthread_mutex_unlock(&f->part->verrou);
+    }
+    deverrouillerEcriture(f);
+    return ret;
+}
+
+/*********************************MyCopy / MyClone**************************/
+
+/**
+ * @brief Prépare la copie d'un fichier : vérifie que la source existe et supprime la destination si elle existe.
+ *
+ * La destination ne doit pas être ouverte. Les écritures asynchrones en vol sont attendues, pour
+ * que la source soit copiée dans son état final.
+ *
+ * @param p La partition montée.
+ * @param source Le nom du fichier à copier.
+ * @param destination Le nom de la copie.
+ * @return L'offset de l'entête de la source, ERROR_OPEN si elle n'existe pas, une autre valeur d'erreur sinon.
+ */
+static off_t preparerCopie(partition* p, char* source, char* destination) {
+    if (p == NULL || source == NULL || destination == NULL || strcmp(source, destination) == 0)
+        return ERROR_OTHER;
 
+    off_t offsetSource = rechercheRepertoire(p, source);
+    if (offsetSource == -1) return ERROR_OPEN;
+    if (offsetSource < 0) return ERROR_READ;
+    off_t offsetDestination = rechercheRepertoire(p, destination);
+    if (offsetDestination < -1) return ERROR_READ;
+    if (offsetDestination != -1 && estFichierOuvert(p, offsetDestination)) return ERROR_OTHER;
+    //sans myDelete : la suppression fait partie de l'opération (une seule validation du journal)
+    if (offsetDestination != -1 && (supprimerRepertoire(p, destination) < 0 || libererFichier(p, offsetDestination) < 0))
+        return ERROR_WRITE;
+    if (attendreMoteur(p) < 0) return ERROR_WRITE;
+    return offsetSource;
+}
 
-    blocEntete buff;
+
+/**
+ * @brief Termine une copie : décrit les blocs de la destination par ses extents et lui donne la taille de la source.
+ *
+ * En cas d'échec (ret négatif, ou erreur d'écriture de l'entête), la destination est supprimée.
+ * Les deux descripteurs sont fermés.
+ *
+ * @return ret en cas de succès, une valeur d'erreur sinon.
+ */
+static int terminerCopie(partition* p, char* destination, file* src, file* dst, off_t* blocs, int nbBlocs, int ret) {
+    if (ret == 0) {
+        int taille = getPosLastCharFile(src);
+        if (taille < 0 || reecrireExtents(dst, blocs, nbBlocs) < 0 ||
+            ecrireMetadonnees(p, &taille, sizeof(int), dst->numEntete + offsetof(blocEntete, taille)) == -1)
+            ret = ERROR_WRITE;
+    }
+    myClose(src);
+    myClose(dst);
+    if (ret < 0)
+        myDelete(p, destination);
+    else if (finOperationJournal(p) < 0)
+        ret = ERROR_WRITE;
+    return ret;
+}
 
 
-    off_t numEntete = f->numEntete; //recuperer l'offset vers l'entete du fichier depuis le debut de la partition
+/**
+ * @brief Copie un fichier de la partition (voir myCopy). Le verrou de la partition doit être pris.
+ */
+static int copierFichier(partition* p, char* source, char* destination) {
+    off_t offsetSource = preparerCopie(p, source, destination);
+    if (offsetSource < 0) return offsetSource;
+    file* src = myOpen(p, source);
+    if (src == NULL) return ERROR_OPEN;
+    file* dst = myOpen(p, destination);
+    if (dst == NULL) {
+        myClose(src);
+        return ERROR_OPEN;
+    }
+    int ret = 0;
+
+    off_t tailleBloc = p->sb.tailleBloc;
+    int nbBlocs = src->nbBlocsCharges;
+    int nbAlloues = 0;
+    for (int i = 0; i < nbBlocs; i++)
+        if (src->tabBlocs[i] != BLOC_TROU) nbAlloues++;
+    off_t* blocs = malloc((nbBlocs > 0 ? nbBlocs : 1) * sizeof(off_t));
+    if (blocs == NULL)
+        return terminerCopie(p, destination, src, dst, NULL, 0, ERROR_OTHER);
+
+    //les blocs de la source doivent être à jour dans la partition avant la copie par le noyau
+    if (viderCache(p) < 0) {
+        free(blocs);
+        return terminerCopie(p, destination, src, dst, NULL, 0, ERROR_WRITE);
+    }
+    off_t zone = BLOC_TROU;
+    if (nbAlloues > 0) {
+        zone = allouerEspaceProche(p, (size_t)nbAlloues * tailleBloc, offsetSouhaiteBloc(dst, 1, 0));
+        if (zone < 0) {
+            free(blocs);
+            return terminerCopie(p, destination, src, dst, NULL, 0, ERROR_WRITE);
+        }
+        oublierCache(p, zone / tailleBloc, nbAlloues);
+    }
+
+    //copie par suites de blocs contigus dans la source
+    off_t suivant = zone;
+    int i = 0;
+    while (i < nbBlocs && ret == 0) {
+        if (src->tabBlocs[i] == BLOC_TROU) {
+            blocs[i++] = BLOC_TROU;
+            continue;
+        }
+        int n = 1;
+        while (i + n < nbBlocs && src->tabBlocs[i + n] == src->tabBlocs[i] + n * tailleBloc) n++;
+        if (copierStockage(p, src->tabBlocs[i], suivant, (size_t)n * tailleBloc) == -1) {
+            ret = ERROR_WRITE;
+            break;
+        }
+        for (int j = 0; j < n; j++)
+            blocs[i + j] = suivant + j * tailleBloc;
+        suivant += n * tailleBloc;
+        i += n;
+    }
 
+    //en cas d'échec la zone n'est pas encore décrite par les extents de la destination
+    if (ret < 0 && zone != BLOC_TROU)
+        libererEspace(p, zone, (size_t)nbAlloues * tailleBloc);
+    ret = terminerCopie(p, destination, src, dst, blocs, nbBlocs, ret);
+    free(blocs);
+    return ret;
+}
 
-    //se deplacer vers le debut du fichier
-    if (lseek(f->fd, numEntete, SEEK_SET) == -1)
-        return ERROR_LSEEK;
 
-    // Lire le bloc d'entete du fichier
-    if (read(f->fd, &buff, sizeof(struct blocEntete)) == -1)
+/**
+ * @brief Copie un fichier de la partition dans un nouveau fichier, bloc par bloc, sans passer par un tampon utilisateur.
+ *
+ * Les blocs alloués de la destination sont réservés en une seule zone contiguë (placée de
+ * préférence à la suite de son entête) ; chaque suite de blocs contigus de la source y est
+ * recopiée en une fois par le noyau (voir copierStockage). Les blocs modifiés du cache sont
+ * d'abord écrits dans la partition. Les trous de la source restent des trous.
+ * Les blocs sont copiés avec leur entête (nbChars, suiv) : la copie est décrite par des extents,
+ * le champ suiv n'y est pas utilisé.
+ *
+ * Les descripteurs ouverts sur la source doivent avoir été vidés (myFlush). Une destination
+ * existante est remplacée, sauf si elle est ouverte (ERROR_OTHER).
+ *
+ * @param p La partition montée.
+ * @param source Le nom du fichier à copier.
+ * @param destination Le nom de la copie.
+ * @return 0 en cas de succès, ERROR_OPEN si la source n'existe pas, une autre valeur d'erreur sinon.
+ */
+int myCopy(partition* p, char* source, char* destination) {
+    if (p == NULL)
+        return ERROR_OTHER;
+    //les écritures en cours s'achèvent d'abord (voir ecrireFichier)
+    pthread_rwlock_wrlock(&p->verrouCopies);
+    pthread_mutex_lock(&p->verrou);
+    int ret = copierFichier(p, source, destination);
+    pthread_mutex_unlock(&p->verrou);
+    pthread_rwlock_unlock(&p->verrouCopies);
+    return ret;
+}
+
+
+/**
+ * @brief Crée un clone d'un fichier (voir myClone). Le verrou de la partition doit être pris.
+ */
+static int creerClone(partition* p, char* source, char* destination) {
+    off_t offsetSource = preparerCopie(p, source, destination);
+    if (offsetSource < 0) return offsetSource;
+
+    off_t offsetClone = clonerEntete(p, offsetSource, destination);
+    if (offsetClone < 0) return offsetClone;
+
+    elemTabIndex element;
+    strcpy(element.nomFichier, destination);
+    element.numBlocEntete = offsetClone;
+    if (insererRepertoire(p, element) < 0) {
+        libererFichier(p, offsetClone);
+        return ERROR_WRITE;
+    }
+    return finOperationJournal(p);
+}
+
+
+/**
+ * @brief Crée un clone d'un fichier : un nouveau fichier qui partage les blocs de la source, copiés sur écriture.
+ *
+ * Aucune donnée n'est copiée : la destination reçoit les extents de la source et chaque bloc
+ * alloué gagne une référence dans la table des partages (voir clonerEntete). Le clone est donc instantané et
+ * n'occupe que son entête (et ses éventuels blocs d'extents). Le premier fichier qui écrit dans
+ * un bloc partagé (myWrite, myTruncate) en reçoit une copie (voir blocPourEcriture) ; un bloc
+ * n'est libéré qu'avec sa dernière référence (myDelete, myTruncate).
+ *
+ * Les descripteurs ouverts sur la source doivent avoir été vidés (myFlush). Une destination
+ * existante est remplacée, sauf si elle est ouverte (ERROR_OTHER).
+ *
+ * @param p La partition montée.
+ * @param source Le nom du fichier à cloner.
+ * @param destination Le nom du clone.
+ * @return 0 en cas de succès, ERROR_OPEN si la source n'existe pas, une autre valeur d'erreur
+ * (notamment si un bloc a atteint MAX_PARTAGES références supplémentaires).
+ */
+int myClone(partition* p, char* source, char* destination) {
+    if (p == NULL)
+        return ERROR_OTHER;
+    //les écritures en cours s'achèvent d'abord (voir ecrireFichier)
+    pthread_rwlock_wrlock(&p->verrouCopies);
+    pthread_mutex_lock(&p->verrou);
+    int ret = creerClone(p, source, destination);
+    pthread_mutex_unlock(&p->verrou);
+    pthread_rwlock_unlock(&p->verrouCopies);
+    return ret;
+}
+
+/*********************************MySnapshot********************************/
+
+/**
+ * @brief Lit le catalogue des instantanés de la partition.
+ *
+ * @param p La partition montée.
+ * @return Un tableau alloué de nbInstantanes + 1 éléments (une case libre pour un ajout), NULL en cas d'erreur.
+ */
+static instantane* lireCatalogue(partition* p) {
+    int nb = p->sb.nbInstantanes;
+    instantane* catalogue = malloc((nb + 1) * sizeof(instantane));
+    if (catalogue == NULL)
+        return NULL;
+    if (nb > 0 && lirePartition(p, catalogue, nb * sizeof(instantane), p->sb.instantanes) == -1) {
+        free(catalogue);
+        return NULL;
+    }
+    return catalogue;
+}
+
+
+/**
+ * @brief Cherche un instantané dans le catalogue.
+ *
+ * @return L'indice de l'instantané, -1 s'il n'existe pas.
+ */
+static int rechercheInstantane(instantane* catalogue, int nb, char* nom) {
+    for (int i = 0; i < nb; i++)
+        if (strcmp(catalogue[i].nom, nom) == 0) return i;
+    return -1;
+}
+
+
+/**
+ * @brief Remplace le catalogue des instantanés de la partition.
+ *
+ * Le nouveau catalogue est écrit dans une nouvelle zone, puis l'ancienne zone est libérée ; le
+ * super bloc, qui référence le catalogue, est marqué modifié.
+ *
+ * @param p La partition montée.
+ * @param catalogue Les instantanés.
+ * @param nb Le nombre d'instantanés.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int ecrireCatalogue(partition* p, instantane* catalogue, int nb) {
+    off_t offset = -1;
+    if (nb > 0) {
+        offset = allouerEspace(p, nb * sizeof(instantane));
+        if (ecrirePartition(p, catalogue, nb * sizeof(instantane), offset) == -1) return ERROR_WRITE;
+    }
+    if (p->sb.instantanes != -1)
+        libererEspace(p, p->sb.instantanes, p->sb.nbInstantanes * sizeof(instantane));
+    p->sb.instantanes = offset;
+    p->sb.nbInstantanes = nb;
+    p->superBlocModifie = true;
+    return 0;
+}
+
+
+/**
+ * @brief Lit le tableau (trié par nom) des fichiers d'un instantané.
+ *
+ * @return Un tableau alloué (NULL pour un instantané sans fichier), NULL en cas d'erreur (*erreur mis à vrai).
+ */
+static elemTabIndex* lireFichiersInstantane(partition* p, instantane* inst, bool* erreur) {
+    *erreur = false;
+    if (inst->nbFichiers == 0)
+        return NULL;
+    elemTabIndex* fichiers = malloc(inst->nbFichiers * sizeof(elemTabIndex));
+    if (fichiers == NULL || lirePartition(p, fichiers, inst->nbFichiers * sizeof(elemTabIndex), inst->index) == -1) {
+        free(fichiers);
+        *erreur = true;
+        return NULL;
+    }
+    return fichiers;
+}
+
+
+/**
+ * @struct clonageInstantane
+ * @brief Les fichiers d'un instantané en cours de création (voir clonerFichier).
+ */
+typedef struct clonageInstantane{
+    partition* p; /**< La partition montée */
+    elemTabIndex* fichiers; /**< Les clones déjà créés, dans l'ordre des noms */
+    int nbFichiers; /**< Le nombre de clones créés */
+    int capacite; /**< Le nombre de cases allouées pour fichiers */
+}clonageInstantane;
+
+
+/**
+ * @brief Clone un fichier du répertoire dans l'instantané en cours de création (voir parcourirRepertoire).
+ */
+static int clonerFichier(elemTabIndex* element, void* arg) {
+    clonageInstantane* c = arg;
+    if (c->nbFichiers == c->capacite) {
+        int capacite = c->capacite == 0 ? 16 : 2 * c->capacite;
+        elemTabIndex* fichiers = realloc(c->fichiers, capacite * sizeof(elemTabIndex));
+        if (fichiers == NULL) return ERROR_OTHER;
+        c->fichiers = fichiers;
+        c->capacite = capacite;
+    }
+    off_t offsetClone = clonerEntete(c->p, element->numBlocEntete, element->nomFichier);
+    if (offsetClone < 0) return (int)offsetClone;
+    c->fichiers[c->nbFichiers] = *element;
+    c->fichiers[c->nbFichiers].numBlocEntete = offsetClone;
+    c->nbFichiers++;
+    return 0;
+}
+
+
+/**
+ * @brief Crée un instantané de la partition (voir mySnapshot). Le verrou de la partition doit être pris.
+ */
+static int creerInstantane(partition* p, char* nom) {
+    instantane* catalogue = lireCatalogue(p);
+    if (catalogue == NULL) return ERROR_READ;
+    int nb = p->sb.nbInstantanes;
+    if (rechercheInstantane(catalogue, nb, nom) != -1) {
+        free(catalogue);
+        return ERROR_OTHER;
+    }
+    if (attendreMoteur(p) < 0) {
+        free(catalogue);
+        return ERROR_WRITE;
+    }
+
+    //cloner les fichiers dans l'ordre des noms : le tableau obtenu est trié
+    clonageInstantane c = {p, NULL, 0, 0};
+    int ret = parcourirRepertoire(p, clonerFichier, &c);
+
+    instantane* inst = &catalogue[nb];
+    memset(inst, 0, sizeof(instantane));
+    strcpy(inst->nom, nom);
+    inst->nbFichiers = c.nbFichiers;
+    inst->index = -1;
+    if (ret == 0 && c.nbFichiers > 0) {
+        inst->index = allouerEspace(p, c.nbFichiers * sizeof(elemTabIndex));
+        if (ecrirePartition(p, c.fichiers, c.nbFichiers * sizeof(elemTabIndex), inst->index) == -1)
+            ret = ERROR_WRITE;
+    }
+    if (ret == 0)
+        ret = ecrireCatalogue(p, catalogue, nb + 1);
+
+    if (ret < 0) {
+        //échec : les clones déjà créés sont libérés
+        for (int i = 0; i < c.nbFichiers; i++)
+            libererFichier(p, c.fichiers[i].numBlocEntete);
+        if (inst->index != -1)
+            libererEspace(p, inst->index, c.nbFichiers * sizeof(elemTabIndex));
+    }
+    free(c.fichiers);
+    free(catalogue);
+    if (ret < 0) return ret;
+    return flushIndex(p);
+}
+
+
+/**
+ * @brief Crée un instantané de la partition : une image figée, en lecture seule, de tous ses fichiers.
+ *
+ * Chaque fichier du répertoire est cloné (voir clonerEntete) : seuls les entêtes et les extents
+ * sont recopiés, les blocs de données sont partagés. Les écritures suivantes dans les fichiers ne
+ * modifient donc pas l'instantané : un bloc partagé est copié sur écriture (voir blocPourEcriture)
+ * et l'instantané garde l'ancien bloc. Le coût ne dépend que du nombre de fichiers et d'extents.
+ *
+ * Les clones sont rangés dans un tableau trié par nom, référencé par le catalogue des instantanés
+ * du super bloc. L'instantané est ensuite rendu durable (voir flushIndex).
+ * Les descripteurs ouverts doivent avoir été vidés (myFlush) pour que leurs données tamponnées y figurent.
+ *
+ * @param p La partition montée.
+ * @param nom Le nom de l'instantané.
+ * @return 0 en cas de succès, ERROR_OTHER si un instantané porte déjà ce nom, une autre valeur d'erreur sinon.
+ */
+int mySnapshot(partition* p, char* nom) {
+    if (p == NULL || nom == NULL || strlen(nom) >= MAX_LEN_NAME)
+        return ERROR_OTHER;
+
+    //les écritures en cours s'achèvent d'abord (voir ecrireFichier)
+    pthread_rwlock_wrlock(&p->verrouCopies);
+    pthread_mutex_lock(&p->verrou);
+    int ret = creerInstantane(p, nom);
+    pthread_mutex_unlock(&p->verrou);
+    pthread_rwlock_unlock(&p->verrouCopies);
+    return ret;
+}
+
+
+/**
+ * @brief Ouvre en lecture seule un fichier d'un instantané (voir myOpenSnapshot). Le verrou de la partition doit être pris.
+ */
+static file* ouvrirFichierInstantane(partition* p, char* nom, char* fileName) {
+    instantane* catalogue = lireCatalogue(p);
+    if (catalogue == NULL) return NULL;
+    int i = rechercheInstantane(catalogue, p->sb.nbInstantanes, nom);
+    if (i == -1) {
+        free(catalogue);
+        return NULL;
+    }
+    bool erreur;
+    elemTabIndex* fichiers = lireFichiersInstantane(p, &catalogue[i], &erreur);
+    int j = erreur ? -1 : rechercheDichotomique(fichiers, catalogue[i].nbFichiers, fileName);
+    off_t offsetEntete = j == -1 ? -1 : fichiers[j].numBlocEntete;
+    free(fichiers);
+    free(catalogue);
+    if (offsetEntete == -1)
+        return NULL;
+
+    file* f = ouvrirDescripteur(p, offsetEntete);
+    if (f != NULL)
+        f->lectureSeule = true;
+    return f;
+}
+
+
+/**
+ * @brief Ouvre en lecture seule un fichier d'un instantané.
+ *
+ * Le descripteur obtenu se lit comme un autre (myRead, mySeek, myReadv, myReadAsync) ; myWrite,
+ * myWritev, myWriteAsync et myTruncate le refusent. Il doit être fermé (myClose) avant la
+ * suppression de l'instantané.
+ *
+ * @param p La partition montée.
+ * @param nom Le nom de l'instantané.
+ * @param fileName Le nom du fichier dans l'instantané.
+ * @return Un pointeur vers la structure file, NULL si l'instantané ou le fichier n'existe pas ou en cas d'erreur.
+ */
+file* myOpenSnapshot(partition* p, char* nom, char* fileName) {
+    if (p == NULL || nom == NULL || fileName == NULL)
+        return NULL;
+
+    pthread_mutex_lock(&p->verrou);
+    file* f = ouvrirFichierInstantane(p, nom, fileName);
+    pthread_mutex_unlock(&p->verrou);
+    return f;
+}
+
+
+/**
+ * @brief Supprime un instantané (voir myDropSnapshot). Le verrou de la partition doit être pris.
+ */
+static int supprimerInstantane(partition* p, char* nom) {
+    instantane* catalogue = lireCatalogue(p);
+    if (catalogue == NULL) return ERROR_READ;
+    int nb = p->sb.nbInstantanes;
+    int i = rechercheInstantane(catalogue, nb, nom);
+    if (i == -1) {
+        free(catalogue);
+        return ERROR_OPEN;
+    }
+    bool erreur;
+    elemTabIndex* fichiers = lireFichiersInstantane(p, &catalogue[i], &erreur);
+    if (erreur) {
+        free(catalogue);
         return ERROR_READ;
+    }
+    for (int j = 0; j < catalogue[i].nbFichiers; j++) {
+        if (estFichierOuvert(p, fichiers[j].numBlocEntete)) {
+            free(fichiers);
+            free(catalogue);
+            return ERROR_OTHER;
+        }
+    }
+
+    //retirer l'instantané du catalogue avant de libérer son espace
+    instantane inst = catalogue[i];
+    memmove(&catalogue[i], &catalogue[i + 1], (nb - i - 1) * sizeof(instantane));
+    int ret = ecrireCatalogue(p, catalogue, nb - 1);
+    if (ret == 0) {
+        for (int j = 0; j < inst.nbFichiers && ret == 0; j++)
+            ret = libererFichier(p, fichiers[j].numBlocEntete);
+        if (inst.nbFichiers > 0)
+            libererEspace(p, inst.index, inst.nbFichiers * sizeof(elemTabIndex));
+    }
+    free(fichiers);
+    free(catalogue);
+    return ret;
+}
 
 
-    //modifier l'offset vers la tete
-    buff.numTete = val;
-    //faire un pas en arrière pour revenir au bloc d'entete
-    if (lseek(f->fd, numEntete, SEEK_SET) == -1)
-        return ERROR_LSEEK;
-    //actualiser le bloc d'entete
-    if (write(f->fd, &buff, sizeof(struct blocEntete)) == -1)
+/**
+ * @brief Supprime un instantané.
+ *
+ * Chaque fichier de l'instantané est libéré (voir libererFichier) : les blocs qu'il était seul
+ * à référencer sont rendus à la table des unités libres, les blocs encore partagés (avec les
+ * fichiers du répertoire ou d'autres instantanés) perdent une référence.
+ * L'instantané n'est pas supprimé si l'un de ses fichiers est ouvert (voir myOpenSnapshot).
+ *
+ * @param p La partition montée.
+ * @param nom Le nom de l'instantané.
+ * @return 0 en cas de succès, ERROR_OPEN si l'instantané n'existe pas, ERROR_OTHER si l'un de ses fichiers
+ * est ouvert, une autre valeur d'erreur sinon.
+ */
+int myDropSnapshot(partition* p, char* nom) {
+    if (p == NULL || nom == NULL)
+        return ERROR_OTHER;
+
+    pthread_mutex_lock(&p->verrou);
+    int ret = supprimerInstantane(p, nom);
+    pthread_mutex_unlock(&p->verrou);
+    return ret;
+}
+
+/*********************************MyDefrag***********************************/
+
+/**
+ * @brief Mesure la fragmentation d'un fichier à partir de sa table des blocs (chargée) et de son entête.
+ *
+ * @return 0 en cas de succès, ERROR_READ sinon.
+ */
+static int mesurerFragmentation(file* f, fragmentation* m) {
+    partition* p = f->part;
+    off_t tailleBloc = p->sb.tailleBloc;
+    blocEntete be;
+
+    if (lireEntete(p, &be, f->numEntete) == -1) return ERROR_READ;
+    memset(m, 0, sizeof(fragmentation));
+    m->nbExtents = be.nbExtents;
+    m->debut = -1;
+    off_t precedent = -1;
+    off_t fin = -1;
+    for (int i = 0; i < f->nbBlocsCharges; i++) {
+        off_t bloc = f->tabBlocs[i];
+        if (bloc == BLOC_TROU)
+            continue;
+        m->nbBlocs++;
+        if (precedent == -1 || bloc != precedent + tailleBloc) m->nbFragments++;
+        if (m->debut == -1 || bloc < m->debut) m->debut = bloc;
+        if (bloc > fin) fin = bloc;
+        if (estBlocPartage(p, bloc)) m->partage = true;
+        precedent = bloc;
+    }
+    m->etendue = m->nbBlocs > 0 ? (fin - m->debut) / tailleBloc + 1 : 0;
+    return 0;
+}
+
+
+/**
+ * @brief Rapproche l'entête d'un fichier du début de la partition, s'il y a de la place avant lui.
+ *
+ * Le nouvel entête est désigné par le répertoire (voir modifierRepertoire). L'entête reste en place
+ * si d'autres descripteurs sont ouverts sur le fichier. Le fichier doit être verrouillé en écriture.
+ *
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int deplacerEntete(file* f) {
+    partition* p = f->part;
+    off_t tailleBloc = p->sb.tailleBloc;
+    off_t nbUnites = ((off_t)sizeof(struct blocEntete) + tailleBloc - 1) / tailleBloc;
+    blocEntete be;
+
+    if (f->ouvert->nbDescripteurs > 1)
+        return 0;
+    p->curseurLibre = 0;
+    off_t unite = p->nbUnitesLibres >= nbUnites ? chercherUnitesLibres(p, nbUnites) : -1;
+    if (unite == -1 || unite * tailleBloc > f->numEntete)
+        return 0;
+
+    if (lireEntete(p, &be, f->numEntete) == -1) return ERROR_READ;
+    off_t offsetEntete = allouerEspaceProche(p, sizeof(struct blocEntete), unite * tailleBloc);
+    if (offsetEntete < 0 || ecrireMetadonnees(p, &be, sizeof(struct blocEntete), offsetEntete) == -1 ||
+        modifierRepertoire(p, be.nomFichier, offsetEntete) < 0)
+        return ERROR_WRITE;
+    libererEspace(p, f->numEntete, sizeof(struct blocEntete));
+    f->numEntete = offsetEntete;
+    f->ouvert->numEntete = offsetEntete;
+    return 0;
+}
+
+
+/**
+ * @brief Recopie les blocs d'un fichier en une seule suite contiguë, dans l'ordre du fichier (voir myDefrag).
+ *
+ * Le fichier doit être verrouillé en écriture et sa table des blocs chargée.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @param avant La fragmentation actuelle du fichier (ses blocs ne sont pas partagés).
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+static int deplacerBlocs(file* f, fragmentation* avant) {
+    partition* p = f->part;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    //premier espace libre assez grand à partir du début de la partition
+    off_t nbUnites = avant->nbBlocs;
+    p->curseurLibre = 0;
+    off_t unite = p->nbUnitesLibres >= nbUnites ? chercherUnitesLibres(p, nbUnites) : -1;
+    //déjà d'un seul tenant, et pas d'espace libre plus proche du début : le fichier reste en place
+    if (avant->nbFragments == 1 && (unite == -1 || unite * tailleBloc > avant->debut))
+        return 0;
+
+    //les blocs du fichier doivent être à jour dans la partition avant la copie par le noyau
+    if (attendreMoteur(p) < 0 || viderCache(p) < 0) return ERROR_WRITE;
+    int nbBlocs = f->nbBlocsCharges;
+    off_t* blocs = malloc(nbBlocs * sizeof(off_t));
+    if (blocs == NULL) return ERROR_OTHER;
+    off_t zone = allouerEspaceProche(p, (size_t)nbUnites * tailleBloc, unite == -1 ? -1 : unite * tailleBloc);
+    if (zone < 0) {
+        free(blocs);
         return ERROR_WRITE;
+    }
+    oublierCache(p, zone / tailleBloc, nbUnites);
+
+    //copie par suites de blocs contigus, dans l'ordre du fichier
+    int ret = 0;
+    off_t suivant = zone;
+    int i = 0;
+    while (i < nbBlocs && ret == 0) {
+        if (f->tabBlocs[i] == BLOC_TROU) {
+            blocs[i++] = BLOC_TROU;
+            continue;
+        }
+        int n = 1;
+        while (i + n < nbBlocs && f->tabBlocs[i + n] == f->tabBlocs[i] + n * tailleBloc) n++;
+        if (copierStockage(p, f->tabBlocs[i], suivant, (size_t)n * tailleBloc) == -1) {
+            ret = ERROR_WRITE;
+            break;
+        }
+        for (int j = 0; j < n; j++)
+            blocs[i + j] = suivant + j * tailleBloc;
+        suivant += n * tailleBloc;
+        i += n;
+    }
+
+    //les champs suiv copiés désignent les anciens blocs : ils suivent maintenant la nouvelle zone
+    for (i = 0; i < nbBlocs && ret == 0; i++) {
+        if (blocs[i] == BLOC_TROU)
+            continue;
+        off_t suiv = i + 1 < nbBlocs && blocs[i + 1] != BLOC_TROU ? blocs[i + 1] : -1;
+        if (ecrireStockage(p, &suiv, sizeof(off_t), blocs[i] + offsetof(blocData, suiv)) == -1)
+            ret = ERROR_WRITE;
+    }
+
+    //nouvelle tête, nouvelle queue et extents (un seul si le fichier n'a pas de trou)
+    if (ret == 0 && reecrireExtents(f, blocs, nbBlocs) < 0)
+        ret = ERROR_WRITE;
+    if (ret < 0) {
+        //la zone n'est pas décrite par les extents du fichier
+        libererEspace(p, zone, (size_t)nbUnites * tailleBloc);
+        free(blocs);
+        return ret;
+    }
+
+    //rendre les anciens blocs, par zones contigues
+    i = 0;
+    while (i < nbBlocs) {
+        if (f->tabBlocs[i] == BLOC_TROU) {
+            i++;
+            continue;
+        }
+        int n = 1;
+        while (i + n < nbBlocs && f->tabBlocs[i + n] == f->tabBlocs[i] + n * tailleBloc) n++;
+        libererEspace(p, f->tabBlocs[i], (size_t)n * tailleBloc);
+        i += n;
+    }
+    memcpy(f->tabBlocs, blocs, nbBlocs * sizeof(off_t));
+    free(blocs);
+    return 0;
+}
+
+
+/**
+ * @brief Défragmente un fichier (voir myDefrag). Le fichier doit être verrouillé en écriture (par un
+ * descripteur dont le tampon d'écriture est vide) et le verrou de la partition pris.
+ */
+static int defragmenterFichier(file* f, fragmentation* avant, fragmentation* apres) {
+    partition* p = f->part;
+
+    if (chargerTableBlocs(f) < 0 || mesurerFragmentation(f, avant) < 0) return ERROR_READ;
+    if (deplacerEntete(f) < 0) return ERROR_WRITE;
+    if (avant->nbBlocs > 0 && !avant->partage) {
+        int ret = deplacerBlocs(f, avant);
+        if (ret < 0) return ret;
+    }
+
+    //la validation rend l'ancien espace réutilisable par les fichiers défragmentés ensuite
+    if (validerJournal(p) < 0) return ERROR_WRITE;
+    return mesurerFragmentation(f, apres);
+}
+
+
+/**
+ * @brief Défragmente un fichier : ses blocs sont recopiés en une seule suite contiguë, dans l'ordre du fichier.
+ *
+ * La nouvelle zone est le premier espace libre assez grand à partir du début de la partition (à défaut,
+ * la fin de la partition) : les fichiers se rapprochent du début et l'espace libre laissé en fin de
+ * partition lui est retiré au démontage (voir myUnmount). Un fichier déjà d'un seul tenant n'est déplacé
+ * que si un espace libre plus proche du début peut le recevoir.
+ *
+ * Les blocs sont copiés par le noyau (voir copierStockage) et leur champ suiv est réécrit pour désigner
+ * le bloc suivant dans la nouvelle zone ; les extents, la tête et la queue du fichier sont ensuite
+ * réécrits (voir reecrireExtents) et les anciens blocs libérés. L'entête est lui aussi rapproché du
+ * début s'il y a de la place avant lui, et l'élément du répertoire qui le désigne est réécrit.
+ * La transaction du journal est validée, ce qui rend aussitôt l'ancien espace réutilisable.
+ * Les blocs d'un fichier dont un bloc est partagé (voir myClone et mySnapshot) ne sont pas déplacés.
+ *
+ * Les descripteurs ouverts sur le fichier doivent avoir été vidés (myFlush) ; ils rechargent leur
+ * table des blocs à leur prochaine opération. L'entête d'un fichier ouvert ne bouge pas.
+ *
+ * @param p La partition montée.
+ * @param fileName Le nom du fichier à défragmenter.
+ * @param avant Reçoit la fragmentation du fichier avant l'opération (NULL accepté).
+ * @param apres Reçoit la fragmentation du fichier après l'opération (NULL accepté).
+ * @return 0 en cas de succès, ERROR_OPEN si le fichier n'existe pas, une autre valeur d'erreur sinon.
+ */
+int myDefrag(partition* p, char* fileName, fragmentation* avant, fragmentation* apres) {
+    if (p == NULL || fileName == NULL)
+        return ERROR_OTHER;
+
+    pthread_mutex_lock(&p->verrou);
+    off_t offsetEntete = rechercheRepertoire(p, fileName);
+    file* f = offsetEntete < 0 ? NULL : ouvrirDescripteur(p, offsetEntete);
+    pthread_mutex_unlock(&p->verrou);
+    if (offsetEntete == -1) return ERROR_OPEN;
+    if (f == NULL) return ERROR_READ;
+
+    fragmentation mesureAvant, mesureApres;
+    int ret = verrouillerEcriture(f);
+    if (ret == 0) {
+        pthread_mutex_lock(&p->verrou);
+        ret = defragmenterFichier(f, &mesureAvant, &mesureApres);
+        pthread_mutex_unlock(&p->verrou);
+        deverrouillerEcriture(f);
+    }
+    myClose(f);
+    if (ret == 0 && avant != NULL) *avant = mesureAvant;
+    if (ret == 0 && apres != NULL) *apres = mesureApres;
+    return ret;
+}
+
+/*********************************MySync*************************************/
+
+/**
+ * @brief Rend durables toutes les modifications d'une partition montée.
+ *
+ * Les opérations asynchrones en vol sont attendues, puis les données en attente (table des unités
+ * libres, noeuds du répertoire, blocs modifiés du cache de blocs, super bloc) sont écrites (voir flushIndex) puis le support est synchronisé
+ * (fsync, ou msync pour une partition projetée).
+ *
+ * @param p La partition montée.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
+ */
+int mySync(partition* p) {
+    if (p == NULL)
+        return ERROR_OTHER;
+    int ret = 0;
+    pthread_mutex_lock(&p->verrou);
+    compter(&statsDuThread(p)->synchronisations, p->projection != NULL ? 2 : 1);
+    if (attendreMoteur(p) < 0 || flushIndex(p) < 0
+        || synchroniserProjection(p) == -1 || fsync(p->fd) == -1)
+        ret = ERROR_WRITE;
+    pthread_mutex_unlock(&p->verrou);
+    return ret;
+}
+
+/*********************************MyReadv / MyWritev***********************/
+
+/**
+ * @brief Lit des données d'un fichier dans plusieurs tampons (voir myReadv). Le fichier doit être verrouillé en lecture.
+ */
+static int lireVecteur(file* f, const struct iovec* iov, int iovcnt, int total) {
+    partition* p = f->part;
+    int charsParBloc = p->charsParBloc;
+    off_t tailleBloc = p->sb.tailleBloc;
+
+    blocEntete be;
+    if (lireEntete(p, &be, f->numEntete) == -1) return ERROR_READ;
+    if (f->pos >= be.taille) return 0;
+    if (total > be.taille - f->pos) total = be.taille - f->pos;
+    if (f->nbBlocsCharges != be.nbBlocs && chargerTableBlocs(f) < 0) return ERROR_READ;
+
+    curseurVecteur dest = {iov, iovcnt, 0, 0};
+    struct iovec morceaux[IOV_MAX];
+    char entetes[offsetof(blocData, donnee)]; //nbChars / suiv des blocs lus par preadv, ignorés
+    char* bloc = NULL; //tranche d'un bloc en cache
+    int blocNumber = trouverBlocData(f->pos, charsParBloc);
+    int positionInBloc = trouverPosition(f->pos, charsParBloc);
+    int lus = 0;
+    int ret = 0;
+
+    while (lus < total && ret == 0) {
+        int n = charsParBloc - positionInBloc;
+        if (n > total - lus) n = total - lus;
+        off_t offsetBloc = blocNumber > be.nbBlocs ? BLOC_TROU : f->tabBlocs[blocNumber - 1];
+
+        //morceaux de la tranche dans les tampons de l'appelant (un preadv ne peut en prendre que IOV_MAX)
+        int nbMorceaux = 0;
+        curseurVecteur suite = dest;
+        bool decoupable = offsetBloc != BLOC_TROU && decouperVecteur(&suite, n, morceaux, &nbMorceaux, IOV_MAX) == 0;
+
+        if (offsetBloc == BLOC_TROU) {
+            copierVersVecteur(&dest, NULL, n);
+        } else if (!decoupable || estEnCache(p, offsetBloc / tailleBloc)) {
+            if (bloc == NULL && (bloc = malloc(charsParBloc)) == NULL) {
+                ret = ERROR_OTHER;
+                break;
+            }
+            if (lirePartition(p, bloc, n, offsetBloc + offsetof(blocData, donnee) + positionInBloc) == -1) {
+                ret = ERROR_READ;
+                break;
+            }
+            copierVersVecteur(&dest, bloc, n);
+        } else {
+            //zone de blocs consécutifs absents du cache : un seul preadv
+            off_t debut = offsetBloc + offsetof(blocData, donnee) + positionInBloc;
+            size_t attendu = n;
+            dest = suite;
+            while (lus + n < total && blocNumber < be.nbBlocs) {
+                off_t offsetSuivant = f->tabBlocs[blocNumber];
+                if (offsetSuivant != offsetBloc + tailleBloc
+                    || estEnCache(p, offsetSuivant / tailleBloc)
+                    || nbMorceaux == IOV_MAX)
+                    break;
+                int m = charsParBloc;
+                if (m > total - lus - n) m = total - lus - n;
+                int avant = nbMorceaux;
+                morceaux[nbMorceaux].iov_base = entetes;
+                morceaux[nbMorceaux].iov_len = sizeof(entetes);
+                nbMorceaux++;
+                if (decouperVecteur(&dest, m, morceaux, &nbMorceaux, IOV_MAX) < 0) {
+                    nbMorceaux = avant;
+                    break;
+                }
+                attendu += sizeof(entetes) + m;
+                n += m;
+                offsetBloc = offsetSuivant;
+                blocNumber++;
+            }
+
+            if (__atomic_load_n(&p->moteur.nbEcrituresEnVol, __ATOMIC_RELAXED) > 0 && attendreEcritures(p, debut, attendu) < 0) {
+                ret = ERROR_READ;
+                break;
+            }
+            ssize_t r = preadv(p->fd, morceaux, nbMorceaux, debut);
+            compter(&statsDuThread(p)->lectures, 1);
+            if (r > 0) compter(&statsDuThread(p)->octetsLus, r);
+            if (r == -1) {
+                ret = ERROR_READ;
+                break;
+            }
+            //lecture partielle : la suite de chaque morceau est lue séparément (zéros au-delà de la fin)
+            off_t position = debut;
+            for (int k = 0; k < nbMorceaux && (size_t)r < attendu; k++) {
+                off_t fin = position + morceaux[k].iov_len;
+                if (fin > debut + r) {
+                    off_t couverts = debut + r > position ? debut + r - position : 0;
+                    if (lireStockage(p, (char*)morceaux[k].iov_base + couverts, morceaux[k].iov_len - couverts, position + couverts) == -1) {
+                        ret = ERROR_READ;
+                        break;
+                    }
+                }
+                position = fin;
+            }
+        }
+        lus += n;
+        blocNumber++;
+        positionInBloc = 0;
+    }
+    free(bloc);
+    if (ret < 0) return ret;
 
-    return 0; //renvoyer 0 si succés
+    f->pos += lus;
+    return lus;
 }
 
 
-
-/******************************************TAILLE FICHIER***************************************/
-
 /**
- * @brief Calcule la taille du fichier.
+ * @brief Lit des données d'un fichier dans plusieurs tampons (comme readv).
  *
- * Cette fonction calcule la taille du fichier en fonction du nombre de blocs de données qu'il occupe.
+ * Les éléments de iov sont remplis dans l'ordre, à partir de la position courante ; la lecture
+ * s'arrête à la fin du fichier et les trous sont lus comme des caractères nuls. Les blocs sont
+ * repérés une seule fois dans la table des blocs. Les blocs consécutifs dans la partition et
+ * absents du cache de blocs sont lus en un seul appel (preadv) : les données vont directement dans
+ * les tampons de l'appelant, les champs nbChars / suiv des blocs dans un tampon de service.
+ * Les blocs en cache sont copiés depuis le cache.
  *
- * @param f Le pointeur vers la structure de fichier.
- * @return La taille du fichier en octets.
- *         En cas d'erreur, la fonction renvoie une valeur négative correspondant à un code d'erreur spécifique.
+ * @param f Le descripteur de fichier.
+ * @param iov Les tampons.
+ * @param iovcnt Le nombre de tampons.
+ * @return Le nombre d'octets lus, une valeur d'erreur sinon.
  */
-int size(file* f){
-	blocEntete buff;
-
-	if (f== NULL)
-		return ERROR_OTHER;
-
-	off_t offset_entete = f->numEntete;
-	int fd= f->fd; //descripteur de fichier de la partition
-
-	//se deplacer vers le bloc d'entete du fichier
-	if (lseek(fd, offset_entete, SEEK_SET) == -1)
-        	return ERROR_LSEEK;
-
-        //lire le bloc d'entete
-        if (read(fd, &buff, sizeof(struct blocEntete)) == -1)
-        	return ERROR_READ;
-
-        //calculer la taille
-        int sizeFile = buff.nbBlocs*sizeof(struct blocData);
+int myReadv(file* f, const struct iovec* iov, int iovcnt) {
+    int total = tailleVecteur(iov, iovcnt);
+    if (f == NULL || total < 0)
+        return ERROR_OTHER;
+    if (myFlush(f) < 0) return ERROR_WRITE;
 
-        return sizeFile;
+    if (verrouillerLecture(f) < 0) return ERROR_READ;
+    int ret = lireVecteur(f, iov, iovcnt, total);
+    if (ret > 0) compter(&statsDuThread(f->part)->octetsLusFichiers, ret);
+    deverrouillerLecture(f);
+    return ret;
 }
 
 
 /**
- * \brief Calcule la taille réelle d'un fichier.
+ * @brief Écrit dans un fichier les données de plusieurs tampons (comme writev).
  *
- * Cette fonction calcule la taille réelle d'un fichier en parcourant les blocs de données
- * associés au fichier et en sommant le nombre de caractères de chaque bloc.
+ * Les éléments de iov sont écrits à la suite, à partir de la position courante, comme un seul
+ * myWrite : l'entête et la table des blocs sont lus une seule fois et chaque bloc touché reçoit
+ * une seule écriture. Un total inférieur à un bloc passe par le tampon d'écriture du descripteur.
+ * Les blocs consécutifs modifiés dans le cache de blocs sont réécrits ensemble (pwritev, voir viderCache).
  *
- * \param f Un pointeur vers une structure de fichier contenant les informations nécessaires.
- * \return La taille réelle du fichier en nombre de caractères, ou 0 si le fichier est vide,
- *         ou une valeur d'erreur si une erreur s'est produite lors de la lecture des blocs.
- *         Les valeurs d'erreur possibles sont définies dans le fichier d'en-tête correspondant.
+ * @param f Le descripteur de fichier.
+ * @param iov Les tampons.
+ * @param iovcnt Le nombre de tampons.
+ * @return Le nombre d'octets écrits, une valeur d'erreur sinon.
  */
-int getSizeReelFile(file* f){
+int myWritev(file* f, const struct iovec* iov, int iovcnt) {
+    int total = tailleVecteur(iov, iovcnt);
+    if (f == NULL || f->lectureSeule || total < 0)
+        return ERROR_OTHER;
+    if (total == 0)
+        return 0;
 
-    off_t offsetBloc = f->numEntete;
-    blocEntete be;
+    if (verrouillerEcriture(f) < 0) return ERROR_READ;
+    int ret = total;
+    if (total < f->part->charsParBloc) {
+        for (int i = 0; i < iovcnt && ret >= 0; i++) {
+            if (iov[i].iov_len > 0 && ecrireDescripteur(f, iov[i].iov_base, iov[i].iov_len) < 0) ret = ERROR_WRITE;
+        }
+    } else {
+        curseurVecteur source = {iov, iovcnt, 0, 0};
+        ret = viderTampon(f) < 0 ? ERROR_WRITE : ecrireFichier(f, &source, total, -1);
+        if (ret >= 0 && finEcritureJournal(f->part) < 0) ret = ERROR_WRITE;
+    }
+    if (ret > 0) compter(&statsDuThread(f->part)->octetsEcritsFichiers, ret);
+    deverrouillerEcriture(f);
+    return ret;
+}
 
-    //lire le bloc d'entete
-    if (lseek(f->fd,offsetBloc,SEEK_SET)==-1) return ERROR_LSEEK;
-    if (read(f->fd,&be,sizeof(blocEntete))==-1) return ERROR_READ;
+/*********************************MyReadAsync / MyWriteAsync****************/
 
-    //obtenir le nombre de blocs
-    int nbBlocs = be.nbBlocs;
+/**
+ * @brief Lance la lecture asynchrone de données d'un fichier (voir myReadAsync).
+ *
+ * Le fichier doit être verrouillé en lecture et le verrou de la partition pris.
+ */
+static int soumettreLecture(file* f, void* buffer, int nBytes) {
+    partition* p = f->part;
+    int charsParBloc = p->charsParBloc;
+    off_t tailleBloc = p->sb.tailleBloc;
+    char* buff = (char*)buffer;
+    if (p->moteur.type == MOTEUR_AUCUN && p->backend == BACKEND_RW && configurerMoteur(p, MOTEUR_URING) < 0)
+        return ERROR_OTHER;
 
-    //---cas 1: fichier vide => size = 0
-    if (nbBlocs==0) return 0;
+    blocEntete be;
+    if (lireEntete(p, &be, f->numEntete) == -1) return ERROR_READ;
+    if (f->pos >= be.taille) nBytes = 0;
+    else if (nBytes > be.taille - f->pos) nBytes = be.taille - f->pos;
+    if (f->nbBlocsCharges != be.nbBlocs && chargerTableBlocs(f) < 0) return ERROR_READ;
+
+    int jeton = nouvelleRequete(p, nBytes, NULL);
+    if (jeton < 0) return jeton;
+
+    int blocNumber = trouverBlocData(f->pos, charsParBloc);
+    int positionInBloc = trouverPosition(f->pos, charsParBloc);
+    int nbyteslu = 0;
+    while (nbyteslu < nBytes) {
+        int n = charsParBloc - positionInBloc;
+        if (n > nBytes - nbyteslu) n = nBytes - nbyteslu;
+
+        off_t currentBlocOffset = blocNumber > be.nbBlocs ? BLOC_TROU : f->tabBlocs[blocNumber - 1];
+        off_t offsetTranche = currentBlocOffset + offsetof(blocData, donnee) + positionInBloc;
+        int ret = 0;
+        if (currentBlocOffset == BLOC_TROU)
+            memset(buff + nbyteslu, 0, n);
+        else if (estEnCache(p, currentBlocOffset / tailleBloc))
+            ret = lirePartition(p, buff + nbyteslu, n, offsetTranche) == -1 ? ERROR_READ : 0;
+        else
+            ret = soumettreOperation(p, jeton, false, buff + nbyteslu, n, offsetTranche);
+        if (ret < 0) {
+            //les opérations déjà soumises doivent s'achever avant de rendre le tampon
+            scellerRequete(p, jeton);
+            myWait(p, jeton);
+            return ret;
+        }
+        nbyteslu += n;
+        blocNumber++;
+        positionInBloc = 0;
+    }
 
-    //---cas 2: le fichier contient des donnees
-    ////parcours sequentiel et sommation de nbChars de chaque bloc jusqu'à arriver à suivant==-1'
-    blocData bd;
-    ////lire 1er bloc data "bd"
-    if (lseek(f->fd,be.numTete,SEEK_SET)==-1) return ERROR_LSEEK;
-    if (read(f->fd,&bd,sizeof(blocData))==-1) return ERROR_READ;
-    ////initialiser la taille du fichier à taille du 1er bloc data
-    int sizeReel = bd.nbChars;
-    ////commencer le parcours
-    while (bd.suiv!=-1){
-        ////lire bloc prochain
-        if (lseek(f->fd,bd.suiv,SEEK_SET)==-1) return ERROR_LSEEK;
-        if (read(f->fd,&bd,sizeof(blocData))==-1) return ERROR_READ;
-        sizeReel=sizeReel+bd.nbChars;
+    scellerRequete(p, jeton);
+    if (envoyerOperations(p) < 0) {
+        myWait(p, jeton);
+        return ERROR_READ;
     }
-    //renvoyer
-    return sizeReel;
+    f->pos += nBytes;
+    return jeton;
 }
 
-/***********************************************************************************************/
-/*                          FONCTIONS PRINCIPALES                                              */
-/***********************************************************************************************/
-/************************MyFormat*******************************/
 
 /**
- * \brief Fonction pour formater une partition et initialiser un bloc d'index vide.
- *
- * \param partitionName Le nom de la partition à formater.
- * \return 0 si le formattage est réussi, sinon un code d'erreur.
+ * @brief Lance la lecture asynchrone de données d'un fichier.
  *
- * Cette fonction tente de créer un fichier représentant la partition spécifiée. Si le fichier existe déjà,
- * il ouvre le fichier existant. Sinon, il crée un nouveau fichier et écrit un bloc d'index vide dedans.
- *
- * \note Cette fonction utilise les fonctions open, lseek et write pour manipuler les fichiers.
- *
- * \warning Assurez-vous d'avoir les permissions nécessaires pour créer et écrire dans le fichier spécifié.
+ * Comme myRead, la lecture part de la position courante (avancée immédiatement), s'arrête à la fin
+ * du fichier et lit les trous comme des caractères nuls. Chaque tranche de bloc absente du cache de
+ * blocs est confiée au moteur d'entrées / sorties (voir configurerMoteur) et lue directement dans le
+ * tampon de l'appelant ; les tranches en cache sont copiées immédiatement. Toutes les opérations
+ * partent en un seul lot. Le tampon ne doit pas être utilisé avant l'achèvement (myWait / myPoll).
+ * Une tranche dont l'écriture asynchrone est en vol est lue après son achèvement.
  *
- * \see blocIndex
+ * @param f Le descripteur de fichier.
+ * @param buffer Le tampon recevant les données.
+ * @param nBytes Le nombre d'octets à lire.
+ * @return Le jeton d'achèvement (positif ou nul), une valeur d'erreur sinon.
  */
-int myFormat(char* partitionName){
-    //initialiser un bloc d'index vide
-    blocIndex bi = init_blocIndex();
-
-
-    //essayer de creer le fichier representant la partition
-    fd = open(partitionName, O_CREAT | O_EXCL | O_RDWR, 0777);
-
-    if (fd == -1) {
-        //en cas d'erreur car fichier existe deja
-        if (errno == EEXIST) {
-            //fichier de la partition existe deja
-            printf("Formatage d'une partition qui existe deja...\n");
-            //ouverture du fichier representant la partition
-            fd = open(partitionName, O_RDWR);
-            printf("formattage réussi.\n");
-            return 0;
-        } else {
-            //erreur
-            perror("Erreur lors du formattage de la partition.\n");
-            return ERROR_OPEN;
-        }
-    } else {
-        //Partition créée
+int myReadAsync(file* f, void* buffer, int nBytes) {
+    if (f == NULL || buffer == NULL || nBytes < 0)
+        return ERROR_OTHER;
+    if (myFlush(f) < 0) return ERROR_WRITE;
+
+    if (verrouillerLecture(f) < 0) return ERROR_READ;
+    pthread_mutex_lock(&f->part->verrou);
+    int ret = soumettreLecture(f, buffer, nBytes);
+    pthread_mutex_unlock(&f->part->verrou);
+    deverrouillerLecture(f);
+    return ret;
+}
 
-        //ecriture du bloc d'index
-        int offInd=offInd=lseek(fd,0,SEEK_SET);
-        if (offInd==-1) return ERROR_LSEEK;
-        if (write(fd, &bi, sizeof(struct blocIndex)) == -1) return ERROR_WRITE;
 
-        printf("Partition formattée et bloc d'index initialisé avec succés.\n");
-        return 0;
+/**
+ * @brief Réserve le jeton d'une écriture asynchrone et le tampon où ses blocs seront composés (voir soumettreEcriture).
+ *
+ * Une écriture vide reçoit un jeton déjà scellé. Le verrou de la partition doit être pris.
+ *
+ * @return Le jeton (positif ou nul), une valeur d'erreur sinon.
+ */
+static int reserverEcriture(file* f, int size) {
+    partition* p = f->part;
+    int charsParBloc = p->charsParBloc;
+    if (p->moteur.type == MOTEUR_AUCUN && p->backend == BACKEND_RW && configurerMoteur(p, MOTEUR_URING) < 0)
+        return ERROR_OTHER;
+    if (size == 0) {
+        int jeton = nouvelleRequete(p, 0, NULL);
+        if (jeton >= 0) scellerRequete(p, jeton);
+        return jeton;
     }
-}
 
-/*********************************MyOpen***********************************/
-///////////////file * myOpen(char* fileName);///////////////////////////////////////////////
+    //un bloc du tampon par bloc touché
+    int nbTouches = trouverBlocData(f->pos + size - 1, charsParBloc) - trouverBlocData(f->pos, charsParBloc) + 1;
+    char* tampon = calloc(nbTouches, p->sb.tailleBloc);
+    if (tampon == NULL)
+        return ERROR_OTHER;
+    int jeton = nouvelleRequete(p, size, tampon);
+    if (jeton < 0) free(tampon);
+    return jeton;
+}
 
 
 /**
- * @brief Ouvre un fichier et retourne une structure file contenant les informations nécessaires.
+ * @brief Lance l'écriture asynchrone de données dans un fichier (voir myWriteAsync). Le fichier doit être verrouillé en écriture.
  *
- * @param fileName Le nom du fichier à ouvrir.
- * @return Un pointeur vers la structure file si le fichier est ouvert avec succès, NULL sinon.
+ * Le verrou de la partition n'est pris que pour réserver la requête, puis pour la sceller et
+ * l'envoyer : les blocs sont composés hors du verrou (voir ecrireFichier).
  */
-file * myOpen(char* fileName) {
-        off_t offsetEntete;
-    // Charger le bloc d'index
-    blocIndex index=init_blocIndex();
-    if (lseek(fd, 0, SEEK_SET)==-1) {
-    	perror("Erreur de deplacement\n");
-    	return NULL;
-    	} //se deplacer vers debut partition
-    if (read(fd, &index, sizeof(struct blocIndex)) == -1) { //lire le bloc d'index
-        perror("Erreur de lecture du bloc d'index\n");
-        return NULL;
+static int soumettreEcriture(file* f, void* buffer, int size) {
+    if (viderTampon(f) < 0) return ERROR_WRITE;
+
+    partition* p = f->part;
+    pthread_mutex_lock(&p->verrou);
+    int jeton = reserverEcriture(f, size);
+    pthread_mutex_unlock(&p->verrou);
+    if (jeton < 0 || size == 0)
+        return jeton;
+
+    struct iovec iov = {buffer, size};
+    curseurVecteur source = {&iov, 1, 0, 0};
+    int ret = ecrireFichier(f, &source, size, jeton);
+    pthread_mutex_lock(&p->verrou);
+    scellerRequete(p, jeton);
+    if (ret >= 0 && envoyerOperations(p) < 0) ret = ERROR_WRITE;
+    if (ret >= 0 && finOperationJournal(p) < 0) ret = ERROR_WRITE;
+    pthread_mutex_unlock(&p->verrou);
+    if (ret < 0) {
+        //les blocs déjà soumis doivent s'achever avant de rendre le jeton
+        myWait(p, jeton);
+        return ret;
     }
+    return jeton;
+}
 
-    // Rechercher le fichier dans le tableau d'index
-    int pos = rechercheDichotomique(index.tabIndex, index.nbFichiers, fileName);
-
-    // Si le fichier n'existe pas, le créer
-    if (pos == -1) {
-        // Initialiser le bloc d'entête
-        blocEntete entete;
-        strcpy(entete.nomFichier, fileName);
-        entete.nbBlocs = 0;
-        entete.numTete = -1;
 
+/**
+ * @brief Lance l'écriture asynchrone de données dans un fichier.
+ *
+ * Comme myWrite (sans tampon d'écriture), l'écriture part de la position courante, avancée
+ * immédiatement. Les métadonnées (allocation des blocs, extents, taille logique) sont mises à jour
+ * tout de suite ; chaque bloc touché est composé dans un tampon propre à la requête (les données
+ * de l'appelant sont copiées, son tampon est réutilisable dès le retour) puis écrit par le moteur
+ * d'entrées / sorties, toutes les écritures partant en un seul lot. Une écriture partielle d'un bloc
+ * existant le lit d'abord. Les lectures de la bibliothèque attendent les écritures en vol qu'elles
+ * recouvrent (voir attendreEcritures).
+ *
+ * @param f Le descripteur de fichier.
+ * @param buffer Les données à écrire.
+ * @param size Le nombre d'octets à écrire.
+ * @return Le jeton d'achèvement (positif ou nul), une valeur d'erreur sinon.
+ */
+int myWriteAsync(file* f, void* buffer, int size) {
+    if (f == NULL || f->lectureSeule || buffer == NULL || size < 0)
+        return ERROR_OTHER;
 
-    // Écrire le bloc d'entête à la fin de la partition
-        offsetEntete=lseek(fd,0,SEEK_END); //Aller à la fin de la partition
-        if (write(fd, &entete, sizeof(struct blocEntete)) == -1) { //Ecrire l'entete
-            perror("Erreur d'écriture du bloc d'entête\n");
-            return NULL;
-        }
+    if (verrouillerEcriture(f) < 0) return ERROR_READ;
+    int ret = soumettreEcriture(f, buffer, size);
+    deverrouillerEcriture(f);
+    return ret;
+}
 
-        // Ajouter le fichier au tableau d'index et incrémenter le nombre de fichiers
-        elemTabIndex element;
-        strcpy(element.nomFichier, fileName);
-        element.numBlocEntete = offsetEntete;
-        pos=insertionTableauTrie(index.tabIndex, index.nbFichiers, element);
-        index.nbFichiers=index.nbFichiers+1;
 
-        // Écrire le bloc d'index à l'emplacement 0 de la partition
-        if (lseek(fd, 0, SEEK_SET)==-1) {
-        	perror("Erreur de deplacement\n");
-        	return NULL;
-        }
-        if (write(fd, &index, sizeof(blocIndex)) == -1) {
-            perror("Erreur d'écriture du bloc d'index");
-            return NULL;
-        }
+/**
+ * @brief Attend l'achèvement d'une opération asynchrone et libère son jeton.
+ *
+ * @param p La partition montée.
+ * @param jeton Le jeton renvoyé par myReadAsync / myWriteAsync.
+ * @return Le résultat de l'opération (nombre d'octets lus ou écrits), une valeur d'erreur sinon.
+ */
+int myWait(partition* p, int jeton) {
+    if (p == NULL)
+        return ERROR_OTHER;
+    pthread_mutex_lock(&p->verrou);
+    if (jeton < 0 || jeton >= p->moteur.nbRequetes || !p->moteur.requetes[jeton].utilisee) {
+        pthread_mutex_unlock(&p->verrou);
+        return ERROR_OTHER;
     }
 
-    // Ouvrir le fichier (qu'il soit nouveau ou existant)
-    file *f = malloc(sizeof(file));
-    if (f == NULL) {
-        perror("Erreur d'allocation de mémoire");
-        return NULL;
+    int ret = envoyerOperations(p) < 0 ? ERROR_OTHER : 0;
+    while (ret == 0 && p->moteur.requetes[jeton].enCours > 0)
+        if (recolterOperations(p, true) < 0) ret = ERROR_OTHER;
+    if (ret == 0) {
+        requeteES* r = &p->moteur.requetes[jeton];
+        r->utilisee = false;
+        ret = r->resultat;
     }
-    f->fd = fd;
-    f->numEntete = index.tabIndex[pos].numBlocEntete;
-    //printf("num entete is : ")
-    f->pos = 0;
-
-    return f;
+    pthread_mutex_unlock(&p->verrou);
+    return ret;
 }
 
 
-/*********************************MyWrite**********************************/
-
 /**
- * @brief Permet d'écrire des données dans un fichier.
- *
- * La fonction myWrite prend en paramètres un pointeur vers une structure de fichier (file* f), un pointeur vers un buffer de données (void* buffer),
- * et la taille des données à écrire (int size). Elle retourne le nombre de caractères écrits.
+ * @brief Indique, sans attendre, si une opération asynchrone est achevée.
  *
- * La fonction myWrite effectue les opérations suivantes :
- * 1. Trouver le numéro du blocData dans lequel écrire.
- * 2. Obtenir le nombre de blocs du fichier.
- * 3. Gérer le cas où le numéro du bloc dépasse le nombre actuel de blocs dans le fichier.
- *    - Si le fichier est vide, créer un blocData et le chaîner avec le blocEntete.
- *    - Sinon, créer les blocs nécessaires et les chaîner avec le dernier bloc existant.
- * 4. Se déplacer vers l'emplacement où l'écriture va se passer.
- * 5. Trouver la position d'insertion dans le bloc.
- * 6. Écrire les caractères un par un.
- * 7. Gérer le cas où la fin du bloc est atteinte.
- *    - Si un bloc suivant existe, actualiser le bloc précédent et se déplacer vers le bloc suivant.
- *    - Sinon, allouer un nouveau bloc à la fin de la partition.
- * 8. Mettre à jour le nombre de caractères présents dans le bloc.
- * 9. Mettre à jour la position courante dans le fichier.
- * 10. Écrire le blocData final et mettre à jour le nombre de blocs.
+ * Les achèvements disponibles sont traités. Le jeton reste valide jusqu'à myWait.
  *
- * @param f Un pointeur vers une structure de fichier.
- * @param buffer Un pointeur vers un buffer de données.
- * @param size La taille des données à écrire.
- * @return Le nombre de caractères écrits.
+ * @param p La partition montée.
+ * @param jeton Le jeton renvoyé par myReadAsync / myWriteAsync.
+ * @return 1 si l'opération est achevée, 0 si elle est en cours, une valeur d'erreur sinon.
  */
-int myWrite(file* f, void* buffer, int size) {
-    blocData currentBloc;
-    off_t currentBlocOffset;
-    int positionInBloc;
-    int i;
-    char* buff = (char*)buffer;
-
+int myPoll(partition* p, int jeton) {
+    if (p == NULL)
+        return ERROR_OTHER;
+    pthread_mutex_lock(&p->verrou);
+    int ret = ERROR_OTHER;
+    if (jeton >= 0 && jeton < p->moteur.nbRequetes && p->moteur.requetes[jeton].utilisee
+        && envoyerOperations(p) == 0 && recolterOperations(p, false) == 0)
+        ret = p->moteur.requetes[jeton].enCours == 0;
+    pthread_mutex_unlock(&p->verrou);
+    return ret;
+}
 
-    // Trouver le numero du blocData dans lequel écrire
-    int blocNumber = trouverBlocData(f->pos, max_chars_par_bloc);
-
-    //Obtenir le nombre de blocs du fichier
-    int nbBlocs=getNbBlocsFile(f);
-
-    // cas 1 : cas ou le numero du bloc depasse le nombre acuel de blocs dans le fichier
-    //=> creer nbBlocs-blocNumber blocs et se deplacer vers le dernier bloc créé
-    if (blocNumber>nbBlocs) {
-        //cas particulier: cas ou le fichier est vide => creer blocData et le chainer avec blocEntete
-        if (nbBlocs==0) {
-            currentBloc=alloc_bloc();
-            //l'ecrire à la fin de la partition
-            currentBlocOffset=lseek(f->fd, 0, SEEK_END);
-            if (currentBlocOffset==-1) return ERROR_LSEEK;
-            if (write(f->fd, &currentBloc, sizeof(struct blocData))==-1) return ERROR_WRITE;
-            //chainage avec entete
-            setNumTeteFile(f,currentBlocOffset);
-            //incrementer nbBlocs
-            nbBlocs++;
-            setNbBlocsFile(f,nbBlocs);
-        }
-        off_t offsetBlocPrec;
-        blocData blocPrec;
-        //iterations pour la creation des blocs
-        while (blocNumber>nbBlocs) {
-            // ----------------1) CREATION DU NOUVEAU BLOC
-            //creer un nouveau bloc
-            currentBloc=alloc_bloc();
-            //l'ecrire à la fin de la partition
-            currentBlocOffset=lseek(f->fd, 0, SEEK_END);
-            if (currentBlocOffset==-1) return ERROR_LSEEK;
-            if (write(f->fd, &currentBloc, sizeof(struct blocData))==-1) return ERROR_WRITE;
-            // ----------------2) CHAINAGE
-            //obtenir l'offset du dernier bloc du fichier dans la partition
-            offsetBlocPrec=trouveOffsetBlocFile(f, nbBlocs);
-            //le lire
-            lseek(f->fd, offsetBlocPrec, SEEK_SET);
-            if (read(f->fd, &blocPrec, sizeof(blocData))==-1) return ERROR_READ;
-            //effectuer le chainage
-            blocPrec.suiv=currentBlocOffset;
-            //l'actualiser
-            lseek(f->fd, offsetBlocPrec, SEEK_SET);
-            if (write(f->fd, &blocPrec, sizeof(blocData))==-1) return ERROR_WRITE;
-            //incrementer le nombre de blocs
-            setNbBlocsFile(f,nbBlocs+1);
-            nbBlocs++;
-        }
-
-    }
-    // se deplacer vers ou va se passer l'ecriture
-    else {
-        currentBlocOffset= trouveOffsetBlocFile(f, blocNumber);
-        lseek(f->fd, currentBlocOffset, SEEK_SET);
-        read(f->fd, &currentBloc, sizeof(struct blocData));
-    }
-
-    // Trouver la position d'insertion dans le bloc
-    positionInBloc = trouverPosition(f->pos, max_chars_par_bloc);
-    // Écrire les caractères un par un
-    for (i = 0; i < size; i++) {
-        //Si on est arrivé à la fin du bloc
-        if (positionInBloc==max_chars_par_bloc) {
-            if (currentBloc.suiv!=-1){
-            //--cas 1 : bloc suivant existe, on est pas encore arrivé à la fin du fichier
-                //actualiser le bloc precedant
-                lseek(f->fd, currentBlocOffset, SEEK_SET);
-                 write(f->fd, &currentBloc, sizeof(blocData));
-                //se deplacer vers le bloc suivant
-                currentBlocOffset=lseek(f->fd, currentBloc.suiv, SEEK_SET);
-                read(f->fd, &currentBloc, sizeof(blocData));
+/*********************************MyStats***********************************/
 
-            } else {
-            //--cas 2 : allouer un nouveau bloc
-                //le nouveau bloc se trouve à la fin de la partition => actualiser le chainage
-                currentBloc.suiv = lseek(f->fd, 0, SEEK_END);
-                lseek(f->fd, currentBlocOffset, SEEK_SET);
-                write(f->fd, &currentBloc, sizeof(struct blocData));
-                //re-initialiser currentBloc pour l'utiliser comme etant le nouveau bloc
-                currentBloc = alloc_bloc();
-                currentBlocOffset = lseek(f->fd, 0, SEEK_END);
-                write(f->fd,&currentBloc,sizeof(blocData));
-                setNbBlocsFile(f, getNbBlocsFile(f) + 1); //actualiser le nombre de blocs
-            }
-            positionInBloc = 0;
-            blocNumber++;
+/**
+ * @brief Additionne les compteurs de tous les threads ayant utilisé une partition. Le verrou des compteurs doit être pris.
+ */
+static statsES sommerStats(partition* p) {
+    statsES somme;
+    memset(&somme, 0, sizeof(statsES));
+    long* total = (long*)&somme;
+    for (statsThread* t = p->statsThreads; t != NULL; t = t->suivant) {
+        long* compteurs = (long*)&t->compteurs;
+        for (size_t k = 0; k < sizeof(statsES) / sizeof(long); k++)
+            total[k] += __atomic_load_n(&compteurs[k], __ATOMIC_RELAXED);
+    }
+    return somme;
+}
 
-        }
 
-        // Écrire le caractère et mettre à jour le nombre de caractères
-        //si la case etait auparavant vide (pas d'ecraement) alors incrementer le nb de caracteres presents dans bloc
-        if (currentBloc.donnee[positionInBloc]=='\0'){
-            currentBloc.nbChars=currentBloc.nbChars+1;
-        }
-        currentBloc.donnee[positionInBloc] = buff[i];
-        positionInBloc++;
-        // Mettre à jour la position courante dans le fichier
-        f->pos++;
+/**
+ * @brief Additionne les histogrammes d'une opération de tous les threads. Le verrou des compteurs doit être pris.
+ */
+static histogrammeLatences sommerHistogrammes(partition* p, int operation) {
+    histogrammeLatences somme;
+    memset(&somme, 0, sizeof(histogrammeLatences));
+    for (statsThread* t = p->statsThreads; t != NULL; t = t->suivant) {
+        histogrammeLatences* h = &t->histogrammes[operation];
+        somme.nb += __atomic_load_n(&h->nb, __ATOMIC_RELAXED);
+        somme.total += __atomic_load_n(&h->total, __ATOMIC_RELAXED);
+        long max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+        if (max > somme.max) somme.max = max;
+        for (int i = 0; i < NB_CASES_HISTOGRAMME; i++)
+            somme.cases[i] += __atomic_load_n(&h->cases[i], __ATOMIC_RELAXED);
     }
+    return somme;
+}
 
-    // Écrire le blocData final et mettre à jour le nombre de blocs
-    lseek(f->fd, currentBlocOffset, SEEK_SET);
-    write(f->fd, &currentBloc, sizeof(struct blocData));
 
-    return size;
+/**
+ * @brief Renvoie les compteurs d'instrumentation d'une partition.
+ *
+ * Les compteurs de chaque thread sont additionnés : ils couvrent toutes les opérations faites sur la
+ * partition depuis le montage ou le dernier myResetStats, y compris celles des threads du moteur
+ * d'entrées / sorties. Les opérations en cours dans d'autres threads peuvent n'être que partiellement comptées.
+ *
+ * @param p La partition montée.
+ * @return Les compteurs (tous nuls si p est NULL).
+ */
+statsES myStats(partition* p) {
+    statsES s;
+    memset(&s, 0, sizeof(statsES));
+    if (p == NULL)
+        return s;
+    pthread_mutex_lock(&p->verrouStats);
+    s = sommerStats(p);
+    long* total = (long*)&s;
+    long* base = (long*)&p->statsBase;
+    for (size_t k = 0; k < sizeof(statsES) / sizeof(long); k++)
+        total[k] -= base[k];
+    pthread_mutex_unlock(&p->verrouStats);
+    return s;
 }
 
-/*********************************MyRead*************************************/
+
 /**
- * @brief Permet de lire des données à partir d'un fichier.
+ * @brief Remet à zéro les compteurs d'instrumentation d'une partition (voir myStats).
  *
- * La fonction myRead lit les données à partir d'un fichier spécifié par le descripteur de fichier (file *f).
- * Les données lues sont stockées dans un tampon (void *buffer) d'une taille spécifiée (int nBytes).
- * La fonction retourne le nombre d'octets lus avec succès.
+ * Les compteurs des threads ne sont pas modifiés : leur somme actuelle devient la référence
+ * retranchée par myStats. Les histogrammes de latence (voir getHistogramme) sont remis à zéro de la
+ * même façon et les opérations lentes conservées pour exporterTrace sont oubliées.
  *
- * @param f Le descripteur de fichier à partir duquel lire les données.
- * @param buffer Le tampon dans lequel stocker les données lues.
- * @param nBytes Le nombre d'octets à lire.
- * @return Le nombre d'octets lus avec succès, ou une valeur d'erreur en cas d'échec.
+ * @param p La partition montée.
  */
-int myRead(file *f,void * buffer, int nBytes){
-    //mySeek(f,-1,SEEK_END);
-    blocData currentBloc;
-    off_t currentBlocOffset;
-    int positionInBloc;
-    int i;
+void myResetStats(partition* p) {
+    if (p == NULL)
+        return;
+    pthread_mutex_lock(&p->verrouStats);
+    p->statsBase = sommerStats(p);
+    for (int op = 0; op < NB_OPERATIONS_TRACEES; op++)
+        p->histogrammesBase[op] = sommerHistogrammes(p, op);
+    pthread_mutex_unlock(&p->verrouStats);
+    pthread_mutex_lock(&p->trace.verrou);
+    p->trace.nbLentes = 0;
+    __atomic_store_n(&p->trace.seuil, p->trace.capacite > 0 ? 0 : LONG_MAX, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&p->trace.verrou);
+}
 
-    if(f==NULL || buffer==NULL || nBytes <=0)
-    {
-        //Vérification des paramétres d'entrée
-        return ERROR_OTHER;
-    }
-    //on récupére le descripteur du fichier de f
-    int fd = f->fd;
-    // Trouver le numero du blocData dans lequel écrire
-    int blocNumber = trouverBlocData(f->pos, max_chars_par_bloc);
-    // se deplacer vers ou va se passer la lecture
-    currentBlocOffset= trouveOffsetBlocFile(f, blocNumber);
-    lseek(f->fd, currentBlocOffset, SEEK_SET);
-   // read(f->fd, &currentBloc, sizeof(blocData));
 
-    // Trouver la position exacte (dans le bloc) à partir de laquelle on va effectuer la lecture
-    positionInBloc = trouverPosition(f->pos, max_chars_par_bloc);
+/**
+ * @brief Renvoie les compteurs d'instrumentation d'un descripteur.
+ *
+ * Ils couvrent les opérations faites par ce descripteur (lectures, écritures, troncatures, vidages du
+ * tampon...) depuis son ouverture ou le dernier myResetStatsFile, y compris les accès aux entêtes, au
+ * répertoire et au cache qu'elles ont provoqués.
+ *
+ * @param f Le descripteur de fichier.
+ * @return Les compteurs (tous nuls si f est NULL).
+ */
+statsES myStatsFile(file* f) {
+    statsES s;
+    memset(&s, 0, sizeof(statsES));
+    return f == NULL ? s : f->stats;
+}
 
-    if(positionInBloc == -1){
-        printf("La position %d est au delà de 'espace du fichier ..",f->pos);
-        return ERROR_LSEEK;
-    }
 
-    int nbyteslu = 0; // initialisation du nombre d'octets lus
-    //lecture caractére par caractére
-
-    //lecture du 1er bloc à lire
-    // la lecture d'un bloc de données à partir de la position pos
-    ssize_t bloc_read = read(fd, &currentBloc, sizeof(blocData));
-    //mise à jour du nombre d'octets lus
-    // nbyteslu = bloc_read;
-    if (bloc_read == -1) {
-        perror("Erreur lors de la lecture du fichier");
-        return ERROR_READ;
-    }
-    for (i = 0; i < nBytes; i++) {
-
-         // lire le caractére correspondant
-         ((char*)buffer)[i] = currentBloc.donnee[positionInBloc];
-         //Mettre à jour le nombre de caractéres lus
-         nbyteslu++;
-         //Avance le pointeur de lecture
-         positionInBloc++;
-
-        // Mettre à jour la position courante dans le fichier
-        f->pos++;
-        //Si on a parcours tout le bloc, passer au suivant
-        if(positionInBloc == max_chars_par_bloc)
-        {
-            positionInBloc = 0;
-           // Vérifier s'il reste toujours des octets à lire mais qu'on est arrivé à la fin du fichier
-            if (nbyteslu < nBytes && currentBloc.suiv == -1) {
-                     // Fin du fichier atteinte avant de finir la lecture des nBytes
-                     break;
-             }
-
-            // Passer au bloc de données suivant pour continuer à lire
-            off_t bloc_suivant = currentBloc.suiv;
-            if (bloc_suivant == -1) {
-               // Fin du fichier atteinte
-                break;
-            }
+/**
+ * @brief Remet à zéro les compteurs d'instrumentation d'un descripteur (voir myStatsFile).
+ *
+ * @param f Le descripteur de fichier.
+ */
+void myResetStatsFile(file* f) {
+    if (f != NULL)
+        memset(&f->stats, 0, sizeof(statsES));
+}
 
-            // Se déplacer au prochain bloc de données
-            int  prochain_bloc = lseek(fd, bloc_suivant , SEEK_SET);
-            if (prochain_bloc == -1) {
-                perror("Erreur lors du positionnement du pointeur de fichier");
-                return ERROR_LSEEK;
-            }
-            // la lecture d'un bloc de données à partir de la position pos
-            ssize_t bloc_read = read(fd, &currentBloc, sizeof(blocData));
-            //mise à jour du nombre d'octets lus
-            // nbyteslu = bloc_read;
-            if (bloc_read == -1) {
-                perror("Erreur lors de la lecture du fichier");
-                return ERROR_READ;
-            }
+/*********************************Chronométrage****************************/
+
+/**
+ * @brief Active ou désactive le chronométrage de myOpen, myRead, myWrite et mySeek.
+ *
+ * Chaque opération chronométrée est ajoutée à l'histogramme de latences de son thread (voir
+ * getHistogramme) ; les nbLentes opérations les plus lentes sont conservées, avec les sauts de
+ * chaîne faits par trouveOffsetBlocFile, pour exporterTrace. Le coût d'une opération non chronométrée
+ * est un test ; celui d'une opération chronométrée, deux lectures de l'horloge. L'activation vide la
+ * liste des opérations lentes et prend l'instant présent comme origine de la trace.
+ *
+ * @param p La partition montée.
+ * @param actif Vrai pour chronométrer les opérations.
+ * @param nbLentes Le nombre d'opérations lentes à conserver (0 : aucune).
+ * @return 0 en cas de succès, ERROR_OTHER sinon.
+ */
+int configurerTrace(partition* p, bool actif, int nbLentes) {
+    if (p == NULL || nbLentes < 0)
+        return ERROR_OTHER;
+    traceLatences* t = &p->trace;
+    pthread_mutex_lock(&t->verrou);
+    if (nbLentes != t->capacite) {
+        evenementTrace* lentes = nbLentes > 0 ? malloc(nbLentes * sizeof(evenementTrace)) : NULL;
+        if (nbLentes > 0 && lentes == NULL) {
+            pthread_mutex_unlock(&t->verrou);
+            return ERROR_OTHER;
         }
+        free(t->lentes);
+        t->lentes = lentes;
+        t->capacite = nbLentes;
     }
-
-    return nbyteslu;
+    t->nbLentes = 0;
+    __atomic_store_n(&t->seuil, nbLentes > 0 ? 0 : LONG_MAX, __ATOMIC_RELAXED);
+    if (actif) t->origine = horlogeNs();
+    __atomic_store_n(&t->actif, actif, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&t->verrou);
+    return 0;
 }
 
-/*********************************MySeek***********************************/
 
 /**
- * @brief Déplace la position courante dans un fichier.
+ * @brief Renvoie l'histogramme des latences d'une opération, tous threads confondus.
  *
- * Cette fonction permet de déplacer la position courante dans un fichier en fonction de l'offset et de la base spécifiés.
+ * Il couvre les opérations chronométrées depuis le montage ou le dernier myResetStats. Après une
+ * remise à zéro, max est borné par la plus haute case non vide.
  *
- * @param f Un pointeur vers la structure de fichier.
- * @param offset L'offset de déplacement.
- * @param base La base de déplacement (SEEK_SET, SEEK_CUR, SEEK_END).
+ * @param p La partition montée.
+ * @param operation L'opération (TRACE_OPEN, TRACE_READ, TRACE_WRITE ou TRACE_SEEK).
+ * @return L'histogramme (vide si les paramètres sont invalides).
+ */
+histogrammeLatences getHistogramme(partition* p, int operation) {
+    histogrammeLatences h;
+    memset(&h, 0, sizeof(histogrammeLatences));
+    if (p == NULL || operation < 0 || operation >= NB_OPERATIONS_TRACEES)
+        return h;
+    pthread_mutex_lock(&p->verrouStats);
+    h = sommerHistogrammes(p, operation);
+    histogrammeLatences* base = &p->histogrammesBase[operation];
+    h.nb -= base->nb;
+    h.total -= base->total;
+    int derniere = -1;
+    for (int i = 0; i < NB_CASES_HISTOGRAMME; i++) {
+        h.cases[i] -= base->cases[i];
+        if (h.cases[i] > 0) derniere = i;
+    }
+    pthread_mutex_unlock(&p->verrouStats);
+    if (derniere == -1)
+        h.max = 0;
+    else if (borneCase(derniere) < h.max)
+        h.max = borneCase(derniere);
+    return h;
+}
+
+
+/**
+ * @brief Renvoie un percentile d'un histogramme de latences.
  *
- * @note Si la nouvelle position est négative, une erreur sera affichée.
+ * @param h L'histogramme (voir getHistogramme).
+ * @param centile Le percentile voulu, entre 0 et 100 (par exemple 99.9).
+ * @return La latence (ns) en dessous de laquelle se trouvent centile % des opérations, à la précision
+ *         des cases près (la borne haute de la case est renvoyée), 0 si l'histogramme est vide.
  */
-void mySeek(file* f, int offset, int base){
-    int pos=f->pos;
-    switch (base) {
-        case SEEK_SET:
-            offset>=0?f->pos=offset:perror("impossible de se deplacer de l'offset fournit. Nouvelle position negative.");
-            break;
-        case SEEK_CUR:
-            pos = pos+offset;
-            pos>=0?f->pos=pos:perror("impossible de se deplacer de l'offset fournit. Nouvelle position negative.");
-            break;
-        case SEEK_END:
-            pos=getPosLastCharFile(f)+offset;
-            pos>=0?f->pos=pos:perror("impossible de se deplacer de l'offset fournit. Nouvelle position negative.");
-            break;
-        default: //
-            perror("valeur erronée de 'base', valeurs possibles: SEEK_SET, SEEK_CUR, SEEK_END.");
+long percentileLatence(histogrammeLatences* h, double centile) {
+    if (h == NULL || h->nb <= 0)
+        return 0;
+    long rang = (long)(centile / 100.0 * h->nb + 0.999999);
+    if (rang < 1) rang = 1;
+    long cumul = 0;
+    for (int i = 0; i < NB_CASES_HISTOGRAMME; i++) {
+        cumul += h->cases[i];
+        if (cumul >= rang)
+            return borneCase(i) < h->max ? borneCase(i) : h->max;
     }
+    return h->max;
 }
-/*********************************MyClose***********************************/
+
+
+static int comparerDebuts(const void* a, const void* b) {
+    long x = ((const evenementTrace*)a)->debut, y = ((const evenementTrace*)b)->debut;
+    return (x > y) - (x < y);
+}
+
+
+static int comparerDurees(const void* a, const void* b) {
+    long x = ((const evenementTrace*)a)->duree, y = ((const evenementTrace*)b)->duree;
+    return (x < y) - (x > y);
+}
+
 
 /**
- * \brief Ferme un fichier.
+ * @brief Écrit dans un fichier les opérations les plus lentes conservées depuis l'activation de la trace.
  *
- * Cette fonction libère la mémoire allouée pour la structure de fichier spécifiée.
+ * En FORMAT_TRACE_CHROME, le fichier est au format "Trace Event" (tableau traceEvents d'événements
+ * complets, dans l'ordre chronologique), lisible par chrome://tracing ou Perfetto. En FORMAT_TRACE_TEXTE,
+ * c'est une ligne par opération, de la plus lente à la plus rapide. Chaque événement porte la durée,
+ * le thread, le résultat et le nombre de sauts de chaîne de l'opération.
  *
- * \param f Le pointeur vers la structure de fichier à fermer.
+ * @param p La partition montée.
+ * @param chemin Le fichier à écrire (remplacé s'il existe).
+ * @param format FORMAT_TRACE_TEXTE ou FORMAT_TRACE_CHROME.
+ * @return Le nombre d'opérations écrites, une valeur d'erreur sinon.
  */
-void myClose(file* f){
-    free(f);
+int exporterTrace(partition* p, char* chemin, int format) {
+    if (p == NULL || chemin == NULL || (format != FORMAT_TRACE_TEXTE && format != FORMAT_TRACE_CHROME))
+        return ERROR_OTHER;
+
+    //copie des opérations conservées, pour ne pas bloquer les opérations pendant l'écriture
+    pthread_mutex_lock(&p->trace.verrou);
+    int nb = p->trace.nbLentes;
+    evenementTrace* evenements = malloc((nb > 0 ? nb : 1) * sizeof(evenementTrace));
+    if (evenements != NULL && nb > 0) memcpy(evenements, p->trace.lentes, nb * sizeof(evenementTrace));
+    pthread_mutex_unlock(&p->trace.verrou);
+    if (evenements == NULL)
+        return ERROR_OTHER;
+
+    FILE* sortie = fopen(chemin, "w");
+    if (sortie == NULL) {
+        perror("Erreur d'ouverture du fichier de trace");
+        free(evenements);
+        return ERROR_OPEN;
+    }
+    if (format == FORMAT_TRACE_CHROME) {
+        qsort(evenements, nb, sizeof(evenementTrace), comparerDebuts);
+        fprintf(sortie, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+        for (int i = 0; i < nb; i++) {
+            evenementTrace* e = &evenements[i];
+            fprintf(sortie, "  {\"name\": \"%s\", \"cat\": \"projetos\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f,"
+                    " \"pid\": %d, \"tid\": %ld, \"args\": {\"sauts_chaine\": %ld, \"resultat\": %ld}}%s\n",
+                    nomsOperationsTracees[e->operation], e->debut / 1e3, e->duree / 1e3, (int)getpid(), e->thread,
+                    e->sautsChaine, e->resultat, i + 1 < nb ? "," : "");
+        }
+        fprintf(sortie, "]}\n");
+    } else {
+        qsort(evenements, nb, sizeof(evenementTrace), comparerDurees);
+        fprintf(sortie, "#%-9s %16s %14s %10s %12s %12s\n", "operation", "debut (ns)", "duree (ns)", "thread",
+                "sauts", "resultat");
+        for (int i = 0; i < nb; i++) {
+            evenementTrace* e = &evenements[i];
+            fprintf(sortie, "%-10s %16ld %14ld %10ld %12ld %12ld\n", nomsOperationsTracees[e->operation], e->debut,
+                    e->duree, e->thread, e->sautsChaine, e->resultat);
+        }
+    }
+    free(evenements);
+    if (fclose(sortie) != 0)
+        return ERROR_WRITE;
+    return nb;
 }
+
 /*********************************closePartition****************************/
 
 /**
  * @brief Ferme une partition.
  *
- * Cette fonction ferme le descripteur de fichier (partition) spécifié.
+ * Cette fonction démonte la partition spécifiée (voir myUnmount) : les noeuds modifiés
+ * du répertoire sont réécrits puis son descripteur est fermé.
  *
- * @param fd Le descripteur de fichier à fermer.
- * @return 0 en cas de succès, ERROR_OTHER en cas d'erreur.
+ * @param p La partition à fermer.
+ * @return 0 en cas de succès, une valeur d'erreur sinon.
  */
-int closePartition(int fd){
-    if (close(fd)==-1) return ERROR_OTHER;
-    return 0;
+int closePartition(partition* p){
+    return myUnmount(p);
 }
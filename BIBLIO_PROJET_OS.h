@@ -7,22 +7,76 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/uio.h>
 #define SEEK_SET 0
 #define SEEK_CUR 1
 #define SEEK_END 2
-#define max_chars_par_bloc 10
+#define TAILLE_BLOC_DEFAUT 4096
+#define TAILLE_BLOC_MIN 512
+#define TAILLE_BLOC_MAX 65536
 #define ERROR_OTHER -1
 #define ERROR_OPEN -2
 #define ERROR_READ -3
 #define ERROR_WRITE -4
 #define ERROR_LSEEK -5
-#define NB_FILES_MAX 1500
 #define MAX_LEN_NAME 255
+#define NB_EXTENTS_ENTETE 8
+#define NB_EXTENTS_PAR_BLOC 64
+#define MAGIC_PARTITION 0x534F5046 //"FPOS"
+#define VERSION_PARTITION 9
+#define NB_FICHIERS_ANCIEN_FORMAT 1500 //capacité du tableau d'index de l'ancien format, sans super bloc (voir migrer.c)
+#define TAILLE_NOEUD 4096
+#define NB_NOEUDS_CACHE 64
+#define BLOC_TROU 0 //offset d'un bloc non alloué (trou) : l'offset 0 est celui du super bloc
+#define BACKEND_RW 0 //entrées / sorties par pread / pwrite
+#define BACKEND_MMAP 1 //partition projetée en mémoire (mmap)
+#define PAS_PROJECTION (64 * 1024 * 1024) //pas d'agrandissement de la projection
+#define TAILLE_CACHE_DEFAUT (8 * 1024 * 1024) //mémoire du cache de blocs au montage
+#define NB_SEGMENTS_CACHE 16 //nombre maximal de segments (chacun son verrou) du cache de blocs
+#define EMPLACEMENT_PRET 0 //emplacement du cache utilisable
+#define EMPLACEMENT_CHARGEMENT 1 //emplacement en cours de lecture sur le support
+#define EMPLACEMENT_ECRITURE 2 //emplacement en cours de réécriture sur le support
+#define MIN_BLOCS_ANTICIPES 4 //fenêtre initiale de la lecture anticipée
+#define MAX_BLOCS_ANTICIPES 64 //fenêtre maximale de la lecture anticipée
+#define MOTEUR_AUCUN 0 //pas de moteur d'entrées / sorties asynchrones
+#define MOTEUR_URING 1 //opérations soumises par lots à io_uring
+#define MOTEUR_THREADS 2 //groupe de threads (repli quand io_uring est indisponible)
+#define PROFONDEUR_MOTEUR 256 //nombre d'entrées de l'anneau io_uring
+#define NB_THREADS_MOTEUR 4 //nombre de threads du moteur MOTEUR_THREADS
+#define MAX_PARTAGES 65535 //nombre maximal de références supplémentaires d'une unité (myClone)
+#define MAGIC_JOURNAL 0x4C4E524A //"JRNL", entête d'une transaction du journal
+#define TAILLE_JOURNAL (4 * 1024 * 1024) //taille de la zone du journal des métadonnées (deux moitiés)
+#define SEUIL_JOURNAL_DEFAUT (1024 * 1024) //octets d'images de métadonnées qui déclenchent la validation
+#define DELAI_JOURNAL_DEFAUT 100 //délai (ms) au-delà duquel une transaction en cours est validée
+#define TRACE_OPEN 0 //opérations chronométrées (voir configurerTrace)
+#define TRACE_READ 1
+#define TRACE_WRITE 2
+#define TRACE_SEEK 3
+#define NB_OPERATIONS_TRACEES 4
+#define PRECISION_HISTOGRAMME 3 //bits de précision des histogrammes : 8 cases par puissance de 2 (erreur < 12,5 %)
+#define NB_CASES_HISTOGRAMME 312 //cases des histogrammes de latence : jusqu'à 2^40 ns (environ 18 minutes)
+#define FORMAT_TRACE_TEXTE 0 //journal d'événements en texte (voir exporterTrace)
+#define FORMAT_TRACE_CHROME 1 //format "Trace Event" de Chrome (chrome://tracing, Perfetto)
 
-extern int fd;
 /*********************************************************************
  |       		Structures de données				|
  ********************************************************************/
+/**
+ * @struct extent
+ * @brief Structure représentant une suite de blocs de données contigus d'un fichier.
+ *
+ * Les blocs numéros premierBloc .. premierBloc+nbBlocs-1 du fichier se trouvent
+ * les uns à la suite des autres dans la partition à partir de l'offset debut.
+ */
+typedef struct extent{
+    off_t debut; /**< L'offset du premier bloc de données de l'extent depuis le début de la partition */
+    int premierBloc; /**< Le numéro (à partir de 1) du premier bloc du fichier couvert par l'extent */
+    int nbBlocs; /**< Le nombre de blocs de données contigus de l'extent */
+}extent;
+
+
 /**
  * @struct blocEntete
  * @brief Structure représentant l'en-tête d'un bloc de données.
@@ -30,37 +84,180 @@ extern int fd;
  * Cette structure contient les informations relatives à un bloc de données,
  * telles que le nom du fichier, l'offset vers le premier bloc de données du fichier
  * depuis le début de la partition, et le nombre total de blocs de données du fichier.
+ *
+ * Les premiers extents du fichier sont rangés directement dans l'entête, les suivants
+ * dans une liste chaînée de blocs d'extents (blocExtents). Les blocs d'un fichier sont
+ * toujours retrouvés par ses extents.
+ *
+ * La taille logique du fichier et l'offset de son dernier bloc y sont tenus à jour, ce qui
+ * permet d'obtenir la taille et la fin du fichier (SEEK_END) en une seule lecture.
+ *
+ * Un fichier peut être creux : les blocs qu'aucun extent ne couvre (et ceux situés entre le
+ * dernier bloc et la taille logique) sont des trous, non alloués, lus comme des caractères nuls.
  */
 typedef struct blocEntete{
     char nomFichier[MAX_LEN_NAME]; /**< Le nom du fichier */
     off_t numTete; /**< L'offset vers le premier bloc de données du fichier */
-    int nbBlocs; /**< Le nombre total de blocs de données du fichier */
+    int nbBlocs; /**< Le nombre de blocs logiques du fichier, trous compris (numéro du dernier bloc alloué) */
+    int nbExtents; /**< Le nombre total d'extents du fichier (entête + blocs d'extents) */
+    extent tabExtents[NB_EXTENTS_ENTETE]; /**< Les premiers extents du fichier, triés par premierBloc */
+    off_t numExtentsSuiv; /**< L'offset vers le premier bloc d'extents supplémentaire, -1 s'il n'existe pas */
+    int taille; /**< La taille logique du fichier : position qui suit le dernier caractère écrit */
+    off_t numQueue; /**< L'offset vers le dernier bloc de données du fichier, -1 si le fichier est vide */
+    int nbBlocsAlloues; /**< Le nombre de blocs de données réellement alloués (trous exclus) */
 }blocEntete;
 
 
+/**
+ * @struct blocExtents
+ * @brief Structure représentant un bloc d'extents supplémentaire d'un fichier.
+ *
+ * Utilisé lorsque les NB_EXTENTS_ENTETE extents de l'entête ne suffisent plus.
+ */
+typedef struct blocExtents{
+    int nbExtents; /**< Le nombre d'extents présents dans ce bloc */
+    extent tabExtents[NB_EXTENTS_PAR_BLOC]; /**< Les extents, triés par premierBloc */
+    off_t suiv; /**< L'offset vers le bloc d'extents suivant, -1 s'il n'existe pas */
+}blocExtents;
+
+
 /**
  * @struct blocData
  * @brief Structure représentant un bloc de données.
  * 
  * Cette structure contient les informations relatives à un bloc de données.
- * Chaque bloc peut contenir un nombre maximum de "b" données (enregistrements).
+ * Un bloc occupe exactement tailleBloc octets (taille choisie au formatage et rangée
+ * dans le super bloc) et commence à un offset multiple de tailleBloc : un bloc de 4 Ko
+ * correspond donc à une page. Il peut contenir au maximum tailleBloc - offsetof(blocData, donnee)
+ * caractères (voir partition::charsParBloc).
  * 
  * @var blocData::nbChars
- * Nombre de caractères présents actuellement dans le bloc.
+ * Nombre de caractères présents actuellement dans le bloc : position qui suit le dernier caractère écrit.
+ * 
+ * @var blocData::suiv
+ * Offset vers le bloc de données suivant depuis le début de la partition, -1 si le bloc suivant
+ * n'est pas alloué. Les blocs d'un fichier sont retrouvés par ses extents, pas par ce champ.
  * 
  * @var blocData::donnee
  * Tableau de caractères contenant les données du bloc.
- * 
- * @var blocData::suiv
- * Offset vers le bloc de données suivant depuis le début de la partition.
  */
 typedef struct blocData{
-    int nbChars; //nombre de chars presents actuellement dans le bloc
-    char donnee[max_chars_par_bloc]; //un bloc contient au maximum "b" données (enregistrements)
+    int nbChars; //nombre de chars presents actuellement dans le bloc (jusqu'au dernier caractere ecrit)
     off_t suiv; //offset vers le bloc de donnees suivant depuis le debut de la partititon
+    char donnee[]; //un bloc contient au maximum charsParBloc données (enregistrements)
 } blocData;
 
 
+/**
+ * @struct statsES
+ * @brief Structure représentant les compteurs d'instrumentation d'une partition ou d'un descripteur (voir myStats).
+ *
+ * Tous les champs sont des long : myStats les additionne champ par champ.
+ */
+typedef struct statsES{
+    long lectures; /**< Appels système de lecture (pread, preadv) */
+    long ecritures; /**< Appels système d'écriture (pwrite, pwritev) */
+    long copies; /**< Appels système de copie dans la partition (copy_file_range) */
+    long synchronisations; /**< Appels système de synchronisation (fsync, fdatasync, msync) */
+    long soumissions; /**< Appels système io_uring_enter */
+    long autresAppels; /**< Autres appels système (ftruncate, mremap, madvise, posix_fadvise) */
+    long octetsLus; /**< Octets lus sur le support (pread ou copie depuis la projection) */
+    long octetsEcrits; /**< Octets écrits sur le support */
+    long octetsCopies; /**< Octets copiés d'une zone de la partition à une autre (copierStockage) */
+    long octetsLusFichiers; /**< Octets rendus par myRead / myReadv */
+    long octetsEcritsFichiers; /**< Octets acceptés par myWrite / myWritev */
+    long lecturesEntete; /**< Lectures d'un bloc d'entête de fichier */
+    long sautsChaine; /**< Blocs parcourus par trouveOffsetBlocFile (blocs d'extents supplémentaires) */
+    long blocsAlloues; /**< Unités allouées (allouerEspace, allouerEspaceProche) */
+    long blocsLiberes; /**< Unités rendues à la table des unités libres (libererEspace, ou validation du journal qui les libère) */
+    long referencesRetirees; /**< Références retirées à des unités partagées, qui restent occupées (voir partagerEspace) */
+    long lecturesIndex; /**< Lectures d'un noeud du répertoire (lireNoeud) */
+    long ecrituresIndex; /**< Écritures d'un noeud du répertoire (ecrireNoeud, allouerNoeud) */
+    long succesCache; /**< Accès servis par le cache de blocs */
+    long echecsCache; /**< Accès à une unité absente du cache de blocs */
+}statsES;
+
+
+/**
+ * @struct histogrammeLatences
+ * @brief Structure représentant un histogramme log-linéaire des latences d'une opération (voir getHistogramme).
+ *
+ * Chaque puissance de 2 est découpée en 2^PRECISION_HISTOGRAMME cases de même largeur : la précision
+ * relative est constante de la nanoseconde à la minute, pour une taille fixe.
+ */
+typedef struct histogrammeLatences{
+    long nb; /**< Le nombre d'opérations mesurées */
+    long total; /**< La somme des latences (ns) */
+    long max; /**< La plus grande latence (ns) */
+    long cases[NB_CASES_HISTOGRAMME]; /**< Le nombre d'opérations de chaque case */
+}histogrammeLatences;
+
+
+/**
+ * @struct evenementTrace
+ * @brief Structure représentant une opération chronométrée, conservée parmi les plus lentes (voir exporterTrace).
+ */
+typedef struct evenementTrace{
+    int operation; /**< L'opération (TRACE_OPEN, TRACE_READ, TRACE_WRITE ou TRACE_SEEK) */
+    long debut; /**< Le début de l'opération (ns depuis l'activation de la trace) */
+    long duree; /**< La durée de l'opération (ns) */
+    long sautsChaine; /**< Les blocs parcourus par trouveOffsetBlocFile pendant l'opération */
+    long resultat; /**< Le résultat de l'opération (octets, position ou code d'erreur) */
+    long thread; /**< L'identifiant système du thread */
+}evenementTrace;
+
+
+/**
+ * @struct traceLatences
+ * @brief Structure représentant l'état du chronométrage d'une partition (voir configurerTrace).
+ *
+ * Les opérations les plus lentes sont gardées dans un tas (la plus rapide d'entre elles en tête) :
+ * seule une opération plus lente que seuil prend le verrou.
+ */
+typedef struct traceLatences{
+    bool actif; /**< Vrai si les opérations sont chronométrées */
+    long origine; /**< L'instant de l'activation (ns, CLOCK_MONOTONIC) */
+    evenementTrace* lentes; /**< Le tas des opérations les plus lentes */
+    int nbLentes; /**< Le nombre d'opérations du tas */
+    int capacite; /**< Le nombre maximal d'opérations conservées */
+    long seuil; /**< La durée à dépasser pour entrer dans le tas (0 tant qu'il n'est pas plein) */
+    pthread_mutex_t verrou; /**< Protège le tas */
+}traceLatences;
+
+
+/**
+ * @struct statsThread
+ * @brief Structure représentant les compteurs d'un thread pour une partition.
+ *
+ * Seul le thread propriétaire modifie ses compteurs (sans verrou) ; myStats les lit et les additionne.
+ */
+typedef struct statsThread{
+    statsES compteurs; /**< Les compteurs du thread */
+    histogrammeLatences histogrammes[NB_OPERATIONS_TRACEES]; /**< Les latences des opérations chronométrées du thread */
+    const void* proprietaire; /**< Identifie le thread propriétaire */
+    struct statsThread* suivant; /**< Les compteurs du thread suivant de la partition */
+}statsThread;
+
+
+
+/**
+ * @struct fichierOuvert
+ * @brief Structure représentant un fichier ouvert, partagée par tous ses descripteurs.
+ *
+ * Le verrou lecteurs / rédacteur du fichier est pris en lecture par myRead / myReadv / myReadAsync et
+ * en écriture par les opérations qui le modifient : plusieurs lectures d'un même fichier (et les opérations
+ * sur des fichiers différents) se font en parallèle. La version change à chaque modification : un
+ * descripteur dont la table des blocs est plus ancienne la recharge (voir chargerTableBlocs).
+ */
+typedef struct fichierOuvert{
+    off_t numEntete; /**< Offset du bloc d'entête du fichier */
+    int nbDescripteurs; /**< Le nombre de descripteurs ouverts sur le fichier */
+    pthread_rwlock_t verrou; /**< Le verrou lecteurs / rédacteur du fichier */
+    unsigned long version; /**< Le numéro de la dernière modification du fichier */
+    struct fichierOuvert* suivant; /**< Le fichier ouvert suivant de la partition */
+}fichierOuvert;
+
+
 
 /**
  * @struct file
@@ -69,12 +266,42 @@ typedef struct blocData{
  * Cette structure contient les informations nécessaires pour gérer un fichier.
  */
 typedef struct file{
-    int fd; /**< Descripteur de fichier = descripteur de la partition */
+    struct partition* part; /**< La partition montée contenant le fichier */
     int pos; /**< Pointeur de lecture/écriture */
     off_t numEntete; /**< Offset vers le bloc d'entête du fichier depuis le début de la partition */
+    off_t* tabBlocs; /**< Table des blocs : tabBlocs[i] est l'offset du bloc numéro i+1 du fichier (BLOC_TROU pour un trou) */
+    int nbBlocsCharges; /**< Le nombre de blocs connus dans tabBlocs */
+    int capaciteBlocs; /**< Le nombre de cases allouées pour tabBlocs */
+    char* tampon; /**< Le tampon d'écriture (charsParBloc caractères, alloué à la première petite écriture) */
+    int debutTampon; /**< La position dans le fichier du premier caractère du tampon */
+    int nbTampon; /**< Le nombre de caractères en attente dans le tampon, 0 s'il est vide */
+    int finLecture; /**< La position où la dernière lecture s'est arrêtée (détection des lectures séquentielles) */
+    int fenetreLecture; /**< Le nombre de blocs de la lecture anticipée, 0 si l'accès n'est pas séquentiel */
+    int blocAnticipe; /**< Le numéro du dernier bloc déjà chargé à l'avance */
+    bool lectureSeule; /**< Vrai pour un fichier d'un instantané (myOpenSnapshot) : les écritures sont refusées */
+    fichierOuvert* ouvert; /**< Le fichier ouvert (verrou et version), partagé avec les autres descripteurs du fichier */
+    unsigned long versionBlocs; /**< La version du fichier à laquelle correspond tabBlocs */
+    statsES stats; /**< Les compteurs d'instrumentation des opérations faites par ce descripteur (voir myStatsFile) */
 }file;
 
 
+/**
+ * @struct fragmentation
+ * @brief Structure représentant la fragmentation des blocs d'un fichier (voir myDefrag).
+ *
+ * Un fragment est une suite de blocs alloués, pris dans l'ordre du fichier (trous ignorés), qui se
+ * suivent dans la partition. Un fichier non fragmenté a un seul fragment et une étendue égale à son nombre de blocs.
+ */
+typedef struct fragmentation{
+    int nbBlocs; /**< Le nombre de blocs de données alloués du fichier */
+    int nbFragments; /**< Le nombre de suites de blocs contigus dans l'ordre du fichier */
+    int nbExtents; /**< Le nombre d'extents du fichier (0 pour un fichier vide) */
+    off_t etendue; /**< Le nombre de blocs de la partition entre le premier et le dernier bloc du fichier, inclus */
+    off_t debut; /**< L'offset du bloc le plus proche du début de la partition, -1 si le fichier est vide */
+    bool partage; /**< Vrai si un bloc est partagé (voir myClone, mySnapshot) : le fichier n'est pas déplacé */
+}fragmentation;
+
+
 /**
  * @struct elemTabIndex
  * @brief Structure représentant un élément du tableau d'index.
@@ -86,13 +313,378 @@ typedef struct elemTabIndex{
 
 
 /**
- * @struct blocIndex
- * @brief Structure représentant un bloc d'index.
+ * @struct instantane
+ * @brief Structure représentant un instantané de la partition (voir mySnapshot) dans le catalogue des instantanés.
+ *
+ * Les fichiers de l'instantané sont des clones (voir myClone) des fichiers du répertoire au moment
+ * de sa création. Ils sont décrits par un tableau d'éléments trié par nom, écrit une fois pour toutes.
+ */
+typedef struct instantane{
+    char nom[MAX_LEN_NAME]; /**< Le nom de l'instantané */
+    off_t index; /**< L'offset du tableau (trié par nom) des fichiers de l'instantané, -1 s'il n'a aucun fichier */
+    int nbFichiers; /**< Le nombre de fichiers de l'instantané */
+}instantane;
+
+
+/**
+ * @struct superBloc
+ * @brief Structure représentant le super bloc, placé au début de la partition.
+ *
+ * Le super bloc occupe les TAILLE_NOEUD premiers octets de la partition (arrondis à tailleBloc).
+ *
+ * Il référence aussi la table des unités libres (un bit par unité de tailleBloc octets, 1 = libre).
+ * Tant que la partition est montée et que la table a été modifiée, bitmapValide vaut 0 sur le disque :
+ * après un arrêt brutal, la table est reconstruite au montage à partir des fichiers du répertoire.
+ *
+ * La table des partages (un compteur de 16 bits par unité) donne, pour chaque bloc de données partagé
+ * par plusieurs fichiers (voir myClone), le nombre de références au-delà de la première. Elle est
+ * enregistrée et reconstruite avec la table des unités libres, sous le même indicateur bitmapValide.
+ *
+ * Il référence le catalogue des instantanés de la partition (voir mySnapshot).
+ *
+ * Enfin il référence le journal des métadonnées (voir ecrireMetadonnees) : les transactions de numéro
+ * inférieur à sequenceJournal sont déjà appliquées et ne sont pas rejouées au montage.
+ */
+typedef struct superBloc{
+    int magic; /**< MAGIC_PARTITION, permet de reconnaître une partition formatée */
+    int version; /**< La version du format de la partition */
+    off_t racine; /**< L'offset du noeud racine du répertoire */
+    int nbFichiers; /**< Le nombre total de fichiers dans la partition */
+    int hauteur; /**< La hauteur de l'arbre du répertoire (1 : la racine est une feuille) */
+    int tailleBloc; /**< La taille (puissance de 2) en octets d'un bloc, choisie au formatage */
+    off_t bitmap; /**< L'offset de la table des unités libres, -1 si elle n'existe pas */
+    int tailleBitmap; /**< La taille en octets (multiple de tailleBloc) de la zone de la table des unités libres */
+    int bitmapValide; /**< 1 si la table des unités libres enregistrée est à jour, 0 s'il faut la reconstruire */
+    off_t partages; /**< L'offset de la table des partages, -1 si elle n'existe pas */
+    int taillePartages; /**< La taille en octets (multiple de tailleBloc) de la zone de la table des partages */
+    off_t instantanes; /**< L'offset du catalogue des instantanés (tableau d'instantane), -1 s'il n'y en a aucun */
+    int nbInstantanes; /**< Le nombre d'instantanés du catalogue */
+    off_t journal; /**< L'offset de la zone du journal des métadonnées, -1 si la partition n'a pas de journal */
+    int tailleJournal; /**< La taille en octets (multiple de 2 * tailleBloc) de la zone du journal */
+    long sequenceJournal; /**< Le numéro de la première transaction du journal qui reste à rejouer */
+}superBloc;
+
+
+/**
+ * @struct enteteTransaction
+ * @brief Structure représentant l'entête d'une transaction du journal des métadonnées.
+ *
+ * L'entête est suivie de la table des unités de la transaction (nbUnites numéros d'unité) puis de la table
+ * des unités révoquées (nbRevocations numéros d'unité) ; les images des unités (tailleBloc octets chacune)
+ * commencent à l'unité suivante. La somme de contrôle couvre le tout : une transaction écrite
+ * partiellement n'est pas rejouée.
+ */
+typedef struct enteteTransaction{
+    int magic; /**< MAGIC_JOURNAL */
+    int nbUnites; /**< Le nombre d'unités de la transaction */
+    int nbRevocations; /**< Le nombre d'unités de la transaction précédente à ne plus rejouer (libérées depuis) */
+    unsigned int somme; /**< La somme de contrôle (FNV-1a) de la transaction, calculée avec somme = 0 */
+    long sequence; /**< Le numéro de la transaction */
+}enteteTransaction;
+
+
+#define NB_ENTREES_FEUILLE ((int)((TAILLE_NOEUD - 16) / sizeof(elemTabIndex)))
+#define NB_CLES_INTERNE ((int)((TAILLE_NOEUD - 16 - sizeof(off_t)) / (MAX_LEN_NAME + sizeof(off_t))))
+
+/**
+ * @struct noeudRepertoire
+ * @brief Structure représentant un noeud (de taille TAILLE_NOEUD) du répertoire en arbre B+.
+ *
+ * Les feuilles contiennent les éléments (nom, offset de l'entête) triés par nom et sont
+ * chaînées entre elles pour le parcours ordonné. Dans un noeud interne, le fils i contient
+ * les noms compris entre cles[i-1] (inclus) et cles[i] (exclu).
+ */
+typedef struct noeudRepertoire{
+    int estFeuille; /**< 1 pour une feuille, 0 pour un noeud interne */
+    int nbCles; /**< Le nombre d'éléments (feuille) ou de clés (noeud interne) */
+    off_t suiv; /**< L'offset de la feuille suivante, -1 s'il n'y en a pas (feuilles uniquement) */
+    union{
+        elemTabIndex entrees[NB_ENTREES_FEUILLE]; /**< Les éléments d'une feuille, triés par nom */
+        struct{
+            off_t fils[NB_CLES_INTERNE + 1]; /**< Les offsets des noeuds fils */
+            char cles[NB_CLES_INTERNE][MAX_LEN_NAME]; /**< Les clés de séparation */
+        }interne;
+        char remplissage[TAILLE_NOEUD - 16];
+    };
+}noeudRepertoire;
+
+
+/**
+ * @struct noeudCache
+ * @brief Structure représentant un emplacement du cache de noeuds du répertoire.
+ */
+typedef struct noeudCache{
+    off_t offset; /**< L'offset du noeud dans la partition, -1 si l'emplacement est libre */
+    bool modifie; /**< Vrai si le noeud doit être réécrit dans la partition */
+    noeudRepertoire noeud; /**< La copie du noeud */
+}noeudCache;
+
+
+/**
+ * @struct emplacementCache
+ * @brief Structure représentant un emplacement (une unité de tailleBloc octets) du cache de blocs.
+ */
+typedef struct emplacementCache{
+    off_t unite; /**< Le numéro de l'unité (offset / tailleBloc), -1 si l'emplacement est libre */
+    bool modifie; /**< Vrai si l'unité doit être réécrite dans la partition */
+    bool reference; /**< Bit de référence de l'algorithme de l'horloge */
+    bool perime; /**< Vrai si l'unité a été écrite sur le support pendant sa lecture (à relire) */
+    char etat; /**< EMPLACEMENT_PRET, EMPLACEMENT_CHARGEMENT ou EMPLACEMENT_ECRITURE */
+    int suivant; /**< L'emplacement suivant de la même case de la table de hachage, -1 s'il n'y en a pas */
+}emplacementCache;
+
+
+/**
+ * @struct segmentCache
+ * @brief Structure représentant un segment du cache de blocs : les unités dont le numéro a le même reste
+ * modulo le nombre de segments, sous leur propre verrou.
+ *
+ * Les emplacements sont retrouvés par une table de hachage sur le numéro d'unité et remplacés
+ * selon l'algorithme de l'horloge (CLOCK). Les lectures et écritures sur le support se font hors
+ * du verrou : l'emplacement concerné est marqué EMPLACEMENT_CHARGEMENT ou EMPLACEMENT_ECRITURE
+ * le temps de l'entrée / sortie, et les threads qui en ont besoin attendent sur disponible.
+ */
+typedef struct segmentCache{
+    pthread_mutex_t verrou; /**< Protège le segment */
+    pthread_cond_t disponible; /**< Signale la fin d'une entrée / sortie sur un emplacement */
+    int nbEmplacements; /**< Le nombre d'emplacements du segment */
+    emplacementCache* emplacements; /**< Les emplacements */
+    char* donnees; /**< Les données des emplacements (nbEmplacements * tailleBloc octets) */
+    int* tableHachage; /**< Le premier emplacement de chaque case de la table de hachage, -1 si la case est vide */
+    int masqueHachage; /**< Le nombre de cases de la table de hachage moins 1 (puissance de 2) */
+    int aiguille; /**< L'aiguille de l'algorithme de l'horloge */
+    long succes; /**< Le nombre d'accès à une unité présente dans le segment */
+    long echecs; /**< Le nombre d'accès à une unité absente du segment */
+    long evictions; /**< Le nombre d'unités retirées du segment pour faire de la place */
+    long ecritures; /**< Le nombre d'unités modifiées réécrites dans la partition */
+    long prechargements; /**< Le nombre d'unités chargées par la lecture anticipée */
+}segmentCache;
+
+
+/**
+ * @struct cacheBlocs
+ * @brief Structure représentant le cache de blocs d'une partition, partagé par tous les fichiers.
+ *
+ * Le cache est découpé en segments (voir segmentCache) : des threads qui accèdent à des unités de
+ * segments différents ne se disputent pas de verrou. Les écritures sont différées (write-back).
+ */
+typedef struct cacheBlocs{
+    int nbEmplacements; /**< Le nombre d'emplacements, 0 si le cache est désactivé */
+    int nbSegments; /**< Le nombre de segments (puissance de 2, au plus NB_SEGMENTS_CACHE) */
+    segmentCache* segments; /**< Les segments */
+}cacheBlocs;
+
+
+/**
+ * @struct statsCache
+ * @brief Structure représentant les compteurs du cache de blocs (voir getStatsCache).
+ */
+typedef struct statsCache{
+    long succes; /**< Le nombre d'accès servis par le cache */
+    long echecs; /**< Le nombre d'accès à une unité absente du cache */
+    long evictions; /**< Le nombre d'unités retirées du cache */
+    long ecritures; /**< Le nombre d'unités modifiées réécrites dans la partition */
+    long prechargements; /**< Le nombre d'unités chargées par la lecture anticipée */
+}statsCache;
+
+
+/**
+ * @struct operationES
+ * @brief Structure représentant une opération (lecture ou écriture d'une zone de la partition) du moteur d'entrées / sorties.
+ */
+typedef struct operationES{
+    bool ecriture; /**< Vrai pour une écriture */
+    char* buffer; /**< Le tampon de l'opération */
+    size_t taille; /**< Le nombre d'octets à transférer */
+    off_t offset; /**< L'offset de la zone dans la partition */
+    int jeton; /**< La requête à laquelle appartient l'opération */
+    bool enVol; /**< Vrai de la soumission à la fin du traitement de l'achèvement */
+    ssize_t resultat; /**< Le nombre d'octets transférés, négatif en cas d'erreur (MOTEUR_THREADS) */
+    int suivante; /**< L'opération suivante (opérations libres, file d'attente ou opérations achevées), -1 s'il n'y en a pas */
+}operationES;
+
+
+/**
+ * @struct requeteES
+ * @brief Structure représentant une requête asynchrone (myReadAsync / myWriteAsync), repérée par son jeton.
+ */
+typedef struct requeteES{
+    bool utilisee; /**< Vrai tant que le jeton n'a pas été rendu par myWait */
+    int enCours; /**< Le nombre d'opérations de la requête non achevées */
+    int resultat; /**< Le résultat de la requête (nombre d'octets, ou valeur d'erreur) */
+    char* tampon; /**< Le tampon intermédiaire de la requête (blocs composés par myWriteAsync), NULL s'il n'y en a pas */
+}requeteES;
+
+
+/**
+ * @struct anneauES
+ * @brief Structure représentant un anneau io_uring (files de soumission et d'achèvement projetées en mémoire).
  */
-typedef struct blocIndex{
-    int nbFichiers; /**< Le nombre total de fichiers dans la partition, équivalent au nombre d'éléments présents dans le tableau d'index. */
-    elemTabIndex tabIndex[NB_FILES_MAX]; /**< Le tableau d'index contenant les éléments de l'index. */
-}blocIndex;
+typedef struct anneauES{
+    int fd; /**< Le descripteur de l'anneau */
+    unsigned nbEntrees; /**< Le nombre d'entrées de la file de soumission */
+    char* sq; /**< La projection de la file de soumission */
+    char* cq; /**< La projection de la file d'achèvement (égale à sq si elles sont projetées ensemble) */
+    void* sqes; /**< Les entrées de soumission */
+    size_t tailleSq; /**< La taille de la projection sq */
+    size_t tailleCq; /**< La taille de la projection cq */
+    size_t tailleSqes; /**< La taille de la projection sqes */
+    unsigned* sqTete; /**< La tête de la file de soumission (avancée par le noyau) */
+    unsigned* sqQueue; /**< La queue de la file de soumission */
+    unsigned sqMasque; /**< Le masque des indices de la file de soumission */
+    unsigned* sqTableau; /**< Le tableau d'indices de la file de soumission */
+    unsigned* cqTete; /**< La tête de la file d'achèvement */
+    unsigned* cqQueue; /**< La queue de la file d'achèvement (avancée par le noyau) */
+    unsigned cqMasque; /**< Le masque des indices de la file d'achèvement */
+    void* cqes; /**< Les entrées d'achèvement */
+    unsigned aSoumettre; /**< Le nombre d'entrées préparées pas encore transmises au noyau */
+}anneauES;
+
+
+/**
+ * @struct moteurES
+ * @brief Structure représentant le moteur d'entrées / sorties asynchrones d'une partition (voir configurerMoteur).
+ */
+typedef struct moteurES{
+    int type; /**< MOTEUR_AUCUN, MOTEUR_URING ou MOTEUR_THREADS */
+    pthread_mutex_t verrou; /**< Protège les opérations et les files */
+    pthread_cond_t travail; /**< Signale aux threads une opération en file (MOTEUR_THREADS) */
+    pthread_cond_t achevement; /**< Signale une opération achevée (MOTEUR_THREADS) */
+    operationES* operations; /**< Les opérations */
+    int capaciteOperations; /**< Le nombre d'opérations allouées */
+    int opLibre; /**< La première opération libre, -1 s'il n'y en a pas */
+    int nbEnVol; /**< Le nombre d'opérations soumises non terminées */
+    int nbEcrituresEnVol; /**< Le nombre d'écritures soumises non terminées (lu sans verrou par les lectures : accès atomiques) */
+    int fileTete; /**< La première opération en file (MOTEUR_THREADS), -1 si la file est vide */
+    int fileQueue; /**< La dernière opération en file (MOTEUR_THREADS) */
+    int termineesTete; /**< La première opération achevée à traiter (MOTEUR_THREADS) */
+    bool arret; /**< Demande l'arrêt des threads */
+    pthread_t threads[NB_THREADS_MOTEUR]; /**< Les threads (MOTEUR_THREADS) */
+    int nbThreads; /**< Le nombre de threads démarrés */
+    anneauES anneau; /**< L'anneau io_uring (MOTEUR_URING) */
+    requeteES* requetes; /**< Les requêtes, indexées par jeton */
+    int nbRequetes; /**< Le nombre de requêtes allouées */
+}moteurES;
+
+
+/**
+ * @struct journalMeta
+ * @brief Structure représentant le journal des métadonnées d'une partition montée et sa transaction en cours.
+ *
+ * Les unités de métadonnées modifiées (voir ecrireMetadonnees) sont retrouvées par une table de hachage
+ * sur le numéro d'unité. Elles restent en mémoire jusqu'à la validation de la transaction, qui les écrit
+ * dans une moitié du journal (les deux moitiés sont utilisées à tour de rôle) avant de les appliquer en place.
+ * Une transaction n'est validée qu'entre deux opérations (à la fin de l'une d'elles ou par le thread
+ * validateur quand elle a atteint son âge limite) : elle grandit autant que l'opération en cours
+ * le demande, et la zone du journal est déplacée dans une zone plus grande si elle ne tient plus dans
+ * une moitié (voir deplacerJournal).
+ */
+typedef struct journalMeta{
+    int capacite; /**< Le nombre d'unités allouées pour la transaction en cours (agrandi au besoin), 0 si la partition n'a pas de journal */
+    int capaciteMoitie; /**< Le nombre d'unités d'une transaction qui tiennent dans une moitié de la zone du journal */
+    int nbUnites; /**< Le nombre d'unités de la transaction en cours */
+    off_t* unites; /**< Les unités de la transaction en cours */
+    char* images; /**< Le nouveau contenu de ces unités (capacite * tailleBloc octets) */
+    int* tableHachage; /**< La première unité de chaque case de la table de hachage, -1 si la case est vide */
+    int* suivants; /**< L'unité suivante de la même case de la table de hachage, -1 s'il n'y en a pas */
+    int masqueHachage; /**< Le nombre de cases de la table de hachage moins 1 (puissance de 2) */
+    off_t* precedentes; /**< Les unités de la dernière transaction validée, triées */
+    bool* revoquees; /**< Vrai pour une unité de precedentes libérée depuis cette validation */
+    int nbPrecedentes; /**< Le nombre d'unités de precedentes */
+    int nbRevocations; /**< Le nombre d'unités de precedentes révoquées */
+    off_t* liberees; /**< Les zones (première unité, nombre d'unités) libérées par la transaction en cours */
+    int nbLiberees; /**< Le nombre de zones de liberees */
+    int capaciteLiberees; /**< Le nombre de zones allouées pour liberees */
+    off_t unitesLiberees; /**< Le nombre total d'unités des zones de liberees */
+    long sequence; /**< Le numéro de la prochaine transaction */
+    int moitie; /**< La moitié du journal (0 ou 1) qui reçoit la prochaine transaction */
+    size_t seuil; /**< La taille des images (ou de l'espace libéré) en octets à partir de laquelle la transaction est validée */
+    int delai; /**< L'âge (en millisecondes) à partir duquel la transaction est validée */
+    long long debut; /**< L'instant (en millisecondes) de la première écriture de la transaction en cours */
+    long validations; /**< Le nombre de transactions validées (une synchronisation du support chacune) */
+    pthread_t validateur; /**< Le thread qui valide la transaction en cours quand elle atteint l'âge delai (voir validerPeriodiquement) */
+    bool validateurActif; /**< Vrai si ce thread est démarré */
+    pthread_mutex_t verrouValidateur; /**< Protège reveil et arret (toujours pris en dernier) */
+    pthread_cond_t condValidateur; /**< Réveille le thread : transaction ouverte, délai modifié ou arrêt */
+    bool reveil; /**< Vrai si le thread doit réexaminer la transaction en cours */
+    bool arret; /**< Vrai si le thread doit s'arrêter */
+}journalMeta;
+
+
+/**
+ * @struct partition
+ * @brief Structure représentant une partition montée.
+ *
+ * C'est le contexte explicite de la bibliothèque : il est passé à myOpen et chaque descripteur
+ * de fichier en garde une référence. Toutes les entrées / sorties sont positionnelles (pread / pwrite),
+ * des descripteurs indépendants ne partagent donc pas de position de lecture.
+ *
+ * Le super bloc est chargé au montage. Les noeuds du répertoire sont conservés dans un cache
+ * (à correspondance directe) et seuls les noeuds modifiés sont réécrits lors de flushIndex,
+ * d'une éviction ou du démontage.
+ *
+ * Les blocs (entêtes, blocs de données, extents) sont lus et écrits à travers un cache de blocs
+ * partagé (voir configurerCache) ; ses écritures différées sont rendues durables par flushIndex / mySync.
+ *
+ * L'espace libéré (myDelete, myTruncate) est mémorisé dans une table d'unités libres tenue en mémoire
+ * (un bit par unité de tailleBloc octets) et réutilisé par allouerEspace avant d'agrandir la partition.
+ * Un bloc partagé par plusieurs fichiers (myClone) n'est rendu qu'à la libération de sa dernière référence.
+ *
+ * Le mode d'accès est choisi au montage : BACKEND_RW (pread / pwrite) ou BACKEND_MMAP (partition
+ * projetée en mémoire, les blocs sont copiés ou lus directement dans la projection).
+ *
+ * Les métadonnées (entêtes, blocs d'extents, noeuds du répertoire, super bloc) sont modifiées par
+ * transactions dans le journal des métadonnées (voir ecrireMetadonnees et validerJournal).
+ *
+ * La bibliothèque peut être appelée depuis plusieurs threads, chacun avec ses propres descripteurs (un
+ * descripteur ne doit pas être utilisé par deux threads à la fois). Le verrou de la partition sérialise
+ * les modifications du répertoire, des tables des unités libres et des partages, du journal et des
+ * extents ; les données d'un fichier sont lues et écrites sous le seul verrou de ce fichier (voir
+ * fichierOuvert), puis, brièvement, ceux du journal, d'un segment du cache de blocs et de la projection. Une écriture
+ * ne prend le verrou de la partition que pour allouer ses blocs, puis pour les enregistrer dans les
+ * extents avec la nouvelle taille (voir ecrireFichier) : les écritures de fichiers différents copient
+ * leurs données en parallèle. Le verrou des copies les sépare de myCopy, myClone et mySnapshot.
+ * Les verrous sont toujours pris dans cet ordre : fichier, copies, partition, journal, moteur
+ * d'entrées / sorties, segment du cache (un seul à la fois), projection.
+ * myMount, myUnmount, configurerMoteur et configurerCache ne doivent pas être concurrents d'une autre opération.
+ *
+ * Les compteurs d'instrumentation (appels système, octets, sauts de chaîne, allocations, accès au
+ * répertoire et au cache) sont tenus par thread, sans verrou ni contention, et additionnés par myStats.
+ * De même pour les histogrammes de latence de myOpen, myRead, myWrite et mySeek, quand le chronométrage
+ * est activé (voir configurerTrace).
+ */
+typedef struct partition{
+    int fd; /**< Descripteur de fichier de la partition */
+    superBloc sb; /**< Copie en mémoire du super bloc */
+    bool superBlocModifie; /**< Vrai si le super bloc doit être réécrit */
+    int charsParBloc; /**< Le nombre maximal de caractères d'un bloc de données */
+    off_t finPartition; /**< La fin (alignée sur tailleBloc) de l'espace alloué de la partition */
+    noeudCache* cacheNoeuds; /**< Le cache des noeuds du répertoire (NB_NOEUDS_CACHE emplacements) */
+    int backend; /**< Le mode d'accès à la partition (BACKEND_RW ou BACKEND_MMAP) */
+    char* projection; /**< La projection en mémoire de la partition (BACKEND_MMAP) */
+    off_t tailleProjection; /**< La taille de la projection */
+    unsigned char* bitmapLibre; /**< La table des unités libres (bit à 1 : unité libre) */
+    off_t octetsBitmap; /**< La taille en octets (multiple de 8) de bitmapLibre ; les unités au-delà sont occupées */
+    off_t nbUnitesLibres; /**< Le nombre d'unités libres de la table */
+    off_t curseurLibre; /**< L'unité à partir de laquelle reprendre la recherche d'espace libre */
+    bool bitmapModifiee; /**< Vrai si la table enregistrée dans la partition n'est plus à jour */
+    unsigned short* partages; /**< La table des partages : nombre de références supplémentaires de chaque unité, NULL si aucun bloc n'est partagé */
+    off_t nbPartages; /**< Le nombre d'unités couvertes par partages ; les unités au-delà ne sont pas partagées */
+    cacheBlocs cache; /**< Le cache de blocs (BACKEND_RW) */
+    moteurES moteur; /**< Le moteur d'entrées / sorties asynchrones */
+    journalMeta journal; /**< Le journal des métadonnées */
+    pthread_mutex_t verrou; /**< Sérialise les modifications des métadonnées et de l'espace libre de la partition (récursif) */
+    pthread_rwlock_t verrouCopies; /**< Pris en lecture par les écritures de fichiers, en écriture par myCopy, myClone et mySnapshot */
+    pthread_rwlock_t verrouJournal; /**< Protège la transaction en cours (lue par recouvrirJournal) */
+    pthread_rwlock_t verrouProjection; /**< Protège l'adresse de la projection (écriture : agrandirProjection) */
+    fichierOuvert* fichiersOuverts; /**< Les fichiers ouverts de la partition */
+    unsigned long generation; /**< Identifie le montage (les compteurs mémorisés par un thread pour une autre partition sont ignorés) */
+    statsThread* statsThreads; /**< Les compteurs d'instrumentation de chaque thread ayant utilisé la partition */
+    statsES statsBase; /**< Les compteurs à la dernière remise à zéro (myResetStats) */
+    histogrammeLatences histogrammesBase[NB_OPERATIONS_TRACEES]; /**< Les histogrammes à la dernière remise à zéro */
+    traceLatences trace; /**< Le chronométrage des opérations */
+    pthread_mutex_t verrouStats; /**< Protège statsThreads et statsBase */
+}partition;
 
 
 /*********************************************************************
@@ -101,15 +693,76 @@ typedef struct blocIndex{
 
 /**************************************HELPERS****************************************/
 
-blocData alloc_bloc(); //INITIALISER UN BLOC VIDE
-blocIndex init_blocIndex();
-int estPleinBlocData(blocData* bloc);
+//ENTREES / SORTIES
+ssize_t lireStockage(partition* p, void* buffer, size_t taille, off_t offset);
+ssize_t ecrireStockage(partition* p, const void* buffer, size_t taille, off_t offset);
+ssize_t lirePartition(partition* p, void* buffer, size_t taille, off_t offset);
+ssize_t ecrirePartition(partition* p, const void* buffer, size_t taille, off_t offset);
+void* adressePartition(partition* p, off_t offset, size_t taille);
+ssize_t copierStockage(partition* p, off_t source, off_t destination, size_t taille);
+
+//CACHE DE BLOCS
+int configurerCache(partition* p, size_t budget);
+int viderCache(partition* p);
+statsCache getStatsCache(partition* p);
+void conseillerPartition(partition* p, off_t offset, size_t taille);
+int prechargerPartition(partition* p, off_t offset, size_t taille);
+
+//MOTEUR D'ENTREES / SORTIES ASYNCHRONES
+int configurerMoteur(partition* p, int type);
+int attendreEcritures(partition* p, off_t offset, size_t taille);
+
+//JOURNAL DES METADONNEES
+int rejouerJournal(partition* p);
+int initialiserJournal(partition* p);
+int fermerJournal(partition* p);
+int configurerJournal(partition* p, size_t seuil, int delai);
+ssize_t ecrireMetadonnees(partition* p, const void* buffer, size_t taille, off_t offset);
+void recouvrirJournal(partition* p, void* buffer, size_t taille, off_t offset);
+void revoquerJournal(partition* p, off_t debut, off_t nbUnites);
+int differerLiberation(partition* p, off_t debut, off_t nbUnites);
+int validerJournal(partition* p);
+int finOperationJournal(partition* p);
+
+blocData* alloc_bloc(partition* p); //INITIALISER UN BLOC VIDE
+off_t allouerEspace(partition* p, size_t taille);
+off_t allouerEspaceProche(partition* p, size_t taille, off_t offsetSouhaite);
+void libererEspace(partition* p, off_t offset, size_t taille);
+int partagerEspace(partition* p, off_t offset, size_t taille);
+bool estBlocPartage(partition* p, off_t offset);
+int lireBlocData(partition* p, off_t offset, blocData* bloc);
+int ecrireBlocData(partition* p, off_t offset, blocData* bloc);
+int estPleinBlocData(partition* p, blocData* bloc);
 int trouverBlocData(int positionActuelle, int nbCharMaxParBloc);
 int trouverPosition(int positionActuelle, int nbCharMaxParBloc);
 off_t trouveOffsetBlocFile(file* f, int blocNumber);
 int rechercheDichotomique(elemTabIndex* tableau, int taille, char* nomFichier);
 int insertionTableauTrie(elemTabIndex* tableau, int taille, elemTabIndex element);
 int getPosLastCharFile(file* f);
+int rechercheExtent(extent* tableau, int taille, int blocNumber);
+int ajouterExtentFile(file* f, int numBloc, off_t offsetBloc);
+int chargerTableBlocs(file* f);
+int ajouterTableBlocs(file* f, off_t offsetBloc);
+int reecrireExtents(file* f, off_t* blocs, int nbBlocs);
+
+//ESPACE LIBRE
+int chargerBitmap(partition* p);
+int reconstruireBitmap(partition* p);
+int enregistrerBitmap(partition* p);
+int libererFichier(partition* p, off_t offsetEntete);
+off_t clonerEntete(partition* p, off_t offsetEntete, char* nomFichier);
+
+//REPERTOIRE (ARBRE B+)
+partition* chargerPartition(int fd);
+int lireNoeud(partition* p, off_t offset, noeudRepertoire* noeud);
+int ecrireNoeud(partition* p, off_t offset, noeudRepertoire* noeud);
+off_t allouerNoeud(partition* p, noeudRepertoire* noeud);
+int indiceFils(noeudRepertoire* noeud, char* nomFichier);
+off_t rechercheRepertoire(partition* p, char* nomFichier);
+int insererRepertoire(partition* p, elemTabIndex element);
+int supprimerRepertoire(partition* p, char* nomFichier);
+int parcourirRepertoire(partition* p, int (*traitement)(elemTabIndex* element, void* arg), void* arg);
+int flushIndex(partition* p);
 
 //MANIPULATION D'ENTETE
 //////getters
@@ -131,14 +784,22 @@ int getSizeReelFile(file* f); //en terme de données (nombre de caracteres)
 /*                          FONCTIONS PRINCIPALES                                              */
 /***********************************************************************************************/
 //myFormat
-int myFormat(char* partitionName);
+int myFormat(char* partitionName, int tailleBloc);
+
+//myMount / myUnmount
+partition* myMount(char* partitionName, int backend);
+int myUnmount(partition* p);
+int mySync(partition* p);
 
 //myOpen
-file* myOpen(char* fileName);
+file* myOpen(partition* p, char* fileName);
 
 //myWrite
 int myWrite(file* f, void* buffer, int size);
 
+//myFlush
+int myFlush(file* f);
+
 //MyRead
 int myRead(file *f,void * buffer, int nBytes);
 
@@ -148,6 +809,44 @@ void mySeek(file* f, int offset, int base);
 //MyClose
 void myClose(file* f);
 
+//myReadv / myWritev
+int myReadv(file* f, const struct iovec* iov, int iovcnt);
+int myWritev(file* f, const struct iovec* iov, int iovcnt);
+
+//myReadAsync / myWriteAsync
+int myReadAsync(file* f, void* buffer, int nBytes);
+int myWriteAsync(file* f, void* buffer, int size);
+int myWait(partition* p, int jeton);
+int myPoll(partition* p, int jeton);
+
+//myCopy / myClone
+int myCopy(partition* p, char* source, char* destination);
+int myClone(partition* p, char* source, char* destination);
+
+//mySnapshot / myOpenSnapshot / myDropSnapshot
+int mySnapshot(partition* p, char* nom);
+file* myOpenSnapshot(partition* p, char* nom, char* fileName);
+int myDropSnapshot(partition* p, char* nom);
+
+//myDelete / myTruncate
+int myDelete(partition* p, char* fileName);
+int myTruncate(file* f, int taille);
+
+//myDefrag
+int myDefrag(partition* p, char* fileName, fragmentation* avant, fragmentation* apres);
+
+//myStats / myResetStats
+statsES myStats(partition* p);
+void myResetStats(partition* p);
+statsES myStatsFile(file* f);
+void myResetStatsFile(file* f);
+
+//chronométrage des opérations
+int configurerTrace(partition* p, bool actif, int nbLentes);
+histogrammeLatences getHistogramme(partition* p, int operation);
+long percentileLatence(histogrammeLatences* h, double centile);
+int exporterTrace(partition* p, char* chemin, int format);
+
 //closePartition
-int closePartition(int fd);
+int closePartition(partition* p);
 #endif // BIBLIO_PROJET_OS_H_INCLUDED
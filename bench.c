@@ -0,0 +1,399 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "BIBLIO_PROJET_OS.h"
+
+/**
+ * @file bench.c
+ * @brief Banc d'essai de l'API de la bibliothèque (cible `make bench`).
+ *
+ * Pour chaque taille de bloc et chaque taille de fichier, le programme mesure myFormat, myOpen
+ * (fichier existant et création), myWrite / myRead séquentiels et aléatoires, mySeek(SEEK_END) et
+ * getSizeReelFile. Les résultats (opérations par seconde, Mo/s, percentiles de latence et appels
+ * système par opération) sont écrits en JSON afin de pouvoir comparer deux versions.
+ * Chaque série d'écritures est rapportée deux fois : jusqu'au cache de blocs (myFlush final) et
+ * jusqu'au support (suffixe _durable : mySync final en plus).
+ *
+ * Usage : benchmark [-m] <partition> <resultats.json>
+ * (-m : partition montée en BACKEND_MMAP au lieu de BACKEND_RW). La partition est recréée à chaque
+ * configuration puis supprimée.
+ */
+
+/*********************************************************************
+ |       		PARAMETRES DU BANC D'ESSAI		|
+ ********************************************************************/
+
+#define TAILLE_OPERATION 4096 //octets transférés par appel de myWrite / myRead
+#define NB_FORMATAGES 8 //répétitions de myFormat par taille de bloc
+#define NB_OUVERTURES 512 //répétitions de myOpen (existant et création)
+#define NB_REQUETES 4096 //répétitions de mySeek(SEEK_END) et getSizeReelFile
+#define GRAINE_ALEATOIRE 12345u //graine des positions aléatoires (résultats reproductibles)
+
+static const int taillesBloc[] = {512, 4096, 65536};
+static const int taillesFichier[] = {64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+#define NB_TAILLES(t) ((int)(sizeof(t) / sizeof((t)[0])))
+
+/******************mesure helpers*****************/
+
+/**
+ * @brief Une série de mesures d'une opération.
+ */
+typedef struct mesure{
+    long* latences; /**< Latence de chaque opération (ns) */
+    int nbOps; /**< Nombre d'opérations mesurées */
+    long dureeHors; /**< Temps (ns) passé hors des opérations mais imputé à la série (myFlush final) */
+    long octets; /**< Octets transférés (0 si l'opération ne transfère pas de données) */
+    long appelsSysteme; /**< Appels système de lecture / écriture pendant la série, -1 si inconnu */
+}mesure;
+
+static long surcoutComptage = 0; //appels système dus à la lecture de /proc/self/io elle-même
+
+static long maintenant(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long)t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+/**
+ * @brief Compte les appels système de lecture et d'écriture du processus (syscr + syscw).
+ *
+ * pread / pwrite, copy_file_range et io_uring_enter sont comptés par le noyau dans /proc/self/io.
+ * La lecture de ce fichier est elle-même comptée : terminerMesure en retire le coût (surcoutComptage).
+ *
+ * @return Le nombre d'appels, -1 si /proc/self/io est indisponible.
+ */
+static long compterAppelsSysteme(void) {
+    FILE* io = fopen("/proc/self/io", "r");
+    if (io == NULL) return -1;
+    char ligne[128];
+    long total = 0, valeur;
+    int trouves = 0;
+    while (fgets(ligne, sizeof(ligne), io) != NULL) {
+        if (sscanf(ligne, "syscr: %ld", &valeur) == 1 || sscanf(ligne, "syscw: %ld", &valeur) == 1) {
+            total += valeur;
+            trouves++;
+        }
+    }
+    fclose(io);
+    return trouves == 2 ? total : -1;
+}
+
+static int initialiserMesure(mesure* m, int nbOps) {
+    m->latences = malloc(nbOps * sizeof(long));
+    m->nbOps = 0;
+    m->dureeHors = 0;
+    m->octets = 0;
+    m->appelsSysteme = compterAppelsSysteme();
+    return m->latences == NULL ? ERROR_OTHER : 0;
+}
+
+static void terminerMesure(mesure* m) {
+    long apres = compterAppelsSysteme();
+    if (m->appelsSysteme < 0 || apres < 0)
+        m->appelsSysteme = -1;
+    else
+        m->appelsSysteme = apres - m->appelsSysteme > surcoutComptage ? apres - m->appelsSysteme - surcoutComptage : 0;
+}
+
+static int comparerLatences(const void* a, const void* b) {
+    long x = *(const long*)a, y = *(const long*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Prolonge une série d'écritures jusqu'au support : durable reçoit ses mesures plus le coût d'un mySync.
+ */
+static int mesurerSynchronisation(partition* p, mesure* m, mesure* durable) {
+    *durable = *m;
+    durable->latences = malloc(m->nbOps * sizeof(long));
+    if (durable->latences == NULL) return ERROR_OTHER;
+    memcpy(durable->latences, m->latences, m->nbOps * sizeof(long));
+
+    long appels = compterAppelsSysteme();
+    long debut = maintenant();
+    if (mySync(p) < 0) {
+        free(durable->latences);
+        return ERROR_WRITE;
+    }
+    durable->dureeHors += maintenant() - debut;
+    long apres = compterAppelsSysteme();
+    if (durable->appelsSysteme < 0 || appels < 0 || apres < 0)
+        durable->appelsSysteme = -1;
+    else if (apres - appels > surcoutComptage)
+        durable->appelsSysteme += apres - appels - surcoutComptage;
+    return 0;
+}
+
+static long percentile(mesure* m, int centiemes) {
+    if (m->nbOps == 0) return 0;
+    int rang = (int)((long)centiemes * (m->nbOps - 1) / 100);
+    return m->latences[rang];
+}
+
+/******************json helpers*****************/
+
+static int premierResultat = 1;
+
+/**
+ * @brief Ecrit une série de mesures comme un élément du tableau JSON "resultats" puis la libère.
+ *
+ * @param sortie Le fichier JSON.
+ * @param operation Le nom de l'opération mesurée.
+ * @param tailleBloc La taille des blocs de la partition.
+ * @param tailleFichier La taille du fichier utilisé (0 si sans objet).
+ * @param m La série de mesures.
+ */
+static void ecrireResultat(FILE* sortie, const char* operation, int tailleBloc, int tailleFichier, mesure* m) {
+    long duree = m->dureeHors;
+    for (int i = 0; i < m->nbOps; i++) duree += m->latences[i];
+    qsort(m->latences, m->nbOps, sizeof(long), comparerLatences);
+    double secondes = duree / 1e9;
+
+    fprintf(sortie, "%s    {\"operation\": \"%s\", \"taille_bloc\": %d, \"taille_fichier\": %d, \"nb_blocs\": %d,"
+            " \"ops\": %d, \"duree_s\": %.6f, \"ops_par_s\": %.1f, ",
+            premierResultat ? "" : ",\n", operation, tailleBloc, tailleFichier, tailleFichier / tailleBloc,
+            m->nbOps, secondes, secondes > 0 ? m->nbOps / secondes : 0.0);
+    if (m->octets > 0)
+        fprintf(sortie, "\"mo_par_s\": %.2f, ", secondes > 0 ? m->octets / secondes / (1024.0 * 1024.0) : 0.0);
+    else
+        fprintf(sortie, "\"mo_par_s\": null, ");
+    fprintf(sortie, "\"latence_ns\": {\"p50\": %ld, \"p90\": %ld, \"p99\": %ld, \"max\": %ld}, ",
+            percentile(m, 50), percentile(m, 90), percentile(m, 99), m->nbOps > 0 ? m->latences[m->nbOps - 1] : 0);
+    if (m->appelsSysteme >= 0 && m->nbOps > 0)
+        fprintf(sortie, "\"appels_systeme_par_op\": %.3f}", (double)m->appelsSysteme / m->nbOps);
+    else
+        fprintf(sortie, "\"appels_systeme_par_op\": null}");
+    premierResultat = 0;
+    free(m->latences);
+}
+
+/******************scenario helpers*****************/
+
+static unsigned etatAleatoire;
+
+static unsigned aleatoire(void) {
+    etatAleatoire = etatAleatoire * 1103515245u + 12345u;
+    return etatAleatoire >> 8;
+}
+
+/**
+ * @brief Mesure myFormat sur une partition neuve (la partition existante est supprimée avant chaque appel).
+ */
+static int mesurerFormatage(FILE* sortie, char* nomPartition, int tailleBloc) {
+    mesure m;
+    if (initialiserMesure(&m, NB_FORMATAGES) < 0) return ERROR_OTHER;
+    for (int i = 0; i < NB_FORMATAGES; i++) {
+        unlink(nomPartition);
+        long debut = maintenant();
+        if (myFormat(nomPartition, tailleBloc) < 0) {
+            free(m.latences);
+            return ERROR_OTHER;
+        }
+        m.latences[m.nbOps++] = maintenant() - debut;
+    }
+    terminerMesure(&m);
+    ecrireResultat(sortie, "myFormat", tailleBloc, 0, &m);
+    return 0;
+}
+
+/**
+ * @brief Mesure myOpen sur des fichiers à créer puis sur un fichier existant (chaque ouverture est refermée).
+ */
+static int mesurerOuvertures(FILE* sortie, partition* p, int tailleBloc) {
+    char nom[MAX_LEN_NAME];
+    mesure creation, existant;
+
+    if (initialiserMesure(&creation, NB_OUVERTURES) < 0) return ERROR_OTHER;
+    for (int i = 0; i < NB_OUVERTURES; i++) {
+        snprintf(nom, sizeof(nom), "ouverture_%d", i);
+        long debut = maintenant();
+        file* f = myOpen(p, nom);
+        creation.latences[creation.nbOps++] = maintenant() - debut;
+        if (f == NULL) {
+            free(creation.latences);
+            return ERROR_OPEN;
+        }
+        myClose(f);
+    }
+    terminerMesure(&creation);
+    ecrireResultat(sortie, "myOpen_creation", tailleBloc, 0, &creation);
+
+    if (initialiserMesure(&existant, NB_OUVERTURES) < 0) return ERROR_OTHER;
+    for (int i = 0; i < NB_OUVERTURES; i++) {
+        snprintf(nom, sizeof(nom), "ouverture_%d", (int)(aleatoire() % NB_OUVERTURES));
+        long debut = maintenant();
+        file* f = myOpen(p, nom);
+        existant.latences[existant.nbOps++] = maintenant() - debut;
+        if (f == NULL) {
+            free(existant.latences);
+            return ERROR_OPEN;
+        }
+        myClose(f);
+    }
+    terminerMesure(&existant);
+    ecrireResultat(sortie, "myOpen_existant", tailleBloc, 0, &existant);
+    return 0;
+}
+
+/**
+ * @brief Mesure des écritures ou des lectures de TAILLE_OPERATION octets sur tout un fichier.
+ *
+ * En mode séquentiel le fichier est parcouru du début à la fin ; en mode aléatoire chaque opération
+ * commence à une position alignée tirée au hasard. Le myFlush final d'une série d'écritures est
+ * imputé à la série ; le mySync qui la rend durable l'est à la série _durable (voir mesurerSynchronisation).
+ *
+ * @param ecriture 1 pour myWrite, 0 pour myRead.
+ * @param sequentiel 1 pour un parcours séquentiel, 0 pour des positions aléatoires.
+ */
+static int mesurerTransferts(FILE* sortie, file* f, char* buffer, int tailleBloc, int tailleFichier,
+                             int ecriture, int sequentiel) {
+    int nbOps = tailleFichier / TAILLE_OPERATION;
+    mesure m, durable;
+    char operation[64];
+
+    snprintf(operation, sizeof(operation), "%s_%s", ecriture ? "myWrite" : "myRead",
+             sequentiel ? "sequentiel" : "aleatoire");
+    if (initialiserMesure(&m, nbOps) < 0) return ERROR_OTHER;
+    mySeek(f, 0, SEEK_SET);
+    for (int i = 0; i < nbOps; i++) {
+        long debut = maintenant();
+        if (!sequentiel) mySeek(f, (int)(aleatoire() % nbOps) * TAILLE_OPERATION, SEEK_SET);
+        int n = ecriture ? myWrite(f, buffer, TAILLE_OPERATION) : myRead(f, buffer, TAILLE_OPERATION);
+        m.latences[m.nbOps++] = maintenant() - debut;
+        if (n != TAILLE_OPERATION) {
+            free(m.latences);
+            return ecriture ? ERROR_WRITE : ERROR_READ;
+        }
+        m.octets += n;
+    }
+    if (ecriture) {
+        long debut = maintenant();
+        if (myFlush(f) < 0) {
+            free(m.latences);
+            return ERROR_WRITE;
+        }
+        m.dureeHors = maintenant() - debut;
+    }
+    terminerMesure(&m);
+    if (ecriture && mesurerSynchronisation(f->part, &m, &durable) < 0) {
+        free(m.latences);
+        return ERROR_WRITE;
+    }
+    ecrireResultat(sortie, operation, tailleBloc, tailleFichier, &m);
+    if (ecriture) {
+        strcat(operation, "_durable");
+        ecrireResultat(sortie, operation, tailleBloc, tailleFichier, &durable);
+    }
+    return 0;
+}
+
+/**
+ * @brief Mesure mySeek(SEEK_END) et getSizeReelFile sur un fichier rempli.
+ */
+static int mesurerRequetes(FILE* sortie, file* f, int tailleBloc, int tailleFichier) {
+    mesure fin, taille;
+
+    if (initialiserMesure(&fin, NB_REQUETES) < 0) return ERROR_OTHER;
+    for (int i = 0; i < NB_REQUETES; i++) {
+        mySeek(f, 0, SEEK_SET);
+        long debut = maintenant();
+        mySeek(f, 0, SEEK_END);
+        fin.latences[fin.nbOps++] = maintenant() - debut;
+    }
+    terminerMesure(&fin);
+    ecrireResultat(sortie, "mySeek_SEEK_END", tailleBloc, tailleFichier, &fin);
+
+    if (initialiserMesure(&taille, NB_REQUETES) < 0) return ERROR_OTHER;
+    for (int i = 0; i < NB_REQUETES; i++) {
+        long debut = maintenant();
+        int n = getSizeReelFile(f);
+        taille.latences[taille.nbOps++] = maintenant() - debut;
+        if (n != tailleFichier) {
+            fprintf(stderr, "getSizeReelFile : %d octets au lieu de %d.\n", n, tailleFichier);
+            free(taille.latences);
+            return ERROR_READ;
+        }
+    }
+    terminerMesure(&taille);
+    ecrireResultat(sortie, "getSizeReelFile", tailleBloc, tailleFichier, &taille);
+    return 0;
+}
+
+/**
+ * @brief Exécute toutes les mesures d'une taille de bloc sur une partition neuve.
+ */
+static int mesurerTailleBloc(FILE* sortie, char* nomPartition, int backend, int tailleBloc, char* buffer) {
+    if (mesurerFormatage(sortie, nomPartition, tailleBloc) < 0) return ERROR_OTHER;
+    partition* p = myMount(nomPartition, backend);
+    if (p == NULL) return ERROR_OPEN;
+
+    int ret = mesurerOuvertures(sortie, p, tailleBloc);
+    for (int i = 0; i < NB_TAILLES(taillesFichier) && ret == 0; i++) {
+        char nom[MAX_LEN_NAME];
+        snprintf(nom, sizeof(nom), "fichier_%d", taillesFichier[i]);
+        file* f = myOpen(p, nom);
+        if (f == NULL) {
+            ret = ERROR_OPEN;
+            break;
+        }
+        //l'écriture séquentielle remplit le fichier, les mesures suivantes le réutilisent
+        ret = mesurerTransferts(sortie, f, buffer, tailleBloc, taillesFichier[i], 1, 1);
+        if (ret == 0) ret = mesurerTransferts(sortie, f, buffer, tailleBloc, taillesFichier[i], 0, 1);
+        if (ret == 0) ret = mesurerTransferts(sortie, f, buffer, tailleBloc, taillesFichier[i], 1, 0);
+        if (ret == 0) ret = mesurerTransferts(sortie, f, buffer, tailleBloc, taillesFichier[i], 0, 0);
+        if (ret == 0) ret = mesurerRequetes(sortie, f, tailleBloc, taillesFichier[i]);
+        myClose(f);
+    }
+    if (myUnmount(p) < 0 && ret == 0) ret = ERROR_WRITE;
+    unlink(nomPartition);
+    return ret;
+}
+
+/*******************************************************************/
+
+int main(int argc, char* argv[])
+{
+    int backend = BACKEND_RW;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-m") == 0) {
+        backend = BACKEND_MMAP;
+        arg++;
+    }
+    if (argc - arg != 2) {
+        fprintf(stderr, "Usage : %s [-m] <partition> <resultats.json>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    char* nomPartition = argv[arg];
+    FILE* sortie = fopen(argv[arg + 1], "w");
+    if (sortie == NULL) {
+        perror("Erreur d'ouverture du fichier de résultats");
+        return EXIT_FAILURE;
+    }
+    char* buffer = malloc(TAILLE_OPERATION);
+    if (buffer == NULL) {
+        fclose(sortie);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < TAILLE_OPERATION; i++) buffer[i] = 'a' + i % 26;
+    etatAleatoire = GRAINE_ALEATOIRE;
+    long avant = compterAppelsSysteme();
+    if (avant >= 0) surcoutComptage = compterAppelsSysteme() - avant;
+
+    fprintf(sortie, "{\n  \"version_partition\": %d,\n  \"backend\": \"%s\",\n  \"taille_operation\": %d,\n"
+            "  \"resultats\": [\n", VERSION_PARTITION, backend == BACKEND_MMAP ? "mmap" : "rw", TAILLE_OPERATION);
+    int ret = 0;
+    for (int i = 0; i < NB_TAILLES(taillesBloc) && ret == 0; i++) {
+        fprintf(stderr, "Taille de bloc %d...\n", taillesBloc[i]);
+        ret = mesurerTailleBloc(sortie, nomPartition, backend, taillesBloc[i], buffer);
+    }
+    fprintf(sortie, "\n  ]\n}\n");
+    fclose(sortie);
+    free(buffer);
+    if (ret < 0) {
+        fprintf(stderr, "Erreur pendant le banc d'essai (%d).\n", ret);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "BIBLIO_PROJET_OS.h"
+
+/**
+ * @file defrag.c
+ * @brief Défragmenteur hors ligne d'une partition (cible `make defrag`).
+ *
+ * La partition est montée seule : aucun autre programme ne doit l'utiliser. La table des unités
+ * libres est d'abord reconstruite à partir du répertoire, ce qui rend l'espace perdu (unités
+ * occupées qu'aucun fichier ne référence) ; chaque fichier du répertoire est ensuite recopié en une
+ * seule suite de blocs contigus, au plus près du début de la partition (voir myDefrag). Au
+ * démontage, l'espace libre de fin de partition est retiré.
+ *
+ * Pour chaque fichier, la fragmentation avant et après (blocs, fragments, extents, étendue) est
+ * affichée, puis un résumé pour la partition.
+ *
+ * Usage : defrag [-m] <partition>
+ * (-m : partition montée en BACKEND_MMAP au lieu de BACKEND_RW).
+ */
+
+#define NB_PASSES_MAX 4 //passes de compactage au plus (la première défragmente, les suivantes rapprochent du début)
+
+/**
+ * @brief Un fichier du répertoire et sa fragmentation, relevés avant toute défragmentation.
+ */
+typedef struct fichierDefrag{
+    char nom[MAX_LEN_NAME]; /**< Le nom du fichier */
+    fragmentation avant; /**< La fragmentation avant la première passe */
+    fragmentation apres; /**< La fragmentation après la dernière passe qui l'a traité */
+    bool erreur; /**< Vrai si le fichier n'a pas pu être défragmenté */
+}fichierDefrag;
+
+/**
+ * @brief La liste des fichiers du répertoire.
+ */
+typedef struct listeFichiers{
+    fichierDefrag* fichiers; /**< Les fichiers, dans l'ordre du répertoire */
+    int nb; /**< Le nombre de fichiers */
+    int capacite; /**< Le nombre de fichiers alloués */
+}listeFichiers;
+
+/**
+ * @brief Ajoute un fichier du répertoire à la liste (voir parcourirRepertoire).
+ */
+static int releverFichier(elemTabIndex* element, void* arg) {
+    listeFichiers* l = arg;
+    if (l->nb == l->capacite) {
+        int capacite = l->capacite > 0 ? 2 * l->capacite : 64;
+        fichierDefrag* fichiers = realloc(l->fichiers, capacite * sizeof(fichierDefrag));
+        if (fichiers == NULL)
+            return ERROR_OTHER;
+        l->fichiers = fichiers;
+        l->capacite = capacite;
+    }
+    fichierDefrag* fd = &l->fichiers[l->nb++];
+    memset(fd, 0, sizeof(fichierDefrag));
+    strcpy(fd->nom, element->nomFichier);
+    return 0;
+}
+
+/**
+ * @brief Ordonne deux fichiers selon la position de leurs blocs dans la partition (voir qsort).
+ */
+static int comparerPosition(const void* a, const void* b) {
+    off_t da = (*(fichierDefrag* const*)a)->apres.debut;
+    off_t db = (*(fichierDefrag* const*)b)->apres.debut;
+    return (da > db) - (da < db);
+}
+
+/**
+ * @brief Affiche une ligne de mesures : avant -> après (debut est un numéro de bloc de la partition, -1 pour un fichier vide).
+ */
+static void afficherMesures(fichierDefrag* fd, int tailleBloc) {
+    fragmentation* avant = &fd->avant;
+    fragmentation* apres = &fd->apres;
+    long debutAvant = avant->debut < 0 ? -1 : (long)(avant->debut / tailleBloc);
+    long debutApres = apres->debut < 0 ? -1 : (long)(apres->debut / tailleBloc);
+    printf("%-24s %8d | %6d %6d %8ld %10ld -> %6d %6d %8ld %10ld%s\n", fd->nom, avant->nbBlocs,
+           avant->nbFragments, avant->nbExtents, (long)avant->etendue, debutAvant,
+           apres->nbFragments, apres->nbExtents, (long)apres->etendue, debutApres,
+           fd->erreur ? "  (erreur)" : avant->partage ? "  (partagé, non déplacé)" : "");
+}
+
+/**
+ * @brief Défragmente les fichiers de la liste, dans l'ordre donné.
+ *
+ * @return Le nombre de fichiers déplacés.
+ */
+static int passeDefrag(partition* p, fichierDefrag** ordre, int nb, bool premiere) {
+    int nbDeplaces = 0;
+    for (int i = 0; i < nb; i++) {
+        fichierDefrag* fd = ordre[i];
+        fragmentation avant, apres;
+        if (fd->erreur)
+            continue;
+        if (myDefrag(p, fd->nom, &avant, &apres) < 0) {
+            fprintf(stderr, "Erreur de défragmentation du fichier %s\n", fd->nom);
+            fd->erreur = true;
+            continue;
+        }
+        if (premiere) fd->avant = avant;
+        fd->apres = apres;
+        if (apres.debut != avant.debut) nbDeplaces++;
+    }
+    return nbDeplaces;
+}
+
+int main(int argc, char* argv[])
+{
+    int backend = BACKEND_RW;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-m") == 0) {
+        backend = BACKEND_MMAP;
+        arg++;
+    }
+    if (argc - arg != 1) {
+        fprintf(stderr, "Usage : %s [-m] <partition>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct stat st;
+    if (stat(argv[arg], &st) == -1) {
+        perror("Erreur d'accès à la partition");
+        return EXIT_FAILURE;
+    }
+    off_t tailleAvant = st.st_size;
+    partition* p = myMount(argv[arg], backend);
+    if (p == NULL) {
+        fprintf(stderr, "Impossible de monter la partition %s\n", argv[arg]);
+        return EXIT_FAILURE;
+    }
+    int tailleBloc = p->sb.tailleBloc;
+
+    //rendre l'espace perdu avant de placer les fichiers (les zones des tables enregistrées sont aussi rendues : elles seront réécrites)
+    off_t unitesTables = 0;
+    if (p->sb.bitmap != -1) unitesTables += (p->sb.tailleBitmap + tailleBloc - 1) / tailleBloc;
+    if (p->sb.partages != -1) unitesTables += (p->sb.taillePartages + tailleBloc - 1) / tailleBloc;
+    off_t libresAvant = p->nbUnitesLibres;
+    if (reconstruireBitmap(p) < 0) {
+        fprintf(stderr, "Erreur de reconstruction de la table des unités libres\n");
+        myUnmount(p);
+        return EXIT_FAILURE;
+    }
+    off_t unitesPerdues = p->nbUnitesLibres - libresAvant - unitesTables;
+
+    listeFichiers liste = {NULL, 0, 0};
+    fichierDefrag** ordre = NULL;
+    if (parcourirRepertoire(p, releverFichier, &liste) < 0 ||
+        (liste.nb > 0 && (ordre = malloc(liste.nb * sizeof(fichierDefrag*))) == NULL)) {
+        fprintf(stderr, "Erreur de lecture du répertoire\n");
+        free(liste.fichiers);
+        myUnmount(p);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < liste.nb; i++)
+        ordre[i] = &liste.fichiers[i];
+
+    //première passe dans l'ordre du répertoire : chaque fichier devient contigu (à la fin de la partition
+    //s'il n'y a pas de place avant) ; les passes suivantes, dans l'ordre des positions, ramènent les
+    //fichiers dans l'espace libéré au début
+    int nbDeplaces = passeDefrag(p, ordre, liste.nb, true);
+    int nbPasses = 1;
+    for (int deplaces = nbDeplaces; deplaces > 0 && nbPasses < NB_PASSES_MAX; nbPasses++) {
+        qsort(ordre, liste.nb, sizeof(fichierDefrag*), comparerPosition);
+        deplaces = passeDefrag(p, ordre, liste.nb, false);
+        nbDeplaces += deplaces;
+    }
+
+    printf("%-24s %8s | %6s %6s %8s %10s -> %6s %6s %8s %10s\n", "fichier", "blocs",
+           "frag.", "ext.", "etendue", "debut", "frag.", "ext.", "etendue", "debut");
+    int ret = EXIT_SUCCESS;
+    long fragmentsAvant = 0, fragmentsApres = 0;
+    for (int i = 0; i < liste.nb; i++) {
+        fichierDefrag* fd = &liste.fichiers[i];
+        afficherMesures(fd, tailleBloc);
+        fragmentsAvant += fd->avant.nbFragments;
+        fragmentsApres += fd->apres.nbFragments;
+        if (fd->erreur) ret = EXIT_FAILURE;
+    }
+    int nbFichiers = liste.nb;
+    free(ordre);
+    free(liste.fichiers);
+
+    if (myUnmount(p) < 0) {
+        fprintf(stderr, "Erreur de démontage de la partition\n");
+        return EXIT_FAILURE;
+    }
+    //le démontage a ramené la partition à la fin de son dernier espace occupé
+    off_t tailleApres = stat(argv[arg], &st) == 0 ? st.st_size : -1;
+
+    printf("\n%d fichier(s), %d déplacement(s) en %d passe(s), fragments : %ld -> %ld\n",
+           nbFichiers, nbDeplaces, nbPasses, fragmentsAvant, fragmentsApres);
+    printf("espace perdu rendu : %ld bloc(s)\n", (long)unitesPerdues);
+    printf("taille de la partition : %ld -> %ld octets\n", (long)tailleAvant, (long)tailleApres);
+    return ret;
+}
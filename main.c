@@ -2,15 +2,497 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "BIBLIO_PROJET_OS.h"
 
+//affiche les compteurs d'instrumentation d'une partition ou d'un descripteur (voir myStats)
+static void afficherStats(const char* titre, statsES s) {
+    printf("%s :\n", titre);
+    printf("* Appels système : %ld lectures, %ld écritures, %ld copies, %ld synchronisations, %ld soumissions io_uring, %ld autres\n",
+           s.lectures, s.ecritures, s.copies, s.synchronisations, s.soumissions, s.autresAppels);
+    printf("* Octets sur le support : %ld lus, %ld écrits, %ld copiés\n", s.octetsLus, s.octetsEcrits, s.octetsCopies);
+    printf("* Octets des fichiers : %ld lus, %ld écrits\n", s.octetsLusFichiers, s.octetsEcritsFichiers);
+    printf("* Entêtes lus : %ld, sauts de chaîne : %ld\n", s.lecturesEntete, s.sautsChaine);
+    printf("* Blocs alloués : %ld, libérés : %ld, références de blocs partagés retirées : %ld\n",
+           s.blocsAlloues, s.blocsLiberes, s.referencesRetirees);
+    printf("* Noeuds du répertoire : %ld lectures, %ld écritures\n", s.lecturesIndex, s.ecrituresIndex);
+    printf("* Cache de blocs : %ld succès, %ld échecs\n", s.succesCache, s.echecsCache);
+}
+
+//affiche les percentiles de latence des opérations chronométrées (voir configurerTrace)
+static void afficherLatences(partition* part) {
+    const char* noms[NB_OPERATIONS_TRACEES] = {"myOpen", "myRead", "myWrite", "mySeek"};
+    for (int op = 0; op < NB_OPERATIONS_TRACEES; op++) {
+        histogrammeLatences h = getHistogramme(part, op);
+        if (h.nb == 0) continue;
+        printf("* %-8s %ld opérations, latences (ns) : moyenne %ld, p50 %ld, p90 %ld, p99 %ld, p99.9 %ld, max %ld\n",
+               noms[op], h.nb, h.total / h.nb, percentileLatence(&h, 50), percentileLatence(&h, 90),
+               percentileLatence(&h, 99), percentileLatence(&h, 99.9), h.max);
+    }
+}
+
+/*********************************************************************
+ |       		MODE NON INTERACTIF (REJEU D'UN SCRIPT)		|
+ ********************************************************************/
+
+/*
+ * Format du script (une commande par ligne, '#' commence un commentaire) :
+ *   format <partition> [tailleBloc]     formate puis monte la partition
+ *   mount <partition> [rw|mmap]         monte une partition existante
+ *   open <fichier> / close <fichier>    ouvre (ou crée) / ferme un fichier
+ *   write <fichier> <octets> [motif]    écrit <octets> octets à la position courante
+ *   read <fichier> <octets>             lit au plus <octets> octets
+ *   seek <fichier> <deplacement> <base> base : 0|SET, 1|CUR, 2|END
+ *   flush <fichier>, truncate <fichier> <taille>, delete <fichier>
+ *   copy|clone <source> <destination>, snapshot <nom>, sync
+ *   stats [fichier]                     affiche puis remet à zéro les compteurs de la partition (ou du fichier)
+ *   trace <nbLentes>|off                chronomètre les opérations en gardant les nbLentes plus lentes
+ *   export <fichier> [texte|chrome]     écrit les opérations les plus lentes (voir exporterTrace)
+ *   defrag <fichier>                    recopie les blocs du fichier en une suite contiguë (voir myDefrag)
+ *   expect <fichier> <octets> [motif]   lit exactement <octets> octets, qui doivent suivre le motif
+ *   size <fichier> <taille>             la taille logique du fichier doit valoir <taille>
+ *   awrite|aread <fichier> <octets> [motif]  écriture / lecture asynchrone, vérifiée par wait
+ *   wait                                attend les opérations asynchrones du script
+ *   engine aucun|uring|threads          choisit le moteur d'entrées / sorties asynchrones
+ *   journal <seuil> <delai>             règle la validation du journal (voir configurerJournal)
+ *   opensnapshot <nom> <fichier>        ouvre un fichier d'instantané, désigné ensuite par <nom>:<fichier>
+ *   dropsnapshot <nom>, pause <ms>
+ *   crash                               arrête le processus sans démonter (simule un arrêt brutal)
+ *
+ * Le motif est un caractère (nul pour '\0') ; sans motif, l'octet i d'une écriture vaut 'a' + i % 26.
+ * Une commande précédée de '!' (par exemple !open) doit échouer : sa réussite est comptée comme une erreur.
+ */
+
+#define MAX_FICHIERS_SCRIPT 64 //descripteurs ouverts simultanément par un script
+#define MAX_LIGNE_SCRIPT 1024
+#define MAX_ATTENTES_SCRIPT 64 //opérations asynchrones en vol d'un script
+#define MOTIF_DEFAUT -1 //'a' + i % 26
+
+enum { CMD_FORMAT, CMD_MOUNT, CMD_OPEN, CMD_CLOSE, CMD_WRITE, CMD_READ, CMD_SEEK, CMD_FLUSH,
+       CMD_TRUNCATE, CMD_DELETE, CMD_COPY, CMD_CLONE, CMD_SNAPSHOT, CMD_SYNC, CMD_STATS, CMD_TRACE,
+       CMD_EXPORT, CMD_DEFRAG, CMD_EXPECT, CMD_SIZE, CMD_AWRITE, CMD_AREAD, CMD_WAIT, CMD_ENGINE,
+       CMD_JOURNAL, CMD_OPENSNAPSHOT, CMD_DROPSNAPSHOT, CMD_PAUSE, CMD_CRASH, NB_COMMANDES };
+
+static const char* nomsCommandes[NB_COMMANDES] = {"format", "mount", "open", "close", "write", "read",
+    "seek", "flush", "truncate", "delete", "copy", "clone", "snapshot", "sync", "stats", "trace", "export", "defrag",
+    "expect", "size", "awrite", "aread", "wait", "engine", "journal", "opensnapshot", "dropsnapshot", "pause", "crash"};
+
+//statistiques cumulées d'une commande pour le résumé final
+typedef struct statsCommande{
+    long nb;
+    long erreurs;
+    long octets;
+    long dureeTotale; //ns
+    long dureeMax; //ns
+}statsCommande;
+
+//opération asynchrone en vol, vérifiée par wait
+typedef struct attenteScript{
+    int jeton;
+    char* buffer; //tampon d'une lecture, NULL pour une écriture
+    int octets; //octets attendus
+    int motif;
+}attenteScript;
+
+//état du rejeu : partition montée et fichiers ouverts par nom
+typedef struct etatScript{
+    partition* part;
+    char noms[MAX_FICHIERS_SCRIPT][MAX_LEN_NAME];
+    file* fichiers[MAX_FICHIERS_SCRIPT];
+    char* buffer; //buffer des écritures
+    int tailleBuffer;
+    int motifBuffer; //motif du buffer des écritures (MOTIF_DEFAUT ou un caractère)
+    char* lecture; //buffer des lectures
+    int tailleLecture;
+    attenteScript attentes[MAX_ATTENTES_SCRIPT];
+    int nbAttentes;
+}etatScript;
+
+static long horloge(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long)t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+static int chercherFichierScript(etatScript* e, const char* nom) {
+    for (int i = 0; i < MAX_FICHIERS_SCRIPT; i++)
+        if (e->fichiers[i] != NULL && strcmp(e->noms[i], nom) == 0)
+            return i;
+    return -1;
+}
+
+static void fermerFichiersScript(etatScript* e) {
+    for (int i = 0; i < MAX_FICHIERS_SCRIPT; i++) {
+        myClose(e->fichiers[i]);
+        e->fichiers[i] = NULL;
+    }
+}
+
+//le motif d'un argument du script : nul pour '\0', sinon son premier caractère
+static int lireMotif(char args[][MAX_LEN_NAME], int nbArgs, int indice) {
+    if (nbArgs <= indice) return MOTIF_DEFAUT;
+    return strcmp(args[indice], "nul") == 0 ? 0 : (unsigned char)args[indice][0];
+}
+
+static char octetMotif(int motif, int i) {
+    return motif == MOTIF_DEFAUT ? 'a' + i % 26 : (char)motif;
+}
+
+//agrandit le buffer des écritures si besoin (rempli de son motif)
+static int reserverBuffer(etatScript* e, int taille) {
+    if (taille <= e->tailleBuffer) return 0;
+    char* nouveau = realloc(e->buffer, taille);
+    if (nouveau == NULL) return ERROR_OTHER;
+    for (int i = e->tailleBuffer; i < taille; i++) nouveau[i] = octetMotif(e->motifBuffer, i);
+    e->buffer = nouveau;
+    e->tailleBuffer = taille;
+    return 0;
+}
+
+//agrandit le buffer des lectures si besoin
+static int reserverLecture(etatScript* e, int taille) {
+    if (taille <= e->tailleLecture) return 0;
+    char* nouveau = realloc(e->lecture, taille);
+    if (nouveau == NULL) return ERROR_OTHER;
+    e->lecture = nouveau;
+    e->tailleLecture = taille;
+    return 0;
+}
+
+//remplit le buffer des écritures d'un motif (seulement s'il en suit un autre : le rejeu reste rapide)
+static int remplirBuffer(etatScript* e, int taille, int motif) {
+    if (reserverBuffer(e, taille) < 0) return ERROR_OTHER;
+    if (e->motifBuffer != motif) {
+        for (int i = 0; i < e->tailleBuffer; i++) e->buffer[i] = octetMotif(motif, i);
+        e->motifBuffer = motif;
+    }
+    return 0;
+}
+
+//vérifie que n octets lus suivent le motif
+static int verifierMotif(const char* buffer, int n, int motif) {
+    for (int i = 0; i < n; i++)
+        if (buffer[i] != octetMotif(motif, i)) {
+            fprintf(stderr, "contenu inattendu à l'octet %d : %d au lieu de %d\n", i, buffer[i], octetMotif(motif, i));
+            return ERROR_OTHER;
+        }
+    return 0;
+}
+
+//attend les opérations asynchrones du script et vérifie leurs résultats
+static int attendreScript(etatScript* e) {
+    int ret = 0;
+    for (int i = 0; i < e->nbAttentes; i++) {
+        attenteScript* a = &e->attentes[i];
+        int n = myWait(e->part, a->jeton);
+        if (n != a->octets || (a->buffer != NULL && verifierMotif(a->buffer, n, a->motif) < 0))
+            ret = n < 0 ? n : ERROR_OTHER;
+        free(a->buffer);
+    }
+    e->nbAttentes = 0;
+    return ret;
+}
+
+/**
+ * @brief Exécute une commande du script.
+ *
+ * @param e L'état du rejeu.
+ * @param cmd La commande (CMD_*).
+ * @param args Les arguments de la commande (au plus 3).
+ * @param nbArgs Le nombre d'arguments.
+ * @param octets Reçoit le nombre d'octets transférés (write / read).
+ * @return Une valeur positive ou nulle en cas de succès, un code d'erreur négatif sinon.
+ */
+static int executerCommande(etatScript* e, int cmd, char args[][MAX_LEN_NAME], int nbArgs, long* octets) {
+    int i, n;
+    *octets = 0;
+    if (cmd != CMD_FORMAT && cmd != CMD_MOUNT && e->part == NULL) return ERROR_OTHER;
+    switch (cmd) {
+        case CMD_FORMAT:
+        case CMD_MOUNT:
+            if (nbArgs < 1) return ERROR_OTHER;
+            if (e->part != NULL) attendreScript(e);
+            fermerFichiersScript(e);
+            if (e->part != NULL && myUnmount(e->part) < 0) return ERROR_WRITE;
+            e->part = NULL;
+            if (cmd == CMD_FORMAT && myFormat(args[0], nbArgs > 1 ? atoi(args[1]) : 0) < 0) return ERROR_OTHER;
+            e->part = myMount(args[0], (cmd == CMD_MOUNT && nbArgs > 1 && strcmp(args[1], "mmap") == 0) ? BACKEND_MMAP : BACKEND_RW);
+            return e->part == NULL ? ERROR_OPEN : 0;
+        case CMD_OPEN:
+            if (nbArgs < 1) return ERROR_OTHER;
+            if (chercherFichierScript(e, args[0]) >= 0) return 0;
+            for (i = 0; i < MAX_FICHIERS_SCRIPT && e->fichiers[i] != NULL; i++);
+            if (i == MAX_FICHIERS_SCRIPT) return ERROR_OPEN;
+            e->fichiers[i] = myOpen(e->part, args[0]);
+            if (e->fichiers[i] == NULL) return ERROR_OPEN;
+            strcpy(e->noms[i], args[0]);
+            return 0;
+        case CMD_DELETE:
+            if (nbArgs < 1) return ERROR_OTHER;
+            //le fichier supprimé ne doit pas rester ouvert
+            if ((i = chercherFichierScript(e, args[0])) >= 0) {
+                myClose(e->fichiers[i]);
+                e->fichiers[i] = NULL;
+            }
+            return myDelete(e->part, args[0]);
+        case CMD_COPY:
+        case CMD_CLONE:
+            if (nbArgs < 2) return ERROR_OTHER;
+            if ((i = chercherFichierScript(e, args[0])) >= 0 && myFlush(e->fichiers[i]) < 0) return ERROR_WRITE;
+            if ((i = chercherFichierScript(e, args[1])) >= 0) {
+                myClose(e->fichiers[i]); //la copie remplace le fichier ouvert
+                e->fichiers[i] = NULL;
+            }
+            return cmd == CMD_CLONE ? myClone(e->part, args[0], args[1]) : myCopy(e->part, args[0], args[1]);
+        case CMD_SNAPSHOT:
+            if (nbArgs < 1) return ERROR_OTHER;
+            for (i = 0; i < MAX_FICHIERS_SCRIPT; i++)
+                if (e->fichiers[i] != NULL && myFlush(e->fichiers[i]) < 0) return ERROR_WRITE;
+            return mySnapshot(e->part, args[0]);
+        case CMD_SYNC:
+            return mySync(e->part);
+        case CMD_STATS:
+            if (nbArgs == 0) {
+                afficherStats("Compteurs de la partition", myStats(e->part));
+                afficherLatences(e->part);
+                myResetStats(e->part);
+                return 0;
+            }
+            if ((i = chercherFichierScript(e, args[0])) < 0) return ERROR_OTHER;
+            afficherStats(args[0], myStatsFile(e->fichiers[i]));
+            myResetStatsFile(e->fichiers[i]);
+            return 0;
+        case CMD_TRACE:
+            if (nbArgs < 1) return ERROR_OTHER;
+            if (strcmp(args[0], "off") == 0) return configurerTrace(e->part, false, 0);
+            return configurerTrace(e->part, true, atoi(args[0]));
+        case CMD_EXPORT:
+            if (nbArgs < 1) return ERROR_OTHER;
+            return exporterTrace(e->part, args[0], nbArgs > 1 && strcmp(args[1], "chrome") == 0 ? FORMAT_TRACE_CHROME : FORMAT_TRACE_TEXTE);
+        case CMD_DEFRAG:
+            if (nbArgs < 1) return ERROR_OTHER;
+            if ((i = chercherFichierScript(e, args[0])) >= 0 && myFlush(e->fichiers[i]) < 0) return ERROR_WRITE;
+            return myDefrag(e->part, args[0], NULL, NULL);
+        case CMD_WAIT:
+            return attendreScript(e);
+        case CMD_ENGINE:
+            if (nbArgs < 1) return ERROR_OTHER;
+            return configurerMoteur(e->part, strcmp(args[0], "uring") == 0 ? MOTEUR_URING
+                                    : strcmp(args[0], "threads") == 0 ? MOTEUR_THREADS : MOTEUR_AUCUN);
+        case CMD_JOURNAL:
+            if (nbArgs < 2) return ERROR_OTHER;
+            return configurerJournal(e->part, strtoul(args[0], NULL, 10), atoi(args[1]));
+        case CMD_OPENSNAPSHOT:
+            if (nbArgs < 2 || strlen(args[0]) + strlen(args[1]) + 2 > MAX_LEN_NAME) return ERROR_OTHER;
+            for (i = 0; i < MAX_FICHIERS_SCRIPT && e->fichiers[i] != NULL; i++);
+            if (i == MAX_FICHIERS_SCRIPT) return ERROR_OPEN;
+            e->fichiers[i] = myOpenSnapshot(e->part, args[0], args[1]);
+            if (e->fichiers[i] == NULL) return ERROR_OPEN;
+            //désigné par <nom>:<fichier>
+            strcpy(e->noms[i], args[0]);
+            strcat(e->noms[i], ":");
+            strcat(e->noms[i], args[1]);
+            return 0;
+        case CMD_DROPSNAPSHOT:
+            if (nbArgs < 1) return ERROR_OTHER;
+            return myDropSnapshot(e->part, args[0]);
+        case CMD_PAUSE:
+            if (nbArgs < 1 || (n = atoi(args[0])) < 0) return ERROR_OTHER;
+            struct timespec duree = {n / 1000, (long)(n % 1000) * 1000000L};
+            nanosleep(&duree, NULL);
+            return 0;
+        default:
+            break;
+    }
+
+    //commandes portant sur un fichier ouvert
+    if (nbArgs < 1 || (i = chercherFichierScript(e, args[0])) < 0) return ERROR_OTHER;
+    file* f = e->fichiers[i];
+    switch (cmd) {
+        case CMD_CLOSE:
+            myClose(f);
+            e->fichiers[i] = NULL;
+            return 0;
+        case CMD_WRITE:
+            if (nbArgs < 2 || (n = atoi(args[1])) < 0 || remplirBuffer(e, n, lireMotif(args, nbArgs, 2)) < 0) return ERROR_OTHER;
+            n = myWrite(f, e->buffer, n);
+            if (n > 0) *octets = n;
+            return n;
+        case CMD_READ:
+        case CMD_EXPECT:
+            if (nbArgs < 2 || (n = atoi(args[1])) < 0 || reserverLecture(e, n) < 0) return ERROR_OTHER;
+            int attendus = n;
+            n = myRead(f, e->lecture, n);
+            if (n > 0) *octets = n;
+            if (cmd == CMD_EXPECT && n >= 0 && (n != attendus || verifierMotif(e->lecture, n, lireMotif(args, nbArgs, 2)) < 0)) {
+                if (n != attendus) fprintf(stderr, "%d octets lus au lieu de %d\n", n, attendus);
+                return ERROR_OTHER;
+            }
+            return n;
+        case CMD_SIZE: {
+            if (nbArgs < 2) return ERROR_OTHER;
+            int pos = f->pos;
+            mySeek(f, 0, SEEK_END);
+            int taille = f->pos;
+            mySeek(f, pos, SEEK_SET);
+            if (taille != atoi(args[1])) {
+                fprintf(stderr, "taille %d au lieu de %s\n", taille, args[1]);
+                return ERROR_OTHER;
+            }
+            return 0;
+        }
+        case CMD_AWRITE:
+        case CMD_AREAD: {
+            if (nbArgs < 2 || (n = atoi(args[1])) < 0 || e->nbAttentes == MAX_ATTENTES_SCRIPT) return ERROR_OTHER;
+            attenteScript* a = &e->attentes[e->nbAttentes];
+            a->octets = n;
+            a->motif = lireMotif(args, nbArgs, 2);
+            a->buffer = NULL;
+            if (cmd == CMD_AWRITE) {
+                //myWriteAsync copie les données : le buffer des écritures reste réutilisable
+                if (remplirBuffer(e, n, a->motif) < 0) return ERROR_OTHER;
+                a->jeton = myWriteAsync(f, e->buffer, n);
+            } else {
+                if ((a->buffer = malloc(n > 0 ? n : 1)) == NULL) return ERROR_OTHER;
+                a->jeton = myReadAsync(f, a->buffer, n);
+            }
+            if (a->jeton < 0) {
+                free(a->buffer);
+                return a->jeton;
+            }
+            e->nbAttentes++;
+            *octets = n;
+            return 0;
+        }
+        case CMD_SEEK:
+            if (nbArgs < 3) return ERROR_OTHER;
+            int base = strcmp(args[2], "SET") == 0 ? SEEK_SET : strcmp(args[2], "CUR") == 0 ? SEEK_CUR
+                     : strcmp(args[2], "END") == 0 ? SEEK_END : atoi(args[2]);
+            if (base != SEEK_SET && base != SEEK_CUR && base != SEEK_END) return ERROR_LSEEK;
+            mySeek(f, atoi(args[1]), base);
+            return f->pos;
+        case CMD_FLUSH:
+            return myFlush(f);
+        case CMD_TRUNCATE:
+            if (nbArgs < 2) return ERROR_OTHER;
+            return myTruncate(f, atoi(args[1]));
+        default:
+            return ERROR_OTHER;
+    }
+}
+
+/**
+ * @brief Rejoue un script de commandes sans interaction, aussi vite que possible.
+ *
+ * Chaque ligne est exécutée dans l'ordre ; une commande en erreur (ou réussie alors que '!' attendait
+ * son échec) est comptée puis le rejeu continue. Un résumé par commande (nombre, erreurs, octets,
+ * durées) est affiché à la fin. La commande crash termine le processus sans démonter la partition :
+ * un script suivant la remonte pour vérifier ce qu'un arrêt brutal laisse sur le support.
+ *
+ * @param script Le flux du script (fichier ou stdin).
+ * @param chronometrer 1 pour afficher la durée de chaque commande.
+ * @return 0 si toutes les commandes ont réussi, ERROR_OTHER sinon.
+ */
+static int rejouerScript(FILE* script, int chronometrer) {
+    etatScript e = {0};
+    e.motifBuffer = MOTIF_DEFAUT;
+    statsCommande stats[NB_COMMANDES] = {{0}};
+    char ligne[MAX_LIGNE_SCRIPT];
+    char mot[16];
+    char args[3][MAX_LEN_NAME];
+    long numLigne = 0, nbErreurs = 0;
+    long debutRejeu = horloge();
+
+    while (fgets(ligne, sizeof(ligne), script) != NULL) {
+        numLigne++;
+        ligne[strcspn(ligne, "#\n")] = '\0';
+        int nbMots = sscanf(ligne, "%15s %254s %254s %254s", mot, args[0], args[1], args[2]);
+        if (nbMots < 1) continue; //ligne vide ou commentaire
+        bool echecAttendu = mot[0] == '!';
+        char* nom = echecAttendu ? mot + 1 : mot;
+        int cmd;
+        for (cmd = 0; cmd < NB_COMMANDES && strcmp(nom, nomsCommandes[cmd]) != 0; cmd++);
+        if (cmd == NB_COMMANDES) {
+            fprintf(stderr, "ligne %ld : commande inconnue '%s'\n", numLigne, mot);
+            nbErreurs++;
+            continue;
+        }
+        if (cmd == CMD_CRASH) {
+            //ni démontage ni vidage : la partition reste dans l'état d'un arrêt brutal
+            printf("arrêt brutal à la ligne %ld, %ld erreur(s)\n", numLigne, nbErreurs);
+            fflush(stdout);
+            _exit(nbErreurs == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+
+        long octets;
+        long debut = horloge();
+        int ret = executerCommande(&e, cmd, args, nbMots - 1, &octets);
+        long duree = horloge() - debut;
+
+        stats[cmd].nb++;
+        stats[cmd].octets += octets;
+        stats[cmd].dureeTotale += duree;
+        if (duree > stats[cmd].dureeMax) stats[cmd].dureeMax = duree;
+        if (ret < 0 && !echecAttendu) {
+            stats[cmd].erreurs++;
+            nbErreurs++;
+            fprintf(stderr, "ligne %ld : '%s' a échoué (%d)\n", numLigne, mot, ret);
+        } else if (ret >= 0 && echecAttendu) {
+            stats[cmd].erreurs++;
+            nbErreurs++;
+            fprintf(stderr, "ligne %ld : '%s' a réussi alors qu'un échec était attendu\n", numLigne, nom);
+        }
+        if (chronometrer)
+            printf("%ld\t%s\t%d\t%.3f us\n", numLigne, mot, ret, duree / 1e3);
+    }
+    if (e.part != NULL && attendreScript(&e) < 0) nbErreurs++;
+    fermerFichiersScript(&e);
+    if (e.part != NULL && myUnmount(e.part) < 0) nbErreurs++;
+    free(e.buffer);
+    free(e.lecture);
+    double dureeRejeu = (horloge() - debutRejeu) / 1e9;
+
+    //résumé
+    long nbTotal = 0;
+    printf("\n%-10s %10s %8s %14s %12s %12s %12s\n", "commande", "nombre", "erreurs", "octets",
+           "total (ms)", "moyen (us)", "max (us)");
+    for (int cmd = 0; cmd < NB_COMMANDES; cmd++) {
+        if (stats[cmd].nb == 0) continue;
+        nbTotal += stats[cmd].nb;
+        printf("%-10s %10ld %8ld %14ld %12.3f %12.3f %12.3f\n", nomsCommandes[cmd], stats[cmd].nb,
+               stats[cmd].erreurs, stats[cmd].octets, stats[cmd].dureeTotale / 1e6,
+               stats[cmd].dureeTotale / 1e3 / stats[cmd].nb, stats[cmd].dureeMax / 1e3);
+    }
+    printf("%ld commandes en %.3f s (%.0f commandes/s), %ld erreur(s)\n", nbTotal, dureeRejeu,
+           dureeRejeu > 0 ? nbTotal / dureeRejeu : 0.0, nbErreurs);
+    return nbErreurs == 0 ? 0 : ERROR_OTHER;
+}
+
 /*******************************************************************/
 
-int main()
+/*
+ * Usage : projetos                      menu interactif
+ *         projetos -b [-t] [script]     rejoue un script (stdin si absent ou "-"),
+ *                                       -t affiche la durée de chaque commande
+ */
+int main(int argc, char* argv[])
 {
-    fd=-1;
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        int chronometrer = argc > 2 && strcmp(argv[2], "-t") == 0;
+        int arg = 2 + chronometrer;
+        FILE* script = stdin;
+        if (arg < argc && strcmp(argv[arg], "-") != 0 && (script = fopen(argv[arg], "r")) == NULL) {
+            perror("Erreur d'ouverture du script");
+            return EXIT_FAILURE;
+        }
+        int ret = rejouerScript(script, chronometrer);
+        if (script != stdin) fclose(script);
+        return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    partition* part = NULL; //partition montée
     int action;
-    file* f= malloc(sizeof(file)); //va contenir le fichier
+    file* f= NULL; //va contenir le fichier
     char fileName[MAX_LEN_NAME]; //va contenir le nom du fichier recemment ouvert
     int nbBytes; //stockes le nombre d'octets lu/ecrits
     char partitionName[MAX_LEN_NAME];
@@ -22,7 +504,14 @@ int main()
            "2-Ecriture dans un fichier\n"
            "3-Lecture d'un fichier\n"
            "4-Deplacement dans un fichier\n"
-           "5-Quitter le programme\n");
+           "5-Quitter le programme\n"
+           "6-Suppression d'un fichier\n"
+           "7-Troncature du fichier ouvert\n"
+           "8-Copie / clone d'un fichier\n"
+           "9-Instantané de la partition\n"
+           "10-Statistiques d'instrumentation\n"
+           "11-Chronométrage des opérations\n"
+           "12-Défragmentation d'un fichier\n");
 
         scanf("%d", &action);
 
@@ -35,15 +524,28 @@ int main()
                 fgets(partitionName, sizeof(partitionName), stdin);
                 partitionName[strcspn(partitionName, "\n")] = '\0';
                 printf("Nom de la partition : %s\n",partitionName);
-                if (myFormat(partitionName)==-1) {
+                int tailleBloc;
+                printf("Veuillez saisir la taille des blocs en octets (puissance de 2 entre %d et %d, 0 pour %d) :\n",
+                       TAILLE_BLOC_MIN,TAILLE_BLOC_MAX,TAILLE_BLOC_DEFAUT);
+                scanf("%d",&tailleBloc);
+                if (myFormat(partitionName,tailleBloc)<0) {
                     printf("\nErreur myFormat..");
                     exit(ERROR_OTHER);
+                }
+                //monter la partition formattée (en remplacement de la precedente)
+                myClose(f);
+                f=NULL;
+                closePartition(part);
+                part=myMount(partitionName, BACKEND_RW);
+                if (part==NULL) {
+                    printf("\nErreur myMount..");
+                    exit(ERROR_OTHER);
                 }
                  printf("FIN formattage\n*--------------------------******--------------------------------*\n");
                 break;
             case 1:
                 printf("\033[2J\033[H");
-                if (fd==-1 || fd==-1) {
+                if (part==NULL) {
                     printf("! Veuillez formatter d'abord une partition ! \n");
                     break;
                 }
@@ -52,7 +554,8 @@ int main()
                 getchar(); //effacer le buffer de lecture
                 fgets(fileName,sizeof(fileName),stdin);
                 fileName[strcspn(fileName, "\n")] = '\0';
-                f=myOpen(fileName);
+                myClose(f); //fermer le fichier precedemment ouvert
+                f=myOpen(part,fileName);
                 if (f==NULL){
                     printf("\nErreur myOpen..");
                     exit(ERROR_OTHER);
@@ -67,7 +570,7 @@ int main()
                 break;
             case 2:
                 printf("\033[2J\033[H");
-                if (f==NULL || fd==-1) {
+                if (f==NULL || part==NULL) {
                     printf("! Impossible d'écrire, veuillez ouvrir d'abord un fichier !\n");
                     break;
                 }
@@ -88,7 +591,7 @@ int main()
                 break;
             case 3:
                 printf("\033[2J\033[H");
-                if (f==NULL || fd==-1) {
+                if (f==NULL || part==NULL) {
                     printf("! Impossible de lire, veuillez ouvrir d'abord un fichier !\n");
                     break;
                 }
@@ -103,10 +606,10 @@ int main()
                 nbBytes=myRead(f,donneeRead,nbOcts);
                 //affichage
                 printf("-Donnée lue : \n");
-                for (int i=0;i<nbOcts;i++){
+                for (int i=0;i<nbBytes;i++){
                     printf("%c",((char*)donneeRead)[i]);
                 }
-                printf("\n\n* %d octets lus avec succés\n",nbOcts);
+                printf("\n\n* %d octets lus avec succés\n",nbBytes);
                 printf("* Position actuelle dans le fichier : %d\n",f->pos);
                 free(donneeRead); //liberer espace memoire
                 printf("FIN lecture\n*--------------------------******--------------------------------*\n");
@@ -114,7 +617,7 @@ int main()
             case 4:
                 printf("\033[2J\033[H");
                 getchar(); //effacer le buffer de lecture
-                if (f==NULL || fd==-1) {
+                if (f==NULL || part==NULL) {
                     printf("! Impossible de se deplacer, veuillez ouvrir d'abord un fichier !\n");
                     break;
                 }
@@ -140,9 +643,191 @@ int main()
                 printf("\nVous allez quitter le programme.. À bientôt! ");
                 //liberer espace
                 myClose(f); //fermer le fichier
-                closePartition(f->fd);
+                closePartition(part);
                 //quitter
                 exit(0);
+            case 6:
+                printf("\033[2J\033[H");
+                if (part==NULL) {
+                    printf("! Veuillez formatter d'abord une partition ! \n");
+                    break;
+                }
+                char nomSupprime[MAX_LEN_NAME];
+                printf("\n Bienvenue dans MyDelete !! vous allez supprimer un fichier de la partition.\n");
+                printf("Veuillez saisir le nom du fichier à supprimer : ");
+                getchar(); //effacer le buffer de lecture
+                fgets(nomSupprime,sizeof(nomSupprime),stdin);
+                nomSupprime[strcspn(nomSupprime, "\n")] = '\0';
+                if (f!=NULL && strcmp(nomSupprime,fileName)==0) {
+                    myClose(f); //le fichier supprimé ne doit pas rester ouvert
+                    f=NULL;
+                }
+                if (myDelete(part,nomSupprime)<0)
+                    printf("! Le fichier '%s' n'a pas pu être supprimé.\n",nomSupprime);
+                else
+                    printf("Fichier '%s' supprimé, son espace sera réutilisé.\n",nomSupprime);
+                printf("FIN suppression\n*--------------------------******--------------------------------*\n");
+                break;
+            case 7:
+                printf("\033[2J\033[H");
+                if (f==NULL || part==NULL) {
+                    printf("! Impossible de tronquer, veuillez ouvrir d'abord un fichier !\n");
+                    break;
+                }
+                int nouvelleTaille;
+                printf("\n Bienvenue dans MyTruncate !! vous allez modifier la taille du fichier '%s'.\n",fileName);
+                printf("Veuillez saisir la nouvelle taille : ");
+                scanf("%d",&nouvelleTaille);
+                if (myTruncate(f,nouvelleTaille)<0)
+                    printf("! Troncature impossible.\n");
+                else
+                    printf("* Nouvelle taille du fichier : %d\n",getSizeReelFile(f));
+                printf("FIN troncature\n*--------------------------******--------------------------------*\n");
+                break;
+            case 8:
+                printf("\033[2J\033[H");
+                if (part==NULL) {
+                    printf("! Veuillez formatter d'abord une partition ! \n");
+                    break;
+                }
+                char nomSource[MAX_LEN_NAME];
+                char nomCopie[MAX_LEN_NAME];
+                int clone;
+                printf("\n Bienvenue dans MyCopy / MyClone !! vous allez copier un fichier de la partition.\n");
+                printf("Veuillez saisir le nom du fichier à copier : ");
+                getchar(); //effacer le buffer de lecture
+                fgets(nomSource,sizeof(nomSource),stdin);
+                nomSource[strcspn(nomSource, "\n")] = '\0';
+                printf("Veuillez saisir le nom de la copie : ");
+                fgets(nomCopie,sizeof(nomCopie),stdin);
+                nomCopie[strcspn(nomCopie, "\n")] = '\0';
+                printf("0-Copie des blocs, 1-Clone (blocs partagés, copiés sur écriture) : ");
+                scanf("%d",&clone);
+                if (f!=NULL && strcmp(nomSource,fileName)==0)
+                    myFlush(f); //la source doit etre à jour
+                if (f!=NULL && strcmp(nomCopie,fileName)==0) {
+                    myClose(f); //la copie remplace le fichier ouvert
+                    f=NULL;
+                }
+                if ((clone ? myClone(part,nomSource,nomCopie) : myCopy(part,nomSource,nomCopie))<0)
+                    printf("! Le fichier '%s' n'a pas pu être copié.\n",nomSource);
+                else
+                    printf("Fichier '%s' copié dans '%s'.\n",nomSource,nomCopie);
+                printf("FIN copie\n*--------------------------******--------------------------------*\n");
+                break;
+            case 9:
+                printf("\033[2J\033[H");
+                if (part==NULL) {
+                    printf("! Veuillez formatter d'abord une partition ! \n");
+                    break;
+                }
+                char nomInstantane[MAX_LEN_NAME];
+                int supprimer;
+                printf("\n Bienvenue dans MySnapshot !! vous allez créer ou supprimer un instantané de la partition.\n");
+                printf("0-Création, 1-Suppression : ");
+                scanf("%d",&supprimer);
+                printf("Veuillez saisir le nom de l'instantané : ");
+                getchar(); //effacer le buffer de lecture
+                fgets(nomInstantane,sizeof(nomInstantane),stdin);
+                nomInstantane[strcspn(nomInstantane, "\n")] = '\0';
+                if (supprimer) {
+                    if (myDropSnapshot(part,nomInstantane)<0)
+                        printf("! L'instantané '%s' n'a pas pu être supprimé.\n",nomInstantane);
+                    else
+                        printf("Instantané '%s' supprimé, ses blocs propres seront réutilisés.\n",nomInstantane);
+                } else {
+                    if (f!=NULL)
+                        myFlush(f); //le fichier ouvert doit figurer à jour dans l'instantané
+                    if (mySnapshot(part,nomInstantane)<0)
+                        printf("! L'instantané '%s' n'a pas pu être créé.\n",nomInstantane);
+                    else
+                        printf("Instantané '%s' créé.\n",nomInstantane);
+                }
+                printf("FIN instantané\n*--------------------------******--------------------------------*\n");
+                break;
+            case 10:
+                printf("\033[2J\033[H");
+                if (part==NULL) {
+                    printf("! Veuillez formatter d'abord une partition ! \n");
+                    break;
+                }
+                int remiseAZero;
+                printf("\n Bienvenue dans MyStats !! vous allez consulter les compteurs d'instrumentation.\n");
+                afficherStats("Compteurs de la partition",myStats(part));
+                afficherLatences(part);
+                if (f!=NULL)
+                    afficherStats(fileName,myStatsFile(f));
+                printf("Remettre les compteurs à zéro ? (0-Non, 1-Oui) : ");
+                scanf("%d",&remiseAZero);
+                if (remiseAZero) {
+                    myResetStats(part);
+                    myResetStatsFile(f);
+                }
+                printf("FIN statistiques\n*--------------------------******--------------------------------*\n");
+                break;
+            case 11:
+                printf("\033[2J\033[H");
+                if (part==NULL) {
+                    printf("! Veuillez formatter d'abord une partition ! \n");
+                    break;
+                }
+                int choixTrace;
+                printf("\n Bienvenue dans le chronométrage !! les opérations myOpen, myRead, myWrite et mySeek peuvent être chronométrées.\n");
+                printf("0-Activation, 1-Désactivation, 2-Export des opérations les plus lentes : ");
+                scanf("%d",&choixTrace);
+                if (choixTrace==0) {
+                    int nbLentes;
+                    printf("Nombre d'opérations les plus lentes à conserver : ");
+                    scanf("%d",&nbLentes);
+                    if (configurerTrace(part,true,nbLentes)<0)
+                        printf("! Activation impossible.\n");
+                    else
+                        printf("Chronométrage activé.\n");
+                } else if (choixTrace==1) {
+                    configurerTrace(part,false,0);
+                    printf("Chronométrage désactivé.\n");
+                } else {
+                    char nomTrace[MAX_LEN_NAME];
+                    int formatTrace;
+                    printf("Veuillez saisir le nom du fichier de trace : ");
+                    getchar(); //effacer le buffer de lecture
+                    fgets(nomTrace,sizeof(nomTrace),stdin);
+                    nomTrace[strcspn(nomTrace, "\n")] = '\0';
+                    printf("0-Texte, 1-Chrome (chrome://tracing) : ");
+                    scanf("%d",&formatTrace);
+                    int nbExportes=exporterTrace(part,nomTrace,formatTrace ? FORMAT_TRACE_CHROME : FORMAT_TRACE_TEXTE);
+                    if (nbExportes<0)
+                        printf("! Export impossible.\n");
+                    else
+                        printf("%d opérations écrites dans '%s'.\n",nbExportes,nomTrace);
+                }
+                printf("FIN chronométrage\n*--------------------------******--------------------------------*\n");
+                break;
+            case 12:
+                printf("\033[2J\033[H");
+                if (part==NULL) {
+                    printf("! Veuillez formatter d'abord une partition ! \n");
+                    break;
+                }
+                char nomDefrag[MAX_LEN_NAME];
+                fragmentation avant, apres;
+                printf("\n Bienvenue dans MyDefrag !! vous allez rendre contigus les blocs d'un fichier de la partition.\n");
+                printf("Veuillez saisir le nom du fichier à défragmenter : ");
+                getchar(); //effacer le buffer de lecture
+                fgets(nomDefrag,sizeof(nomDefrag),stdin);
+                nomDefrag[strcspn(nomDefrag, "\n")] = '\0';
+                if (f!=NULL)
+                    myFlush(f); //le fichier ouvert peut être celui à défragmenter
+                if (myDefrag(part,nomDefrag,&avant,&apres)<0) {
+                    printf("! Le fichier '%s' n'a pas pu être défragmenté.\n",nomDefrag);
+                } else {
+                    printf("* Blocs alloués : %d%s\n",avant.nbBlocs,avant.partage ? " (partagés : non déplacés)" : "");
+                    printf("* Fragments : %d -> %d\n",avant.nbFragments,apres.nbFragments);
+                    printf("* Extents : %d -> %d\n",avant.nbExtents,apres.nbExtents);
+                    printf("* Etendue (en blocs) : %ld -> %ld\n",(long)avant.etendue,(long)apres.etendue);
+                }
+                printf("FIN défragmentation\n*--------------------------******--------------------------------*\n");
+                break;
             default:
                 break;
         }
@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "BIBLIO_PROJET_OS.h"
+
+/**
+ * @file migrer.c
+ * @brief Convertisseur hors ligne d'une partition à l'ancien format (cible `make migrer`).
+ *
+ * L'ancien format n'a pas de super bloc : la partition commence par un tableau d'index (le nombre
+ * de fichiers, puis NB_FICHIERS_ANCIEN_FORMAT éléments triés par nom). L'entête d'un fichier donne
+ * son premier bloc et son nombre de blocs ; ses données sont dans une chaîne de blocs de
+ * CHARS_PAR_BLOC_ANCIEN caractères, le dernier étant partiellement rempli. La partition n'est pas convertie sur place : une nouvelle
+ * partition est formatée et chaque fichier y est recopié (myOpen, myWrite). L'ancienne partition
+ * n'est pas modifiée.
+ *
+ * Les offsets, nombres de blocs et de caractères lus sont vérifiés : un fichier dont la chaîne est
+ * incohérente est signalé et recopié jusqu'au dernier bloc valide.
+ *
+ * Usage : migrer <ancienne partition> <nouvelle partition> [taille de bloc]
+ */
+
+#define CHARS_PAR_BLOC_ANCIEN 10 //caractères d'un bloc de données de l'ancien format
+
+/**
+ * @brief L'entête d'un fichier de l'ancien format.
+ */
+typedef struct ancienEntete{
+    char nomFichier[MAX_LEN_NAME]; //le nom du fichier
+    off_t numTete; //l'offset du premier bloc de données
+    int nbBlocs; //le nombre de blocs de données
+}ancienEntete;
+
+/**
+ * @brief Un bloc de données de l'ancien format.
+ */
+typedef struct ancienBloc{
+    int nbChars; //le nombre de caractères du bloc
+    char donnee[CHARS_PAR_BLOC_ANCIEN]; //les caractères
+    off_t suiv; //l'offset du bloc suivant, -1 pour le dernier
+}ancienBloc;
+
+/**
+ * @brief Le tableau d'index de l'ancien format, à l'offset 0 de la partition.
+ */
+typedef struct ancienIndex{
+    int nbFichiers; //le nombre d'éléments de tabIndex
+    elemTabIndex tabIndex[NB_FICHIERS_ANCIEN_FORMAT]; //les fichiers, triés par nom
+}ancienIndex;
+
+/**
+ * @brief Lit un fichier de l'ancien format en suivant sa chaîne de blocs.
+ *
+ * @param fd Le descripteur de l'ancienne partition.
+ * @param tailleAncienne La taille de l'ancienne partition (borne des offsets).
+ * @param offsetEntete L'offset de l'entête du fichier.
+ * @param taille En sortie, le nombre de caractères lus.
+ * @param complet En sortie, faux si la chaîne est incohérente (le contenu est alors tronqué).
+ * @return Le contenu du fichier (à libérer), NULL en cas d'erreur.
+ */
+static char* lireAncienFichier(int fd, off_t tailleAncienne, off_t offsetEntete, int* taille, bool* complet) {
+    ancienEntete be;
+    *taille = 0;
+    *complet = true;
+    if (offsetEntete < (off_t)sizeof(ancienIndex) || offsetEntete + (off_t)sizeof(ancienEntete) > tailleAncienne
+        || pread(fd, &be, sizeof(ancienEntete), offsetEntete) != sizeof(ancienEntete))
+        return NULL;
+
+    char* contenu = malloc((size_t)(be.nbBlocs > 0 ? be.nbBlocs : 1) * CHARS_PAR_BLOC_ANCIEN);
+    if (contenu == NULL)
+        return NULL;
+    off_t offset = be.nbBlocs > 0 ? be.numTete : -1;
+    //au plus nbBlocs blocs : une chaîne qui boucle s'arrête là
+    for (int i = 0; i < be.nbBlocs && offset != -1; i++) {
+        ancienBloc bloc;
+        if (offset < (off_t)sizeof(ancienIndex) || offset + (off_t)sizeof(ancienBloc) > tailleAncienne
+            || pread(fd, &bloc, sizeof(ancienBloc), offset) != sizeof(ancienBloc)
+            || bloc.nbChars < 0 || bloc.nbChars > CHARS_PAR_BLOC_ANCIEN) {
+            *complet = false;
+            break;
+        }
+        //un bloc intermédiaire compte en entier (un trou laissé par mySeek y vaut '\0') ; le dernier
+        //s'arrête après son nbChars-ième caractère non nul, comme la fin de fichier de l'ancien format
+        int fin = CHARS_PAR_BLOC_ANCIEN;
+        if (bloc.suiv == -1 || i == be.nbBlocs - 1) {
+            int count = 0;
+            for (fin = 0; count < bloc.nbChars && fin < CHARS_PAR_BLOC_ANCIEN; fin++)
+                if (bloc.donnee[fin] != '\0') count++;
+        }
+        memcpy(contenu + *taille, bloc.donnee, fin);
+        *taille += fin;
+        offset = bloc.suiv;
+    }
+    if (be.nbBlocs < 0 || offset != -1) *complet = false;
+    return contenu;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "Usage : %s <ancienne partition> <nouvelle partition> [taille de bloc]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int tailleBloc = argc == 4 ? atoi(argv[3]) : TAILLE_BLOC_DEFAUT;
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        perror("Erreur d'ouverture de l'ancienne partition");
+        return EXIT_FAILURE;
+    }
+    ancienIndex* index = malloc(sizeof(ancienIndex));
+    if (index == NULL || pread(fd, index, sizeof(ancienIndex), 0) != sizeof(ancienIndex)
+        || index->nbFichiers < 0 || index->nbFichiers > NB_FICHIERS_ANCIEN_FORMAT) {
+        fprintf(stderr, "%s n'est pas une partition à l'ancien format\n", argv[1]);
+        free(index);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    //la nouvelle partition ne doit pas exister : myFormat conserverait son contenu
+    struct stat stNouvelle;
+    if (stat(argv[2], &stNouvelle) == 0 || errno != ENOENT) {
+        fprintf(stderr, "La nouvelle partition %s existe déjà\n", argv[2]);
+        free(index);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    if (myFormat(argv[2], tailleBloc) < 0) {
+        free(index);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    partition* p = myMount(argv[2], BACKEND_RW);
+    if (p == NULL) {
+        fprintf(stderr, "Impossible de monter la partition %s\n", argv[2]);
+        free(index);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    int ret = EXIT_SUCCESS;
+    long octets = 0;
+    int nbCopies = 0;
+    for (int i = 0; i < index->nbFichiers; i++) {
+        elemTabIndex* e = &index->tabIndex[i];
+        e->nomFichier[MAX_LEN_NAME - 1] = '\0';
+        int taille;
+        bool complet;
+        char* contenu = lireAncienFichier(fd, st.st_size, e->numBlocEntete, &taille, &complet);
+        if (contenu == NULL) {
+            fprintf(stderr, "Entête illisible, fichier ignoré : %s\n", e->nomFichier);
+            ret = EXIT_FAILURE;
+            continue;
+        }
+        if (!complet) {
+            fprintf(stderr, "Chaîne de blocs incohérente, fichier tronqué à %d octets : %s\n", taille, e->nomFichier);
+            ret = EXIT_FAILURE;
+        }
+        file* f = myOpen(p, e->nomFichier);
+        if (f == NULL || (taille > 0 && myWrite(f, contenu, taille) != taille)) {
+            fprintf(stderr, "Erreur d'écriture du fichier %s\n", e->nomFichier);
+            ret = EXIT_FAILURE;
+        } else {
+            printf("%-24s %10d octets\n", e->nomFichier, taille);
+            octets += taille;
+            nbCopies++;
+        }
+        if (f != NULL) myClose(f);
+        free(contenu);
+    }
+    free(index);
+    close(fd);
+
+    if (myUnmount(p) < 0) {
+        fprintf(stderr, "Erreur de démontage de la partition\n");
+        return EXIT_FAILURE;
+    }
+    printf("\n%d fichier(s) recopié(s), %ld octets\n", nbCopies, octets);
+    return ret;
+}
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "BIBLIO_PROJET_OS.h"
+
+/**
+ * @file ancien.c
+ * @brief Écrit une partition à l'ancien format (tableau d'index et blocs chaînés), pour tester migrer.
+ *
+ * Le contenu est celui que vérifie tests/migrer.scr :
+ * - alphabet : 95 caractères 'a' + i % 26 (9 blocs pleins puis un bloc de 5 caractères) ;
+ * - trou : "XXX", 22 caractères nuls laissés par un mySeek, puis "YY" (27 caractères) ;
+ * - vide : aucun bloc.
+ *
+ * Usage : ancien <partition>
+ */
+
+#define CHARS_PAR_BLOC_ANCIEN 10 //comme dans migrer.c
+
+typedef struct ancienEntete{
+    char nomFichier[MAX_LEN_NAME];
+    off_t numTete;
+    int nbBlocs;
+}ancienEntete;
+
+typedef struct ancienBloc{
+    int nbChars;
+    char donnee[CHARS_PAR_BLOC_ANCIEN];
+    off_t suiv;
+}ancienBloc;
+
+typedef struct ancienIndex{
+    int nbFichiers;
+    elemTabIndex tabIndex[NB_FICHIERS_ANCIEN_FORMAT];
+}ancienIndex;
+
+//ajoute un fichier en fin de partition : son entête puis sa chaîne de blocs (les nuls sont des trous)
+static int ajouterFichier(int fd, ancienIndex* index, char* nom, const char* contenu, int taille) {
+    off_t fin = lseek(fd, 0, SEEK_END);
+    if (fin == -1) return ERROR_LSEEK;
+    ancienEntete be = {0};
+    strcpy(be.nomFichier, nom);
+    be.nbBlocs = (taille + CHARS_PAR_BLOC_ANCIEN - 1) / CHARS_PAR_BLOC_ANCIEN;
+    be.numTete = be.nbBlocs > 0 ? fin + (off_t)sizeof(ancienEntete) : -1;
+    if (pwrite(fd, &be, sizeof(ancienEntete), fin) != sizeof(ancienEntete)) return ERROR_WRITE;
+
+    for (int i = 0; i < be.nbBlocs; i++) {
+        ancienBloc bloc = {0};
+        off_t offset = be.numTete + (off_t)i * sizeof(ancienBloc);
+        for (int j = 0; j < CHARS_PAR_BLOC_ANCIEN && i * CHARS_PAR_BLOC_ANCIEN + j < taille; j++) {
+            bloc.donnee[j] = contenu[i * CHARS_PAR_BLOC_ANCIEN + j];
+            if (bloc.donnee[j] != '\0') bloc.nbChars++;
+        }
+        bloc.suiv = i + 1 < be.nbBlocs ? offset + (off_t)sizeof(ancienBloc) : -1;
+        if (pwrite(fd, &bloc, sizeof(ancienBloc), offset) != sizeof(ancienBloc)) return ERROR_WRITE;
+    }
+
+    //le tableau d'index est trié par nom : les fichiers sont ajoutés dans l'ordre
+    strcpy(index->tabIndex[index->nbFichiers].nomFichier, nom);
+    index->tabIndex[index->nbFichiers].numBlocEntete = fin;
+    index->nbFichiers++;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "Usage : %s <partition>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int fd = open(argv[1], O_CREAT | O_EXCL | O_RDWR, 0644);
+    ancienIndex* index = calloc(1, sizeof(ancienIndex));
+    if (fd == -1 || index == NULL || pwrite(fd, index, sizeof(ancienIndex), 0) != sizeof(ancienIndex)) {
+        perror("Erreur de création de la partition");
+        return EXIT_FAILURE;
+    }
+
+    char alphabet[95];
+    for (int i = 0; i < 95; i++) alphabet[i] = 'a' + i % 26;
+    char trou[27] = {0};
+    memset(trou, 'X', 3);
+    memset(trou + 25, 'Y', 2);
+    if (ajouterFichier(fd, index, "alphabet", alphabet, sizeof(alphabet)) < 0
+        || ajouterFichier(fd, index, "trou", trou, sizeof(trou)) < 0
+        || ajouterFichier(fd, index, "vide", NULL, 0) < 0
+        || pwrite(fd, index, sizeof(ancienIndex), 0) != sizeof(ancienIndex)) {
+        perror("Erreur d'écriture de la partition");
+        return EXIT_FAILURE;
+    }
+    free(index);
+    close(fd);
+    return EXIT_SUCCESS;
+}